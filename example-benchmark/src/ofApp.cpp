@@ -0,0 +1,852 @@
+#include "ofApp.h"
+#include "ofxAECompiler.h"
+#include "ofxAEAssetManager.h"
+#include "ofxAEKeyframe.h"
+#include "ofxAELayer.h"
+#include "ofxAEThreadPool.h"
+#include "ofxAEEvaluationStats.h"
+#include "ofxAETessellationCache.h"
+#include "ofxAESequenceSource.h"
+#include "ofxAEPrecompCache.h"
+#include "ofxAEFboPool.h"
+#include "ofxAEMask.h"
+#include "ofxAESoftwareRenderer.h"
+#include "ofxAEExporter.h"
+#include "ofxAEPixelReader.h"
+#include "ofxAECompressedTrack.h"
+#include "ofxAEEaseBatch.h"
+#include "ofxAEShapeSource.h"
+
+using namespace ofx::ae;
+
+//--------------------------------------------------------------
+void ofApp::setup(){
+	ofSetFrameRate(30);
+	ofBackground(32);
+	runBenchmarks();
+}
+
+//--------------------------------------------------------------
+void ofApp::update(){
+
+}
+
+//--------------------------------------------------------------
+void ofApp::draw(){
+	std::stringstream ss;
+	ss << "ofxAEPlayer benchmark: " << comp_path_ << std::endl
+	<< "R: run again" << std::endl << std::endl;
+	for(auto &&line : results_) {
+		ss << line << std::endl;
+	}
+	ofDrawBitmapString(ss.str(), 20, 20);
+}
+
+//--------------------------------------------------------------
+void ofApp::keyPressed(int key){
+	if(key == 'r') {
+		runBenchmarks();
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::runBenchmarks(){
+	results_.clear();
+	benchmarkArcLength();
+	benchmarkAssetKey();
+	benchmarkMasks();
+	if(!ofFile::doesFileExist(comp_path_)) {
+		addResult("composition not found: " + comp_path_);
+		return;
+	}
+	benchmarkLoad();
+	benchmarkSetFrame();
+	benchmarkParallelSetFrame();
+	benchmarkShapeDraw();
+	benchmarkBatchedDraw();
+	benchmarkAtlas();
+	benchmarkStreaming();
+	benchmarkAssetBudget();
+	benchmarkAsyncLoad();
+	benchmarkPrecompInstances();
+	benchmarkPrecompCache();
+	benchmarkFboPool();
+	benchmarkSoftwareRenderer();
+	benchmarkExport();
+	benchmarkReadback();
+	benchmarkTrackCompression();
+	benchmarkEaseBatch();
+	benchmarkShapeEvaluation();
+	benchmarkTransformExtraction();
+}
+
+//--------------------------------------------------------------
+void ofApp::addResult(const std::string &line){
+	ofLogNotice("benchmark") << line;
+	results_.push_back(line);
+}
+
+//--------------------------------------------------------------
+bool ofApp::loadFixture(const std::string &name, Fixture &fixture){
+	if(!fixture.comp.load(comp_path_)) {
+		addResult("[" + name + "] failed to load " + comp_path_);
+		return false;
+	}
+	fixture.frames = std::max<int>(1, fixture.comp.getFrameCount());
+	fixture.fbo.allocate(std::max(1.f, fixture.comp.getWidth()), std::max(1.f, fixture.comp.getHeight()), GL_RGBA);
+	return true;
+}
+
+//--------------------------------------------------------------
+void ofApp::Fixture::render(int frame){
+	comp.setFrame(frame);
+	comp.update();
+	fbo.begin();
+	ofClear(0,0);
+	comp.draw(0,0);
+	fbo.end();
+}
+
+//--------------------------------------------------------------
+// Cold load of a fresh Composition from JSON vs. from the compiled binary.
+// Textures stay cached in AssetManager so that only parsing/building the model is measured.
+void ofApp::benchmarkLoad(){
+	Compiler::Stats stats;
+	if(!Compiler::compile(comp_path_, compiled_path_, stats)) {
+		addResult("[load] failed to compile " + comp_path_);
+		return;
+	}
+	const int iterations = 20;
+	auto &assets = AssetManager::getInstance();
+	{
+		Composition warmup;
+		warmup.load(comp_path_);
+	}
+	double json_ms = measureMillis(iterations, [&](int) {
+		assets.clearCompositionCache();
+		Composition comp;
+		comp.load(comp_path_);
+	});
+	double compiled_ms = measureMillis(iterations, [&](int) {
+		assets.clearCompositionCache();
+		Composition comp;
+		comp.loadCompiled(compiled_path_);
+	});
+	std::stringstream ss;
+	ss << "[load] " << stats.compositions << " comps / " << stats.layers << " layers, compiled " << stats.bytes << " bytes" << std::endl
+	<< "  json:     " << json_ms << " ms" << std::endl
+	<< "  compiled: " << compiled_ms << " ms (x" << (compiled_ms > 0 ? json_ms / compiled_ms : 0) << ")";
+	addResult(ss.str());
+}
+
+//--------------------------------------------------------------
+// Sequential playback through the whole composition (property evaluation, no drawing).
+void ofApp::benchmarkSetFrame(){
+	Fixture f;
+	if(!loadFixture("setFrame", f)) return;
+	const int loops = 5;
+	double ms = measureFrames(f.frames, loops, [&](int frame) {
+		f.comp.setFrame(frame);
+	});
+	RenderList list;
+	double evaluate_ms = measureFrames(f.frames, loops, [&](int frame) {
+		f.comp.evaluate(frame, list);
+	});
+
+	EvaluationStats::setEnabled(true);
+	EvaluationStats::resetCounters();
+	for(int i = 0; i < f.frames; ++i) {
+		f.comp.setFrame(i);
+		f.comp.update();
+	}
+	auto counts = EvaluationStats::get();
+	EvaluationStats::setEnabled(false);
+
+	std::stringstream ss;
+	ss << "[setFrame] " << f.frames << " frames x " << loops << std::endl
+	<< "  sequential: " << ms << " ms/frame" << std::endl
+	<< "  evaluate (render list): " << evaluate_ms << " ms/frame" << std::endl
+	<< "  per frame: " << counts.properties_evaluated / float(f.frames) << " properties evaluated, "
+	<< counts.properties_skipped / float(f.frames) << " static skipped, "
+	<< counts.matrices_updated / float(f.frames) << " matrices updated";
+	addResult(ss.str());
+}
+
+//--------------------------------------------------------------
+// Serial vs. parallel layer evaluation. tools/CheckComposition checks that both produce the same layer state.
+void ofApp::benchmarkParallelSetFrame(){
+	Fixture f;
+	if(!loadFixture("parallel", f)) return;
+	auto set_frame = [&](int frame) { f.comp.setFrame(frame); };
+	f.comp.setParallelEvaluation(false);
+	double serial_ms = measureFrames(f.frames, 1, set_frame);
+	f.comp.setFrame(-1);
+	f.comp.setParallelEvaluation(true);
+	double parallel_ms = measureFrames(f.frames, 1, set_frame);
+	std::stringstream ss;
+	ss << "[parallel] " << f.comp.getLayers().size() << " layers, " << ThreadPool::getShared().getThreadCount() + 1 << " threads" << std::endl
+	<< "  serial:   " << serial_ms << " ms/frame" << std::endl
+	<< "  parallel: " << parallel_ms << " ms/frame";
+	addResult(ss.str());
+}
+
+//--------------------------------------------------------------
+// Playback with drawing. Shape layers only tessellate geometry that changed since the previous frame.
+void ofApp::benchmarkShapeDraw(){
+	Fixture f;
+	if(!loadFixture("draw", f)) return;
+	auto &cache = TessellationCache::getInstance();
+	cache.resetStats();
+	double ms = measureFrames(f.frames, 1, [&](int frame) { f.render(frame); });
+	const auto &stats = cache.getStats();
+	std::stringstream ss;
+	ss << "[draw] " << f.frames << " frames" << std::endl
+	<< "  setFrame+update+draw: " << ms << " ms/frame" << std::endl
+	<< "  tessellation cache: " << stats.hits << " hits, " << stats.misses << " misses ("
+	<< stats.getHitRatio() * 100 << "% hit), " << stats.cached_items << " entries";
+	addResult(ss.str());
+}
+
+//--------------------------------------------------------------
+// Layer-by-layer vs. batched drawing. tools/CheckComposition --gl checks that both produce the same pixels.
+void ofApp::benchmarkBatchedDraw(){
+	Fixture f;
+	if(!loadFixture("batch", f)) return;
+	auto render = [&](int frame) { f.render(frame); };
+	f.comp.setBatchedDrawing(false);
+	double direct_ms = measureFrames(f.frames, 1, render);
+	f.comp.setBatchedDrawing(true);
+	double batched_ms = measureFrames(f.frames, 1, render);
+	auto &batch = f.comp.getDrawBatch();
+	std::stringstream ss;
+	ss << "[batch] last frame: " << batch.getBatchedLayerCount() << " layers in " << batch.getDrawCount() << " draw calls" << std::endl
+	<< "  direct:  " << direct_ms << " ms/frame" << std::endl
+	<< "  batched: " << batched_ms << " ms/frame";
+	addResult(ss.str());
+}
+
+//--------------------------------------------------------------
+// Batched drawing with stills and sequence frames packed into atlas pages.
+void ofApp::benchmarkAtlas(){
+	auto &assets = AssetManager::getInstance();
+	assets.clearAllCaches();
+	assets.setAtlasEnabled(true);
+	{
+		Fixture f;
+		if(loadFixture("atlas", f)) {
+			f.comp.setBatchedDrawing(true);
+			double ms = measureFrames(f.frames, 1, [&](int frame) { f.render(frame); });
+			auto &batch = f.comp.getDrawBatch();
+			std::stringstream ss;
+			ss << "[atlas] batched: " << ms << " ms/frame, last frame " << batch.getBatchedLayerCount()
+			<< " layers in " << batch.getDrawCount() << " draw calls" << std::endl
+			<< "  " << assets.getAtlas().getDebugInfo();
+			addResult(ss.str());
+		}
+	}
+	assets.setAtlasEnabled(false);
+	assets.clearAllCaches();
+}
+
+//--------------------------------------------------------------
+// Image sequences loaded up front vs. streamed: load time, and decode/upload cost during playback.
+void ofApp::benchmarkStreaming(){
+	auto &assets = AssetManager::getInstance();
+	auto load = [&](bool streaming, Composition &comp) {
+		assets.clearAllCaches();
+		SequenceSource::setStreamingEnabled(streaming);
+		auto start = std::chrono::steady_clock::now();
+		bool loaded = comp.load(comp_path_);
+		SequenceSource::setStreamingEnabled(false);
+		return loaded ? std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() : -1.0;
+	};
+	double preload_ms;
+	{
+		Composition comp;
+		preload_ms = load(false, comp);
+	}
+	Composition comp;
+	double streaming_ms = load(true, comp);
+	if(preload_ms < 0 || streaming_ms < 0) {
+		addResult("[streaming] failed to load " + comp_path_);
+		return;
+	}
+	int frames = std::max<int>(1, comp.getFrameCount());
+	double frame_ms = measureMillis(frames, [&](int i) {
+		comp.setFrame(i);
+		comp.update();
+	});
+	SequenceStreamer::Stats total;
+	size_t sequences = 0;
+	for(auto &&layer : comp.getLayers()) {
+		auto source = layer->getSource<SequenceSource>();
+		if(!source || !source->getStreamer()) continue;
+		auto stats = source->getStreamer()->getStats();
+		total.decoded += stats.decoded;
+		total.uploaded += stats.uploaded;
+		total.underruns += stats.underruns;
+		total.decode_millis += stats.decode_millis;
+		total.upload_millis += stats.upload_millis;
+		total.max_decode_millis = std::max(total.max_decode_millis, stats.max_decode_millis);
+		total.max_upload_millis = std::max(total.max_upload_millis, stats.max_upload_millis);
+		++sequences;
+	}
+	std::stringstream ss;
+	ss << "[streaming] " << sequences << " sequences" << std::endl
+	<< "  load: preload " << preload_ms << " ms, streaming " << streaming_ms << " ms" << std::endl
+	<< "  playback: " << frame_ms << " ms/frame (setFrame+update), " << total.underruns << " underruns" << std::endl
+	<< "  decode: " << total.getAverageDecodeMillis() << " ms avg, " << total.max_decode_millis << " ms max (" << total.decoded << " frames)" << std::endl
+	<< "  upload: " << total.getAverageUploadMillis() << " ms avg, " << total.max_upload_millis << " ms max (" << total.uploaded << " frames)";
+	addResult(ss.str());
+	assets.clearAllCaches();
+}
+
+//--------------------------------------------------------------
+// Reopening a composition after it was released, without and with a texture budget.
+void ofApp::benchmarkAssetBudget(){
+	auto &assets = AssetManager::getInstance();
+	auto reopen = [&](size_t budget, CacheStats &stats) {
+		assets.clearAllCaches();
+		assets.setBudget(AssetKey::AssetType::TEXTURE, budget);
+		{
+			Composition comp;
+			if(!comp.load(comp_path_)) return -1.0;
+		}
+		assets.update();
+		assets.resetStats();
+		auto start = std::chrono::steady_clock::now();
+		Composition comp;
+		bool loaded = comp.load(comp_path_);
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		stats = assets.getStats().texture_stats;
+		return loaded ? ms : -1.0;
+	};
+	CacheStats without, with;
+	double without_ms = reopen(0, without);
+	double with_ms = reopen(256 * 1024 * 1024, with);
+	assets.setBudget(AssetKey::AssetType::TEXTURE, 0);
+	assets.clearAllCaches();
+	if(without_ms < 0 || with_ms < 0) {
+		addResult("[budget] failed to load " + comp_path_);
+		return;
+	}
+	std::stringstream ss;
+	ss << "[budget] reopen without budget: " << without_ms << " ms, " << without.reloads << " reloads" << std::endl
+	<< "  with 256MB budget: " << with_ms << " ms, " << with.reloads << " reloads, "
+	<< with.retained_items << " textures resident (" << with.resident_bytes / 1024 << " KB)";
+	addResult(ss.str());
+}
+
+//--------------------------------------------------------------
+// Loading on the main thread vs. requestComposition(): the longest main thread stall while loading.
+void ofApp::benchmarkAsyncLoad(){
+	auto &assets = AssetManager::getInstance();
+	assets.clearAllCaches();
+	double sync_ms = measureMillis(1, [&](int) {
+		assets.getComposition(comp_path_);
+	});
+	assets.clearAllCaches();
+
+	auto start = std::chrono::steady_clock::now();
+	auto request = assets.requestComposition(comp_path_);
+	double max_update_ms = 0;
+	int updates = 0;
+	while(!request.isReady()) {
+		max_update_ms = std::max(max_update_ms, measureMillis(1, [&](int) {
+			assets.update();
+		}));
+		++updates;
+		ofSleepMillis(1);
+	}
+	double async_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	if(!request.get()) {
+		addResult("[async] failed to load " + comp_path_);
+		return;
+	}
+	std::stringstream ss;
+	ss << "[async] sync load: " << sync_ms << " ms on the main thread" << std::endl
+	<< "  requestComposition: ready after " << async_ms << " ms, " << updates << " updates, longest update " << max_update_ms << " ms";
+	addResult(ss.str());
+	assets.clearAllCaches();
+}
+
+//--------------------------------------------------------------
+// Many instances of one composition, as when a precomp is used by several layers: loading each
+// instance vs. instantiating from one loaded composition, and playback with every instance at a
+// different frame. tools/CheckComposition checks that an instance evaluates like a freshly loaded composition.
+void ofApp::benchmarkPrecompInstances(){
+	const int instances = 100;
+	auto &assets = AssetManager::getInstance();
+	auto prototype = assets.getComposition(comp_path_);
+	if(!prototype) {
+		addResult("[instances] failed to load " + comp_path_);
+		return;
+	}
+	double load_ms = measureMillis(10, [&](int) {
+		assets.clearCompositionCache();
+		Composition comp;
+		comp.load(comp_path_);
+	});
+	std::vector<std::shared_ptr<Composition>> comps;
+	double instantiate_ms = measureMillis(instances, [&](int) {
+		comps.push_back(prototype->instantiate());
+	});
+	int frames = std::max<int>(1, prototype->getFrameCount());
+	double set_frame_ms = measureMillis(frames, [&](int i) {
+		for(int j = 0; j < instances; ++j) {
+			comps[j]->setFrame((i + j) % frames);
+		}
+	});
+	std::stringstream ss;
+	ss << "[instances] " << instances << " instances" << std::endl
+	<< "  load: " << load_ms << " ms, instantiate: " << instantiate_ms << " ms per instance" << std::endl
+	<< "  setFrame (all instances, staggered): " << set_frame_ms << " ms/frame";
+	addResult(ss.str());
+}
+
+//--------------------------------------------------------------
+// Drawing with nested compositions rendered every time vs. cached in PrecompCache,
+// playing the composition twice so that the second loop can hit frames of the first.
+void ofApp::benchmarkPrecompCache(){
+	Fixture f;
+	if(!loadFixture("precomp cache", f)) return;
+	auto render = [&](int frame) { f.render(frame); };
+	auto &cache = PrecompCache::getInstance();
+	cache.setBudget(0);
+	double direct_ms = measureFrames(f.frames, 2, render);
+	f.comp.setFrame(-1);
+	cache.setBudget(256 * 1024 * 1024);
+	cache.resetStats();
+	double cached_ms = measureFrames(f.frames, 2, render);
+	auto stats = cache.getStats();
+	cache.setBudget(0);
+
+	std::stringstream ss;
+	ss << "[precomp cache] " << f.frames << " frames x 2" << std::endl
+	<< "  direct: " << direct_ms << " ms/frame" << std::endl
+	<< "  cached: " << cached_ms << " ms/frame, hit ratio " << stats.getHitRatio() * 100 << "% (" << stats.hits << " hits, "
+	<< stats.misses << " misses, " << stats.evictions << " evictions), " << stats.resident_bytes / (1024 * 1024) << " MB";
+	addResult(ss.str());
+}
+
+//--------------------------------------------------------------
+// Render targets of masked, matted and blended layers over one playback: how many FBOs
+// FboPool had to allocate and how many requests it served from the pool instead.
+void ofApp::benchmarkFboPool(){
+	Fixture f;
+	if(!loadFixture("fbo pool", f)) return;
+	auto &pool = FboPool::getInstance();
+	pool.update();
+	pool.resetStats();
+	size_t max_allocations = 0;
+	double ms = measureFrames(f.frames, 1, [&](int frame) {
+		f.render(frame);
+		pool.update();
+		max_allocations = std::max(max_allocations, pool.getFrameStats().allocations);
+	});
+	auto stats = pool.getStats();
+	std::stringstream ss;
+	ss << "[fbo pool] " << f.frames << " frames, " << ms << " ms/frame" << std::endl
+	<< "  allocations: " << stats.allocations << " (max " << max_allocations << " in a frame), avoided: "
+	<< stats.reuses << " (" << stats.reuses / float(f.frames) << " per frame)" << std::endl
+	<< "  in use: " << stats.in_use << ", idle: " << stats.idle << " (" << stats.idle_bytes / 1024 << " KB)";
+	addResult(ss.str());
+}
+
+//--------------------------------------------------------------
+// Combining 1, 5 and 10 feathered masks on a 512x512 target: the single-pass mask shader vs.
+// drawing every mask into its own FBO and blending it into the target.
+void ofApp::benchmarkMasks(){
+	const int size = 512;
+	const int iterations = 50;
+	auto makeMask = [](int i) {
+		MaskPath path;
+		const float k = 0.5523f;
+		glm::vec2 center(128 + (i % 4) * 80, 128 + (i / 4) * 80);
+		float r = 100;
+		glm::vec2 dirs[] = {{1,0}, {0,1}, {-1,0}, {0,-1}};
+		for(int j = 0; j < 4; ++j) {
+			MaskVertex v(center + dirs[j] * r);
+			glm::vec2 tangent = dirs[(j + 1) % 4] * r * k;
+			v.outTangent = tangent;
+			v.inTangent = -tangent;
+			path.addVertex(v);
+		}
+		path.setClosed(true);
+		Mask mask;
+		mask.setPath(path);
+		mask.setMode(i % 2 ? MaskMode::SUBTRACT : MaskMode::ADD);
+		mask.setFeather(MaskFeather(10, 10));
+		return mask;
+	};
+	ofFbo target;
+	target.allocate(size, size, GL_RGBA);
+	std::stringstream ss;
+	ss << "[masks] " << size << "x" << size;
+	for(int count : {1, 5, 10}) {
+		MaskCollection masks;
+		for(int i = 0; i < count; ++i) {
+			masks.addMask(makeMask(i));
+		}
+		double single_ms = measureMillis(iterations, [&](int) {
+			masks.renderCombined(target);
+		});
+		double per_mask_ms = measureMillis(iterations, [&](int) {
+			target.begin();
+			ofClear(0, 0);
+			target.end();
+			for(auto &&mask : masks) {
+				auto fbo = FboPool::getInstance().acquire(size, size);
+				mask.renderToFbo(*fbo);
+				target.begin();
+				ofPushStyle();
+				ofEnableBlendMode(OF_BLENDMODE_ADD);
+				fbo->draw(0, 0);
+				ofPopStyle();
+				target.end();
+			}
+		});
+		ss << std::endl << "  " << count << " masks: single pass " << single_ms << " ms, per-mask FBOs " << per_mask_ms << " ms (no feather)";
+	}
+	addResult(ss.str());
+}
+
+//--------------------------------------------------------------
+// Rendering with GL and reading the pixels back vs. SoftwareRenderer on one thread and in parallel tiles.
+// tools/CheckComposition checks the pixels: tiled vs. one thread, against GL and against reference images.
+void ofApp::benchmarkSoftwareRenderer(){
+	Fixture f;
+	if(!loadFixture("software", f)) return;
+	ofPixels gl_pixels;
+	double gl_ms = measureFrames(f.frames, 1, [&](int frame) {
+		f.render(frame);
+		f.fbo.readToPixels(gl_pixels);
+	});
+
+	SoftwareRenderer::Settings serial_settings;
+	serial_settings.use_threads = false;
+	SoftwareRenderer serial(serial_settings), tiled;
+	ofPixels serial_pixels, tiled_pixels;
+	double serial_ms = measureFrames(f.frames, 1, [&](int frame) {
+		serial.render(f.comp, frame, serial_pixels);
+	});
+	double tiled_ms = measureFrames(f.frames, 1, [&](int frame) {
+		tiled.render(f.comp, frame, tiled_pixels);
+	});
+	auto &stats = tiled.getStats();
+	std::stringstream ss;
+	ss << "[software] " << f.fbo.getWidth() << "x" << f.fbo.getHeight() << ", " << f.frames << " frames" << std::endl
+	<< "  gl + readback: " << gl_ms << " ms/frame" << std::endl
+	<< "  cpu 1 thread:  " << serial_ms << " ms/frame" << std::endl
+	<< "  cpu tiled:     " << tiled_ms << " ms/frame, " << stats.skipped_items << " unsupported items skipped";
+	addResult(ss.str());
+}
+
+//--------------------------------------------------------------
+// Exporting the composition as raw RGBA frames: evaluating, rendering and writing one frame after
+// another vs. the Exporter pipeline, where the three stages overlap on different threads.
+void ofApp::benchmarkExport(){
+	Fixture f;
+	if(!loadFixture("export", f)) return;
+	Exporter::Settings settings;
+	settings.directory = ofToDataPath("benchmark/export", true);
+	settings.format = Exporter::Format::RAW;
+	Exporter exporter(settings);
+	std::filesystem::create_directories(settings.directory);
+
+	SoftwareRenderer renderer;
+	RenderList list;
+	ofPixels pixels;
+	double serial_ms = measureFrames(f.frames, 1, [&](int frame) {
+		f.comp.evaluate(frame, list);
+		renderer.render(list, pixels);
+		std::ofstream file(exporter.getFramePath(frame), std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(pixels.getData()), pixels.size());
+	});
+	bool succeeded = exporter.run(f.comp);
+	auto &stats = exporter.getStats();
+	std::stringstream ss;
+	ss << "[export] " << f.frames << " frames, raw RGBA" << std::endl
+	<< "  serial:   " << 1000. / serial_ms << " fps" << std::endl
+	<< "  pipeline: " << stats.getFramesPerSecond() << " fps" << (succeeded ? "" : ", failed")
+	<< " (evaluate " << stats.evaluate_millis / f.frames << ", render " << stats.render_millis / f.frames
+	<< ", write " << stats.encode_millis / f.frames << " ms/frame)";
+	addResult(ss.str());
+	std::filesystem::remove_all(settings.directory);
+}
+
+//--------------------------------------------------------------
+// Getting the pixels of every frame: fbo.readToPixels(), which waits for the GPU, vs. PixelReader's
+// ring of pixel-pack buffers. tools/CheckComposition --gl checks that each readback matches the frame it is behind by.
+void ofApp::benchmarkReadback(){
+	Fixture f;
+	if(!loadFixture("readback", f)) return;
+	ofPixels pixels;
+	double sync_ms = measureFrames(f.frames, 1, [&](int frame) {
+		f.render(frame);
+		f.fbo.readToPixels(pixels);
+	});
+	PixelReader reader;
+	size_t max_frames_behind = 0;
+	double async_ms = measureFrames(f.frames, 1, [&](int frame) {
+		f.render(frame);
+		reader.readback(f.fbo, OF_PIXELS_RGBA);
+		max_frames_behind = std::max(max_frames_behind, reader.getStats().frames_behind);
+	});
+	auto &stats = reader.getStats();
+	std::stringstream ss;
+	ss << "[readback] " << f.frames << " frames" << std::endl
+	<< "  readToPixels: " << sync_ms << " ms/frame" << std::endl
+	<< "  pbo ring:     " << async_ms << " ms/frame, " << stats.stalls << " stalls, up to " << max_frames_behind
+	<< " frames behind (" << stats.latency_millis << " ms)";
+	addResult(ss.str());
+}
+
+//--------------------------------------------------------------
+// Full frame animation stored as plain baked tracks vs. compressed ones (TrackCompression):
+// memory and playback cost of decoding. tools/CheckComposition checks that the error stays within tolerance.
+void ofApp::benchmarkTrackCompression(){
+	const float tolerance = 0.001f;
+	Fixture baked;
+	if(!loadFixture("compression", baked)) return;
+	if(baked.comp.getBakedStats().properties == 0) {
+		addResult("[compression] no full frame animation in " + comp_path_);
+		return;
+	}
+	TrackCompression::setTolerance(tolerance);
+	Fixture compressed;
+	bool loaded = loadFixture("compression", compressed);
+	TrackCompression::setTolerance(0);
+	if(!loaded) return;
+	const int loops = 5;
+	double baked_ms = measureFrames(baked.frames, loops, [&](int frame) {
+		baked.comp.setFrame(frame);
+	});
+	double compressed_ms = measureFrames(compressed.frames, loops, [&](int frame) {
+		compressed.comp.setFrame(frame);
+	});
+
+	auto &baked_stats = baked.comp.getBakedStats();
+	auto &stats = compressed.comp.getBakedStats();
+	std::stringstream ss;
+	ss << "[compression] " << baked_stats.properties << " baked properties, tolerance " << tolerance << std::endl
+	<< "  baked:      " << baked_stats.bytes / 1024 << " KB, " << baked_ms << " ms/frame" << std::endl
+	<< "  compressed: " << stats.bytes / 1024 << " KB, " << compressed_ms << " ms/frame, "
+	<< stats.compressed.size() << " tracks " << stats.getCompressionRatio() << "x smaller";
+	addResult(ss.str());
+}
+
+//--------------------------------------------------------------
+// Temporal bezier easing: interpolation::solveForX() per segment vs. the SIMD batch over
+// 100k random segments, and playback with the composition's easing solved per property vs. in an EaseBatch.
+// tools/CheckComposition checks that both give the same results.
+void ofApp::benchmarkEaseBatch(){
+	const size_t count = 100000;
+	std::vector<float> x(count), p1x(count), p2x(count), scalar(count), batched(count);
+	for(size_t i = 0; i < count; ++i) {
+		x[i] = ofRandomuf();
+		p1x[i] = ofRandomuf();
+		p2x[i] = 1.f - ofRandomuf();
+	}
+	const int iterations = 20;
+	double scalar_ms = measureMillis(iterations, [&](int) {
+		for(size_t i = 0; i < count; ++i) {
+			scalar[i] = interpolation::solveForX(x[i], p1x[i], p2x[i]);
+		}
+	});
+	double batched_ms = measureMillis(iterations, [&](int) {
+		interpolation::solveForX(x.data(), p1x.data(), p2x.data(), batched.data(), count);
+	});
+	std::stringstream ss;
+	ss << "[ease batch] " << count << " segments, " << interpolation::getSolveForXInstructionSet() << std::endl
+	<< "  scalar: " << scalar_ms << " ms (" << count / std::max(scalar_ms, 1e-6) / 1000 << " M/s)" << std::endl
+	<< "  batch:  " << batched_ms << " ms (" << count / std::max(batched_ms, 1e-6) / 1000 << " M/s, x"
+	<< (batched_ms > 0 ? scalar_ms / batched_ms : 0) << ")";
+
+	Fixture per_property, batched_easing;
+	if(loadFixture("ease batch", per_property) && loadFixture("ease batch", batched_easing)) {
+		batched_easing.comp.setBatchedEasing(true);
+		const int loops = 5;
+		double per_property_ms = measureFrames(per_property.frames, loops, [&](int frame) {
+			per_property.comp.setFrame(frame);
+		});
+		double batch_ms = measureFrames(batched_easing.frames, loops, [&](int frame) {
+			batched_easing.comp.setFrame(frame);
+		});
+		ss << std::endl << "  setFrame: " << per_property_ms << " ms/frame per property, "
+		<< batch_ms << " ms/frame batched";
+	}
+	addResult(ss.str());
+}
+
+//--------------------------------------------------------------
+// Evaluating the composition's shape layers: setFrame() and extraction into a ShapeData kept across frames,
+// after one warm-up loop. tools/CheckComposition checks that this does not allocate.
+void ofApp::benchmarkShapeEvaluation(){
+	Fixture f;
+	if(!loadFixture("shape evaluation", f)) return;
+	std::vector<ShapeSource*> sources;
+	for(auto &&layer : f.comp.getLayers()) {
+		if(auto source = layer->getSource<ShapeSource>()) {
+			sources.push_back(source);
+		}
+	}
+	std::vector<ShapeData> data(sources.size());
+	auto evaluate = [&](int frame) {
+		for(size_t i = 0; i < sources.size(); ++i) {
+			sources[i]->setFrame(frame);
+			sources[i]->tryExtract(data[i]);
+		}
+	};
+	measureFrames(f.frames, 1, evaluate);
+	const int loops = 3;
+	double ms = measureFrames(f.frames, loops, evaluate);
+	std::stringstream ss;
+	ss << "[shape evaluation] " << sources.size() << " shape layers, " << f.frames * loops << " frames: " << ms << " ms/frame";
+	addResult(ss.str());
+}
+
+//--------------------------------------------------------------
+// Reading TransformData out of 1000 transforms: the string-keyed lookups the extractor used to do,
+// tryExtract() through the registered extractor, and TransformProp::evaluate() as Layer uses it now.
+void ofApp::benchmarkTransformExtraction(){
+	const int count = 1000;
+	ofSeedRandom(1);
+	std::vector<std::unique_ptr<TransformProp>> transforms;
+	for(int i = 0; i < count; ++i) {
+		auto transform = std::make_unique<TransformProp>();
+		transform->setup({
+			{"anchor", {ofRandom(100), ofRandom(100), 0}},
+			{"position", {ofRandom(1000), ofRandom(1000), 0}},
+			{"scale", {100, 100, 100}},
+			{"rotateZ", ofRandom(360)},
+			{"opacity", 100}
+		}, {});
+		transform->setFrame(0);
+		transforms.push_back(std::move(transform));
+	}
+	std::vector<TransformData> data(count);
+	const int iterations = 1000;
+	double keyed_ms = measureMillis(iterations, [&](int) {
+		for(int i = 0; i < count; ++i) {
+			auto &t = *transforms[i];
+			auto &d = data[i];
+			// PropertyBase:: skips Property<T>'s statically typed overload and goes through the extractor map
+			t.getProperty<VecProp<3>>("/anchor")->PropertyBase::tryExtract(d.anchor);
+			t.getProperty<VecProp<3>>("/position")->PropertyBase::tryExtract(d.position);
+			t.getProperty<PercentVecProp<3>>("/scale")->PropertyBase::tryExtract(d.scale);
+			t.getProperty<FloatProp>("/rotateZ")->PropertyBase::tryExtract(d.rotateZ);
+			t.getProperty<PercentProp>("/opacity")->PropertyBase::tryExtract(d.opacity);
+		}
+	});
+	double extractor_ms = measureMillis(iterations, [&](int) {
+		for(int i = 0; i < count; ++i) {
+			transforms[i]->tryExtract(data[i]);
+		}
+	});
+	double evaluate_ms = measureMillis(iterations, [&](int) {
+		for(int i = 0; i < count; ++i) {
+			transforms[i]->evaluate(data[i]);
+		}
+	});
+	std::stringstream ss;
+	ss << "[transform extraction] " << count << " transforms" << std::endl
+	<< "  keyed lookups: " << keyed_ms * 1000 << " us" << std::endl
+	<< "  tryExtract:    " << extractor_ms * 1000 << " us" << std::endl
+	<< "  evaluate:      " << evaluate_ms * 1000 << " us (x" << (evaluate_ms > 0 ? keyed_ms / evaluate_ms : 0) << ")";
+	addResult(ss.str());
+}
+
+//--------------------------------------------------------------
+// Asset keys for a 2000 frame sequence: resolving each path on the file system vs. AssetKey's
+// per-directory cache, and lookups in the cache index.
+void ofApp::benchmarkAssetKey(){
+	const int frames = 2000;
+	std::vector<std::filesystem::path> paths;
+	auto directory = std::filesystem::absolute(ofToDataPath("benchmark/sequence"));
+	for(int i = 0; i < frames; ++i) {
+		paths.push_back(directory / ("frame_" + ofToString(i, 4, '0') + ".png"));
+	}
+	// results are summed into sink and printed, so the work being timed cannot be dropped
+	size_t sink = 0;
+	double syscall_ms = measureMillis(1, [&](int) {
+		for(auto &&path : paths) {
+			if(std::filesystem::exists(path)) {
+				sink += std::filesystem::canonical(path).native().size();
+			}
+			else {
+				sink += std::filesystem::absolute(path).native().size();
+			}
+		}
+	});
+	AssetKey::clearPathCache();
+	double cold_ms = measureMillis(1, [&](int) {
+		for(auto &&path : paths) {
+			sink += AssetKey(path, AssetKey::AssetType::TEXTURE).hash();
+		}
+	});
+	double warm_ms = measureMillis(1, [&](int) {
+		for(auto &&path : paths) {
+			sink += AssetKey(path, AssetKey::AssetType::TEXTURE).hash();
+		}
+	});
+	AssetCache<int> cache;
+	std::vector<std::shared_ptr<int>> held;
+	std::vector<AssetKey> keys;
+	for(int i = 0; i < frames; ++i) {
+		keys.emplace_back(paths[i], AssetKey::AssetType::TEXTURE);
+		held.push_back(std::make_shared<int>(i));
+		cache.store(keys.back(), held.back());
+	}
+	double lookup_ms = measureMillis(1, [&](int) {
+		for(auto &&key : keys) {
+			sink += cache.get(key) != nullptr;
+		}
+	});
+	std::stringstream ss;
+	ss << "[asset key] " << frames << " frames: file system " << syscall_ms << " ms, keys cold " << cold_ms << " ms, warm " << warm_ms << " ms" << std::endl
+	<< "  cache lookups: " << lookup_ms << " ms (checksum " << sink << ")";
+	addResult(ss.str());
+}
+
+//--------------------------------------------------------------
+// Spatial bezier with linear time (motion path): per-evaluation arc length solve vs. the per-segment table.
+// tools/CheckComposition checks the error of both against a dense reference parameterization.
+void ofApp::benchmarkArcLength(){
+	struct Curve {
+		glm::vec2 a, b, out_tangent, in_tangent;
+		interpolation::ArcLengthTable table;
+	};
+	const int curve_count = 200;
+	const int steps = 100;
+	ofSeedRandom(1);
+	std::vector<Curve> curves(curve_count);
+	for(auto &c : curves) {
+		c.a = {ofRandom(-500, 500), ofRandom(-500, 500)};
+		c.b = {ofRandom(-500, 500), ofRandom(-500, 500)};
+		c.out_tangent = {ofRandom(-300, 300), ofRandom(-300, 300)};
+		c.in_tangent = {ofRandom(-300, 300), ofRandom(-300, 300)};
+		c.table.build(c.a, c.a + c.out_tangent, c.b + c.in_tangent, c.b);
+	}
+
+	volatile float sink = 0;
+	double solve_ms = measureMillis(curve_count, [&](int i) {
+		auto &c = curves[i];
+		for(int s = 0; s < steps; ++s) {
+			sink += interpolation::spatialBezierLinearTime(c.a, c.b, c.out_tangent, c.in_tangent, s / float(steps)).x;
+		}
+	});
+	double table_ms = measureMillis(curve_count, [&](int i) {
+		auto &c = curves[i];
+		for(int s = 0; s < steps; ++s) {
+			sink += interpolation::spatialBezierLinearTime(c.a, c.b, c.out_tangent, c.in_tangent, s / float(steps), c.table).x;
+		}
+	});
+
+	double evaluations = steps;
+	std::stringstream ss;
+	ss << "[arc length] " << curve_count << " curves x " << steps << " steps" << std::endl
+	<< "  solve: " << (solve_ms > 0 ? evaluations / solve_ms * 1000 : 0) << " eval/s" << std::endl
+	<< "  table: " << (table_ms > 0 ? evaluations / table_ms * 1000 : 0) << " eval/s";
+	addResult(ss.str());
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "ofMain.h"
+#include "ofxAEComposition.h"
+
+// Runs a set of micro/macro benchmarks against an exported composition and shows the results.
+// Put the composition to measure at bin/data/benchmark/comp.json
+class ofApp : public ofBaseApp{
+
+public:
+	void setup() override;
+	void update() override;
+	void draw() override;
+
+	void keyPressed(int key) override;
+
+private:
+	void runBenchmarks();
+	void benchmarkLoad();
+	void benchmarkSetFrame();
+	void benchmarkParallelSetFrame();
+	void benchmarkShapeDraw();
+	void benchmarkBatchedDraw();
+	void benchmarkAtlas();
+	void benchmarkStreaming();
+	void benchmarkAssetBudget();
+	void benchmarkAsyncLoad();
+	void benchmarkPrecompInstances();
+	void benchmarkPrecompCache();
+	void benchmarkFboPool();
+	void benchmarkSoftwareRenderer();
+	void benchmarkExport();
+	void benchmarkReadback();
+	void benchmarkTrackCompression();
+	void benchmarkEaseBatch();
+	void benchmarkShapeEvaluation();
+	void benchmarkTransformExtraction();
+	void benchmarkMasks();
+	void benchmarkAssetKey();
+	void benchmarkArcLength();
+
+	template<typename Fn>
+	double measureMillis(int iterations, Fn &&fn) {
+		auto start = std::chrono::steady_clock::now();
+		for(int i = 0; i < iterations; ++i) {
+			fn(i);
+		}
+		auto end = std::chrono::steady_clock::now();
+		return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+	}
+	// Plays frames frames loops times, calling fn(frame), and returns ms per frame.
+	template<typename Fn>
+	double measureFrames(int frames, int loops, Fn &&fn) {
+		return measureMillis(frames * loops, [&](int i) { fn(i % frames); });
+	}
+	void addResult(const std::string &line);
+
+	// What most benchmarks start from: a freshly loaded comp_path_ and an FBO of its size.
+	struct Fixture {
+		ofx::ae::Composition comp;
+		ofFbo fbo;
+		int frames = 1;
+
+		// setFrame(), update() and draw() into fbo
+		void render(int frame);
+	};
+	// Loads comp_path_ into fixture. Adds "[name] failed to load" to the results and returns false if that fails.
+	bool loadFixture(const std::string &name, Fixture &fixture);
+
+	std::string comp_path_ = "benchmark/comp.json";
+	std::string compiled_path_ = "benchmark/comp.aec";
+	std::vector<std::string> results_;
+};
@@ -0,0 +1,161 @@
+#include "ofxAECompiler.h"
+
+#include "ofLog.h"
+#include "ofUtils.h"
+#include "ofJson.h"
+
+#include "ofxAEComposition.h"
+#include "ofxAELayer.h"
+#include "../source/ofxAESolidSource.h"
+#include "../source/ofxAEShapeSource.h"
+#include "../source/ofxAESequenceSource.h"
+#include "../utils/ofxAECompiledIO.h"
+
+namespace ofx { namespace ae {
+
+namespace {
+// Mirrors the built-in source resolvers of Layer, but records file references instead of loading assets
+// so that compiling does not need a GL context.
+void writeSource(const ofJson &json, const std::filesystem::path &base_dir, CompiledWriter &writer)
+{
+	auto writeBlock = [&writer](SourceType type, const std::function<void()> &body) {
+		writer.write(type);
+		auto block = writer.beginBlock();
+		body();
+		writer.endBlock(block);
+	};
+
+	SourceType type = sourceTypeFromString(json.value("sourceType", "none"));
+	std::filesystem::path filepath;
+	if(json.contains("source") && json["source"].is_string()) {
+		filepath = base_dir / json["source"].get<std::string>();
+	}
+	bool exists = !filepath.empty() && std::filesystem::exists(filepath);
+
+	switch(type) {
+		case SourceType::SOLID:
+			if(exists) {
+				SolidSource solid;
+				solid.setup(ofLoadJson(filepath));
+				writeBlock(type, [&]() { solid.write(writer); });
+				return;
+			}
+			break;
+		case SourceType::STILL:
+		case SourceType::VIDEO:
+			if(exists) {
+				writeBlock(type, [&]() { writer.writePath(filepath); });
+				return;
+			}
+			break;
+		case SourceType::SEQUENCE: {
+			std::vector<std::filesystem::path> frames;
+			Frame frame_offset;
+			if(exists && SequenceSource::listFrames(filepath, frames, frame_offset)) {
+				writeBlock(type, [&]() {
+					writer.write(frame_offset);
+					writer.write<uint32_t>(frames.size());
+					for(const auto &frame : frames) {
+						writer.writePath(frame);
+					}
+				});
+				return;
+			}
+		}	break;
+		case SourceType::COMPOSITION:
+			if(exists) {
+				uint32_t index = writer.requestComposition(filepath);
+				writeBlock(type, [&]() {
+					writer.write(index);
+					writer.writePath(filepath);
+				});
+				return;
+			}
+			break;
+		default:
+			break;
+	}
+
+	if(json.contains("shape")) {
+		ShapeSource shape;
+		if(shape.setup(json)) {
+			writeBlock(SourceType::SHAPE, [&]() { shape.write(writer); });
+			return;
+		}
+	}
+	writeBlock(SourceType::UNKNOWN, []() {});
+}
+
+bool compileComposition(const std::filesystem::path &filepath, uint32_t index, CompiledWriter &writer, Compiler::Stats &stats)
+{
+	ofJson json = ofLoadJson(filepath);
+	if(json.is_null() || json.empty()) {
+		ofLogError("Compiler") << "Failed to load composition: " << filepath;
+		return false;
+	}
+	auto base_dir = filepath.parent_path();
+
+	Composition::Info info;
+	info.setup(json);
+
+	writer.beginComposition(index);
+	info.write(writer);
+	for(const auto &layer_info : info.layers) {
+		std::filesystem::path layer_file = base_dir / layer_info.filepath;
+		if(!std::filesystem::exists(layer_file)) {
+			ofLogWarning("Compiler") << "Layer file not found: " << layer_file;
+			writer.write<uint8_t>(0);
+			continue;
+		}
+		ofJson layer_json = ofLoadJson(layer_file);
+		writer.write<uint8_t>(1);
+		auto block = writer.beginBlock();
+		Layer layer;
+		layer.setupProperties(layer_json);
+		layer.write(writer);
+		writeSource(layer_json, layer_file.parent_path(), writer);
+		writer.endBlock(block);
+		++stats.layers;
+	}
+	++stats.compositions;
+	return true;
+}
+}
+
+bool Compiler::compile(const std::filesystem::path &src, const std::filesystem::path &dst)
+{
+	Stats stats;
+	return compile(src, dst, stats);
+}
+
+bool Compiler::compile(const std::filesystem::path &src, const std::filesystem::path &dst, Stats &stats)
+{
+	stats = Stats();
+	std::filesystem::path src_path = ofToDataPath(src, true);
+	std::filesystem::path dst_path = ofToDataPath(dst, true);
+
+	CompiledWriter writer(dst_path.parent_path());
+	writer.requestComposition(src_path);
+
+	std::filesystem::path filepath;
+	uint32_t index;
+	while(writer.popRequestedComposition(filepath, index)) {
+		if(!compileComposition(filepath, index, writer, stats)) {
+			return false;
+		}
+	}
+	if(!writer.save(dst_path)) {
+		return false;
+	}
+
+	stats.strings = writer.getStringCount();
+	stats.vertices = writer.getVertexCount();
+	std::error_code ec;
+	stats.bytes = std::filesystem::file_size(dst_path, ec);
+	ofLogNotice("Compiler") << "Compiled " << src_path.filename() << " -> " << dst_path
+		<< " (" << stats.compositions << " compositions, " << stats.layers << " layers, "
+		<< stats.strings << " strings, " << stats.vertices << " vertices, " << stats.bytes << " bytes)";
+	return true;
+}
+
+}} // namespace ofx::ae
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+
+namespace ofx { namespace ae {
+
+// Converts an exported composition (JSON) into a single binary file that
+// Composition::loadCompiled() reads without parsing JSON.
+// Nested compositions are stored in the same file; asset files are referenced
+// by paths relative to the output file.
+class Compiler
+{
+public:
+	struct Stats {
+		size_t compositions = 0;
+		size_t layers = 0;
+		size_t strings = 0;
+		size_t vertices = 0;
+		size_t bytes = 0;
+	};
+
+	static bool compile(const std::filesystem::path &src, const std::filesystem::path &dst);
+	static bool compile(const std::filesystem::path &src, const std::filesystem::path &dst, Stats &stats);
+};
+
+}} // namespace ofx::ae
@@ -7,33 +7,47 @@
 #include "ofxAELayer.h"
 #include "ofxAEVisitor.h"
 #include "JsonFuncs.h"
+#include "../utils/ofxAECompiledIO.h"
+#include "../utils/ofxAEThreadPool.h"
+#include "../utils/ofxAEEvaluationStats.h"
 
 namespace ofx { namespace ae {
 
+namespace {
+// Collects the baked tracks of the layers set up while it exists.
+// Nested compositions loaded meanwhile collect their own and restore this one.
+struct BakedTrackScope {
+	BakedTrackScope() : previous(BakedTrackStats::setCollector(&stats)) {}
+	~BakedTrackScope() { BakedTrackStats::setCollector(previous); }
+	BakedTrackStats stats;
+	BakedTrackStats *previous;
+};
+}
+
 bool Composition::load(const std::filesystem::path &filepath)
 {
 	return setup(ofLoadJson(filepath), ofFilePath::getEnclosingDirectory(filepath));
 }
 
-bool Composition::setup(const ofJson &json, const std::filesystem::path &base_dir)
+void Composition::Info::setup(const ofJson &json)
 {
-	json::extract(json, "fps", info_.fps);
-	json::extract(json, "frameCount", info_.frame_count);
-	json::extract(json, "startFrame", info_.start_frame);
-	json::extract(json, "endFrame", info_.end_frame);
-	if(info_.end_frame == 0.0f) {
-		info_.end_frame = info_.frame_count;
+	json::extract(json, "fps", fps);
+	json::extract(json, "frameCount", frame_count);
+	json::extract(json, "startFrame", start_frame);
+	json::extract(json, "endFrame", end_frame);
+	if(end_frame == 0.0f) {
+		end_frame = frame_count;
 	}
 	
-	json::extract(json, "width", info_.width);
-	json::extract(json, "height", info_.height);
+	json::extract(json, "width", width);
+	json::extract(json, "height", height);
 
-	info_.layers.clear();
+	layers.clear();
 	if(json.contains("layers") && json["layers"].is_array()) {
 		for(const auto &layer : json["layers"]) {
 #define EXTRACT_LAYER2(k,n) json::extract(layer, #k, info.n)
 #define EXTRACT_LAYER(n) EXTRACT_LAYER2(n, n)
-			Info::LayerInfo info;
+			LayerInfo info;
 			EXTRACT_LAYER(name);
 			EXTRACT_LAYER2(uniqueName, unique_name);
 			EXTRACT_LAYER2(file, filepath);
@@ -44,23 +58,100 @@ bool Composition::setup(const ofJson &json, const std::filesystem::path &base_di
 #undef EXTRACT_LAYER
 			if(layer.contains("trackMatte")) {
 				ofJson track_matte = layer["trackMatte"];
-				Info::LayerInfo::TrackMatte matte;
+				LayerInfo::TrackMatte matte;
 				matte.layer = track_matte["layer"];
 				matte.type = trackMatteTypeFromString(track_matte["type"]);
 				info.track_matte = matte;
 			}
-			info_.layers.push_back(info);
+			layers.push_back(info);
 		}
 	}
 
 	if(json.contains("markers") && json["markers"].is_array()) {
-		Marker::parseMarkers(json["markers"], info_.markers);
+		Marker::parseMarkers(json["markers"], markers);
 	}
+}
 
-	layers_.clear();
-	name_layers_map_.clear();
-	unique_name_layers_map_.clear();
+void Composition::Info::write(CompiledWriter &writer) const
+{
+	writer.write(frame_count);
+	writer.write(fps);
+	writer.write(width);
+	writer.write(height);
+	writer.write(start_frame);
+	writer.write(end_frame);
+	
+	writer.write<uint32_t>(layers.size());
+	for(const auto &layer : layers) {
+		writer.write(layer.name);
+		writer.write(layer.unique_name);
+		writer.write(layer.filepath);
+		writer.write(layer.parent);
+		writer.write(layer.offset);
+		writer.write<uint8_t>(layer.visible);
+		writer.write<uint8_t>(layer.track_matte.has_value());
+		if(layer.track_matte) {
+			writer.write(layer.track_matte->layer);
+			writer.write(layer.track_matte->type);
+		}
+	}
+	
+	writer.write<uint32_t>(markers.size());
+	for(const auto &marker : markers) {
+		writer.write(marker.name);
+		writer.write(marker.comment);
+		writer.write(marker.frame);
+		writer.write(marker.duration_frames);
+	}
+}
+
+bool Composition::Info::read(CompiledReader &reader)
+{
+	if(!(reader.read(frame_count) && reader.read(fps)
+		 && reader.read(width) && reader.read(height)
+		 && reader.read(start_frame) && reader.read(end_frame))) {
+		return false;
+	}
+	
+	uint32_t count;
+	if(!reader.read(count)) return false;
+	layers.resize(count);
+	for(auto &layer : layers) {
+		uint8_t visible, has_track_matte;
+		if(!(reader.read(layer.name) && reader.read(layer.unique_name)
+			 && reader.read(layer.filepath) && reader.read(layer.parent)
+			 && reader.read(layer.offset) && reader.read(visible)
+			 && reader.read(has_track_matte))) {
+			return false;
+		}
+		layer.visible = visible != 0;
+		layer.track_matte.reset();
+		if(has_track_matte) {
+			LayerInfo::TrackMatte matte;
+			if(!(reader.read(matte.layer) && reader.read(matte.type))) {
+				return false;
+			}
+			layer.track_matte = matte;
+		}
+	}
+	
+	if(!reader.read(count)) return false;
+	markers.resize(count);
+	for(auto &marker : markers) {
+		if(!(reader.read(marker.name) && reader.read(marker.comment)
+			 && reader.read(marker.frame) && reader.read(marker.duration_frames))) {
+			return false;
+		}
+	}
+	return reader.isValid();
+}
+
+bool Composition::setup(const ofJson &json, const std::filesystem::path &base_dir)
+{
+	info_.setup(json);
+	clearLayers();
 
+	BakedTrackScope baked;
 	for(auto info : info_.layers) {
 		std::filesystem::path layer_file = base_dir / info.filepath;
 
@@ -69,22 +160,140 @@ bool Composition::setup(const ofJson &json, const std::filesystem::path &base_di
 			continue;
 		}
 		auto layer = std::make_shared<Layer>();
+		BakedTrackStats::NameScope name(info.name);
 		if(layer->load(layer_file)) {
-			layers_.push_back(layer);
-			name_layers_map_.insert({info.name, layer});
-			unique_name_layers_map_.insert({info.unique_name, layer});
-			
-			Frame offset_frame = info.offset;
-			layer_offsets_.insert({layer, offset_frame});
-			layer->setVisible(info.visible);
-			
-			layer->setFps(info_.fps);
+			addLayer(info, layer);
 		}
 		else {
 			ofLogError("ofxAEComposition") << "Failed to load layer: " << layer_file;
 		}
 	}
+	setBakedStats(baked.stats);
+
+	linkLayers();
+
+	current_frame_ = -1.0f;
+	setFrame(0.0f);
+	return !layers_.empty();
+}
+
+bool Composition::loadCompiled(const std::filesystem::path &filepath)
+{
+	CompiledArchive archive;
+	if(!archive.open(filepath)) {
+		return false;
+	}
+	size_t offset;
+	if(!archive.getCompositionOffset(0, offset)) {
+		ofLogError("ofxAEComposition") << "No composition in compiled file: " << filepath;
+		return false;
+	}
+	CompiledReader reader(archive, offset);
+	return read(reader);
+}
+
+bool Composition::read(CompiledReader &reader)
+{
+	if(!info_.read(reader)) {
+		ofLogError("ofxAEComposition") << "Failed to read composition info";
+		return false;
+	}
+	clearLayers();
 
+	BakedTrackScope baked;
+	for(auto info : info_.layers) {
+		uint8_t has_layer;
+		if(!reader.read(has_layer)) return false;
+		if(!has_layer) {
+			continue;
+		}
+		size_t block_end;
+		if(!reader.beginBlock(block_end)) return false;
+		auto layer = std::make_shared<Layer>();
+		BakedTrackStats::NameScope name(info.name);
+		if(layer->read(reader)) {
+			addLayer(info, layer);
+		}
+		else {
+			ofLogError("ofxAEComposition") << "Failed to read layer: " << info.name;
+		}
+		reader.endBlock(block_end);
+	}
+	if(!reader.isValid()) {
+		ofLogError("ofxAEComposition") << "Compiled composition data is truncated";
+		return false;
+	}
+	setBakedStats(baked.stats);
+
+	linkLayers();
+
+	current_frame_ = -1.0f;
+	setFrame(0.0f);
+	return !layers_.empty();
+}
+
+std::shared_ptr<Composition> Composition::instantiate() const
+{
+	auto ret = std::make_shared<Composition>();
+	ret->info_ = info_;
+	ret->is_parallel_evaluation_ = is_parallel_evaluation_;
+	ret->is_batched_easing_ = is_batched_easing_;
+	ret->is_batched_drawing_ = is_batched_drawing_;
+	ret->baked_stats_ = baked_stats_;
+	for(const auto &info : info_.layers) {
+		auto found = unique_name_layers_map_.find(info.unique_name);
+		if(found == end(unique_name_layers_map_)) continue;
+		if(auto layer = found->second.lock()) {
+			ret->addLayer(info, layer->instantiate());
+		}
+	}
+	ret->linkLayers();
+	ret->current_frame_ = -1.0f;
+	ret->setFrame(0.0f);
+	return ret;
+}
+
+void Composition::setBakedStats(const BakedTrackStats &stats)
+{
+	baked_stats_ = stats;
+	if(stats.properties > 0) {
+		ofLogNotice("ofxAEComposition") << "Full frame animation: " << stats.properties << " properties, "
+		<< stats.frames << " frames in " << stats.bytes / 1024 << " KB (" << stats.saved_bytes / 1024 << " KB less than keyframes)";
+	}
+	if(!stats.compressed.empty()) {
+		ofLogNotice("ofxAEComposition") << "Compressed tracks: " << stats.compressed.size() << " properties, "
+		<< ofToString(stats.getCompressionRatio(), 1) << "x smaller, max error " << stats.getMaxError() << " quantization steps";
+		for(const auto &track : stats.compressed) {
+			ofLogVerbose("ofxAEComposition") << "  " << track.name << ": " << track.frames << " frames -> " << track.keys
+			<< " keys, " << track.source_bytes << " -> " << track.bytes << " bytes (" << ofToString(track.getRatio(), 1)
+			<< "x), max error " << track.max_error << " steps";
+		}
+	}
+}
+
+void Composition::clearLayers()
+{
+	layers_.clear();
+	name_layers_map_.clear();
+	unique_name_layers_map_.clear();
+	layer_offsets_.clear();
+}
+
+void Composition::addLayer(const Info::LayerInfo &info, std::shared_ptr<Layer> layer)
+{
+	layers_.push_back(layer);
+	name_layers_map_.insert({info.name, layer});
+	unique_name_layers_map_.insert({info.unique_name, layer});
+	
+	Frame offset_frame = info.offset;
+	layer_offsets_.insert({layer, offset_frame});
+	layer->setVisible(info.visible);
+	
+	layer->setFps(info_.fps);
+}
+
+void Composition::linkLayers()
+{
 	for(auto info : info_.layers) {
 		auto layer = unique_name_layers_map_[info.unique_name].lock();
 		if(!layer) continue;
@@ -100,10 +309,6 @@ bool Composition::setup(const ofJson &json, const std::filesystem::path &base_di
 			}
 		}
 	}
-
-	current_frame_ = -1.0f;
-	setFrame(0.0f);
-	return !layers_.empty();
 }
 
 bool Composition::setFrame(Frame frame)
@@ -118,15 +323,85 @@ bool Composition::setFrame(Frame frame)
 		return (found != end(layer_offsets_)) ? found->second : 0.0f;
 	};
 	
-	for(auto& layer : layers_) {
-		Frame offset = getOffset(layer);
-		ret |= layer->setFrame(frame - offset);
+	if(is_batched_easing_) {
+		ease_batch_.clear();
+		for(auto& layer : layers_) {
+			layer->gatherEasing(frame - getOffset(layer), ease_batch_);
+		}
+		ease_batch_.solve();
+	}
+	
+	if(is_parallel_evaluation_ && layers_.size() > 1) {
+		ThreadPool::getShared().parallelFor(layers_.size(), [&](size_t i) {
+			layers_[i]->evaluate(frame - getOffset(layers_[i]));
+		});
+		for(auto& layer : layers_) {
+			ret |= layer->apply();
+		}
+	}
+	else {
+		for(auto& layer : layers_) {
+			Frame offset = getOffset(layer);
+			ret |= layer->setFrame(frame - offset);
+		}
 	}
 	
 	current_frame_ = frame;
 	return ret;
 }
 
+RenderList Composition::evaluate(Frame frame)
+{
+	RenderList list;
+	evaluate(frame, list);
+	return list;
+}
+
+void Composition::evaluate(Frame frame, RenderList &dst)
+{
+	setFrame(frame);
+	refreshMatrices();
+	getRenderList(dst);
+}
+
+void Composition::refreshMatrices()
+{
+	// world matrices are otherwise brought up to date in update()
+	for(auto& layer : layers_) {
+		if(layer->isDirty()) {
+			EvaluationStats::countMatrixUpdated();
+			layer->refreshMatrix();
+		}
+		if(auto source = layer->getSource<CompositionSource>()) {
+			if(auto nested = source->getComposition()) {
+				nested->refreshMatrices();
+			}
+		}
+	}
+}
+
+void Composition::getRenderList(RenderList &dst) const
+{
+	dst.clear();
+	dst.frame = current_frame_;
+	dst.width = static_cast<float>(info_.width);
+	dst.height = static_cast<float>(info_.height);
+	// same selection and order as draw(), plus the layers used as track mattes
+	for(auto it = layers_.rbegin(); it != layers_.rend(); ++it) {
+		auto &layer = *it;
+		if(!layer->isTrackMatte() && (!layer->isVisible() || layer->isAdjustmentLayer())) {
+			continue;
+		}
+		if(layer->getFrame() < 0.0f || (!layer->isActive() && !layer->isTrackMatte())) {
+			continue;
+		}
+		RenderItem item;
+		if(layer->tryExtract(item)) {
+			dst.items.push_back(std::move(item));
+		}
+	}
+}
+
 bool Composition::setTime(double time)
 {
 	return setFrame(util::timeToFrame(time, info_.fps));
@@ -145,6 +420,7 @@ void Composition::update()
 {
 	for(auto& layer : layers_) {
 		layer->update();
+		is_content_changed_ |= layer->consumeContentChange();
 	}
 }
 
@@ -154,12 +430,24 @@ void Composition::draw(float x, float y, float w, float h) const
 	ofTranslate(x, y);
 	ofScale(w / info_.width, h / info_.height);
 	
+	if(is_batched_drawing_) {
+		draw_batch_.begin();
+	}
 	for(auto it = layers_.rbegin(); it != layers_.rend(); ++it) {
 		if(!(*it)->isVisible() || (*it)->isAdjustmentLayer()) {
 			continue;
 		}
+		if(is_batched_drawing_) {
+			if(draw_batch_.add(**it)) {
+				continue;
+			}
+			draw_batch_.flush();
+		}
 		(*it)->draw();
 	}
+	if(is_batched_drawing_) {
+		draw_batch_.end();
+	}
 	
 	ofPopMatrix();
 }
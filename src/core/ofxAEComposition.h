@@ -5,11 +5,18 @@
 #include "../data/MarkerData.h"
 #include "../utils/ofxAETrackMatte.h"
 #include "../utils/ofxAETimeUtils.h"
+#include "ofxAERenderList.h"
+#include "ofxAEDrawBatch.h"
+#include "../prop/ofxAEKeyframeTrack.h"
+#include "../prop/ofxAEEaseBatch.h"
+#include <utility>
 
 namespace ofx { namespace ae {
 
 class Visitor;
 class Layer;
+class CompiledWriter;
+class CompiledReader;
 
 class Composition : public ofBaseDraws, public ofBaseUpdates
 {
@@ -41,16 +48,46 @@ public:
 		std::vector<MarkerData> markers;
 
 		Info() : frame_count(0.0f), fps(30.0f), width(0), height(0), start_frame(0.0f), end_frame(0.0f) {}
+		
+		void setup(const ofJson &json);
+		void write(CompiledWriter &writer) const;
+		bool read(CompiledReader &reader);
 	};
 
 	bool load(const std::filesystem::path &filepath);
 	bool setup(const ofJson &json, const std::filesystem::path &base_dir);
 	
+	// Loads a composition compiled by Compiler::compile (see ofxAECompiler.h).
+	bool loadCompiled(const std::filesystem::path &filepath);
+	bool read(CompiledReader &reader);
+	
+	// A new composition that shares this one's keyframes and assets but is evaluated on its own,
+	// so several instances of the same composition can be at different frames.
+	std::shared_ptr<Composition> instantiate() const;
+	// Full frame animation of the layers of this composition (not nested ones), as set up by the last load.
+	const BakedTrackStats& getBakedStats() const { return baked_stats_; }
+	
 	bool setFrame(Frame frame);
+	// Evaluates layer properties on ThreadPool::getShared(), then applies transforms and
+	// the sources that are not thread safe (video, nested compositions) serially.
+	// Results are identical to serial evaluation.
+	void setParallelEvaluation(bool enable) { is_parallel_evaluation_ = enable; }
+	bool isParallelEvaluation() const { return is_parallel_evaluation_; }
+	// Solves the bezier easing of every property at the frame in one SIMD pass (see EaseBatch)
+	// before the layers are evaluated, instead of once per property. Results are the same
+	// unless the compiler fuses multiply-adds in the scalar interpolation::solveForX().
+	void setBatchedEasing(bool enable) { is_batched_easing_ = enable; }
+	bool isBatchedEasing() const { return is_batched_easing_; }
 	Frame getFrame() const { return current_frame_; }
 	FrameCount getFrameCount() const { return info_.frame_count; }
 	float getFps() const { return info_.fps; }
 	
+	// Headless evaluation: sets the frame and returns what would be drawn as plain data.
+	// Does not need a GL context; layer FBOs are only redrawn when the composition is drawn.
+	RenderList evaluate(Frame frame);
+	void evaluate(Frame frame, RenderList &dst);
+	void getRenderList(RenderList &dst) const;
+
 	bool setTime(double time);
 	double getTime() const;
 	double getDuration() const;
@@ -58,8 +95,15 @@ public:
 	double convertFrameToTime(int frame) const { return util::frameToTime(frame, info_.fps); }
 
 	void update() override;
+	// True once after update() found a layer whose source changed without a setFrame() call.
+	bool consumeContentChange() { return std::exchange(is_content_changed_, false); }
 	using ofBaseDraws::draw;
 	void draw(float x, float y, float w, float h) const override;
+	// Draws runs of neighbouring solid and still layers that share blend mode and texture
+	// with one draw call each (see DrawBatch). Output is the same as drawing layer by layer.
+	void setBatchedDrawing(bool enable) { is_batched_drawing_ = enable; }
+	bool isBatchedDrawing() const { return is_batched_drawing_; }
+	const DrawBatch& getDrawBatch() const { return draw_batch_; }
 	float getHeight() const override;
 	float getWidth() const override;
 
@@ -68,6 +112,12 @@ public:
 	std::vector<std::shared_ptr<Layer>> getLayers() const;
 
 private:
+	void clearLayers();
+	void addLayer(const Info::LayerInfo &info, std::shared_ptr<Layer> layer);
+	void linkLayers();
+	void refreshMatrices();
+	void setBakedStats(const BakedTrackStats &stats);
+	
 	Info info_;
 	std::vector<std::shared_ptr<Layer>> layers_;
 	std::map<std::string, std::weak_ptr<Layer>> name_layers_map_;
@@ -75,6 +125,13 @@ private:
 	std::map<std::weak_ptr<Layer>, Frame, std::owner_less<std::weak_ptr<Layer>>> layer_offsets_;
 
 	Frame current_frame_;
+	bool is_parallel_evaluation_ = false;
+	bool is_batched_easing_ = false;
+	bool is_batched_drawing_ = false;
+	bool is_content_changed_ = false;
+	mutable DrawBatch draw_batch_;
+	EaseBatch ease_batch_;
+	BakedTrackStats baked_stats_;
 };
 
 }}
@@ -0,0 +1,132 @@
+#include "ofxAEDrawBatch.h"
+
+#include "ofxAELayer.h"
+#include "ofxAERenderContext.h"
+#include "../utils/ofxAEBlendMode.h"
+
+namespace ofx { namespace ae {
+
+namespace {
+// ofSetColor() goes through 8-bit ofColor; do the same so vertex colors match the unbatched path
+float quantize(float value)
+{
+	return static_cast<unsigned char>(ofClamp(value * 255.f, 0, 255)) / 255.f;
+}
+
+ofFloatColor quantize(const ofFloatColor &color)
+{
+	return {quantize(color.r), quantize(color.g), quantize(color.b), quantize(color.a)};
+}
+}
+
+DrawBatch::DrawBatch()
+{
+	mesh_.setMode(OF_PRIMITIVE_TRIANGLES);
+	mesh_.setUsage(GL_STREAM_DRAW);
+}
+
+void DrawBatch::begin()
+{
+	mesh_.clear();
+	is_open_ = false;
+	draw_count_ = 0;
+	layer_count_ = 0;
+	inherited_color_ = RenderContext::getCurrentStyle().color;
+	// ofDrawRectangle and ofTexture::draw honour these; keep the simple case only
+	is_enabled_ = ofGetFill() == OF_FILLED && ofGetRectMode() == OF_RECTMODE_CORNER;
+}
+
+bool DrawBatch::add(const Layer &layer)
+{
+	if(!is_enabled_) return false;
+	// same early outs as Layer::draw
+	if(layer.getFrame() < 0.0f || !layer.isActive()) return true;
+
+	LayerSource::BatchQuad quad;
+	if(!layer.tryGetBatchQuad(quad)) return false;
+
+	BlendMode blend_mode = layer.getBlendMode();
+	if(is_open_ && (blend_mode != blend_mode_ || quad.texture != texture_)) {
+		flush();
+	}
+	is_open_ = true;
+	blend_mode_ = blend_mode;
+	texture_ = quad.texture;
+
+	ofFloatColor color = quad.has_color ? quad.color : inherited_color_;
+	color.a = layer.getOpacity();
+	color = quantize(color);
+
+	glm::mat4 matrix = *layer.getWorldMatrix();
+	float w = layer.getWidth();
+	float h = layer.getHeight();
+	if(quad.texture) {
+		auto &tex = *quad.texture;
+		auto &rect = quad.tex_rect;
+		ofMesh mesh = tex.getMeshForSubsection(0, 0, 0, w, h, rect.x, rect.y, rect.width, rect.height, ofIsVFlipped(), OF_RECTMODE_CORNER);
+		append(mesh.getMode(), mesh.getVertices(), mesh.getTexCoords(), matrix, color);
+	}
+	else {
+		// same corners as ofDrawRectangle
+		std::vector<glm::vec3> vertices{{0,0,0}, {w,0,0}, {w,h,0}, {0,h,0}};
+		append(OF_PRIMITIVE_TRIANGLE_FAN, vertices, {}, matrix, color);
+	}
+	++layer_count_;
+	return true;
+}
+
+void DrawBatch::append(ofPrimitiveMode mode, const std::vector<glm::vec3> &vertices, const std::vector<glm::vec2> &tex_coords,
+					   const glm::mat4 &matrix, const ofFloatColor &color)
+{
+	bool has_tex_coords = tex_coords.size() == vertices.size();
+	auto addVertex = [&](size_t i) {
+		glm::vec4 v = matrix * glm::vec4(vertices[i], 1.f);
+		mesh_.addVertex({v.x, v.y, v.z});
+		mesh_.addColor(color);
+		if(has_tex_coords) mesh_.addTexCoord(tex_coords[i]);
+	};
+	// unroll into a triangle list with the same diagonals as the original primitive
+	switch(mode) {
+		case OF_PRIMITIVE_TRIANGLE_FAN:
+			for(size_t i = 1; i + 1 < vertices.size(); ++i) {
+				addVertex(0); addVertex(i); addVertex(i+1);
+			}
+			break;
+		case OF_PRIMITIVE_TRIANGLE_STRIP:
+			for(size_t i = 0; i + 2 < vertices.size(); ++i) {
+				if(i % 2 == 0) { addVertex(i); addVertex(i+1); addVertex(i+2); }
+				else { addVertex(i+1); addVertex(i); addVertex(i+2); }
+			}
+			break;
+		default:
+			for(size_t i = 0; i + 2 < vertices.size(); i += 3) {
+				addVertex(i); addVertex(i+1); addVertex(i+2);
+			}
+			break;
+	}
+}
+
+void DrawBatch::flush()
+{
+	if(!is_open_) return;
+	is_open_ = false;
+	if(mesh_.getNumVertices() == 0) return;
+
+	ofPushStyle();
+	applyBlendMode(blend_mode_);
+	if(texture_) {
+		mesh_.enableTextures();
+		texture_->bind();
+		mesh_.draw();
+		texture_->unbind();
+	}
+	else {
+		mesh_.disableTextures();
+		mesh_.draw();
+	}
+	ofPopStyle();
+	++draw_count_;
+	mesh_.clear();
+}
+
+}} // namespace ofx::ae
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "ofMain.h"
+#include "../data/Enums.h"
+
+namespace ofx { namespace ae {
+
+class Layer;
+
+// Collects consecutive layers that draw a single rectangle (solids, stills) and submits each run
+// that shares blend mode and texture with one draw call.
+// Vertices are baked into layer world space with the layer opacity as vertex color, so the
+// result matches drawing the layers one by one. Layers are never reordered: a layer that cannot be
+// batched, or that needs another blend mode or texture, ends the current run.
+class DrawBatch
+{
+public:
+	DrawBatch();
+
+	// Call inside the composition's matrix; picks up the inherited RenderContext color.
+	void begin();
+	// Adds the layer to the current run. Returns false if the layer has to be drawn on its own,
+	// in which case the caller must flush() first to keep the draw order.
+	bool add(const Layer &layer);
+	void flush();
+	void end() { flush(); }
+
+	size_t getDrawCount() const { return draw_count_; }
+	size_t getBatchedLayerCount() const { return layer_count_; }
+
+private:
+	void append(ofPrimitiveMode mode, const std::vector<glm::vec3> &vertices, const std::vector<glm::vec2> &tex_coords,
+				const glm::mat4 &matrix, const ofFloatColor &color);
+
+	bool is_enabled_ = false;
+	ofFloatColor inherited_color_;
+
+	bool is_open_ = false;
+	BlendMode blend_mode_ = BlendMode::NORMAL;
+	const ofTexture *texture_ = nullptr;
+	ofVboMesh mesh_;
+
+	size_t draw_count_ = 0;
+	size_t layer_count_ = 0;
+};
+
+}} // namespace ofx::ae
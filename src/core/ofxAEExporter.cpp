@@ -0,0 +1,208 @@
+#include "ofxAEExporter.h"
+
+#include "ofxAEComposition.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+namespace ofx { namespace ae {
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+double millisSince(Clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Bounded queue between two pipeline stages. pop() fails once the queue is closed and drained.
+template<typename T>
+class Channel
+{
+public:
+	explicit Channel(size_t capacity) : capacity_(capacity) {}
+
+	void push(T value) {
+		std::unique_lock<std::mutex> lock(mutex_);
+		not_full_.wait(lock, [this] { return queue_.size() < capacity_; });
+		queue_.push_back(std::move(value));
+		not_empty_.notify_one();
+	}
+	bool pop(T &value) {
+		std::unique_lock<std::mutex> lock(mutex_);
+		not_empty_.wait(lock, [this] { return !queue_.empty() || is_closed_; });
+		if(queue_.empty()) {
+			return false;
+		}
+		value = std::move(queue_.front());
+		queue_.pop_front();
+		not_full_.notify_one();
+		return true;
+	}
+	// tryPush() and tryPop() never block; for handing buffers back to be reused
+	bool tryPush(T &&value) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		if(queue_.size() >= capacity_) {
+			return false;
+		}
+		queue_.push_back(std::move(value));
+		not_empty_.notify_one();
+		return true;
+	}
+	bool tryPop(T &value) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		if(queue_.empty()) {
+			return false;
+		}
+		value = std::move(queue_.front());
+		queue_.pop_front();
+		not_full_.notify_one();
+		return true;
+	}
+	void close() {
+		std::lock_guard<std::mutex> lock(mutex_);
+		is_closed_ = true;
+		not_empty_.notify_all();
+	}
+
+private:
+	size_t capacity_;
+	std::mutex mutex_;
+	std::condition_variable not_empty_;
+	std::condition_variable not_full_;
+	std::deque<T> queue_;
+	bool is_closed_ = false;
+};
+
+struct Evaluated {
+	int frame = 0;
+	RenderList list;
+};
+struct Rendered {
+	int frame = 0;
+	ofPixels pixels;
+};
+}
+
+std::filesystem::path Exporter::getFramePath(int frame) const
+{
+	std::string name = settings_.prefix + ofToString(frame, settings_.digits, '0');
+	name += settings_.format == Format::PNG ? ".png" : ".rgba";
+	return settings_.directory / name;
+}
+
+bool Exporter::write(const ofPixels &pixels, const std::filesystem::path &path, size_t &bytes) const
+{
+	switch(settings_.format) {
+		case Format::PNG:
+			if(!ofSaveImage(pixels, path, OF_IMAGE_QUALITY_BEST)) {
+				return false;
+			}
+			break;
+		case Format::RAW: {
+			std::ofstream file(path, std::ios::binary | std::ios::trunc);
+			file.write(reinterpret_cast<const char*>(pixels.getData()), pixels.size());
+			if(!file) {
+				return false;
+			}
+			break;
+		}
+	}
+	std::error_code error;
+	auto size = std::filesystem::file_size(path, error);
+	bytes += error ? 0 : static_cast<size_t>(size);
+	return true;
+}
+
+bool Exporter::run(Composition &comp)
+{
+	stats_ = Stats();
+	int first = std::max(0, settings_.first_frame);
+	int last = settings_.last_frame < 0 ? static_cast<int>(comp.getFrameCount()) - 1 : settings_.last_frame;
+	if(last < first) {
+		ofLogError("Exporter") << "Empty frame range: " << first << " - " << last;
+		return false;
+	}
+	std::error_code error;
+	std::filesystem::create_directories(settings_.directory, error);
+	if(error) {
+		ofLogError("Exporter") << "Failed to create directory: " << settings_.directory << " (" << error.message() << ")";
+		return false;
+	}
+
+	auto start = Clock::now();
+	// two items per queue: a stage can start on the next frame while the one after it is still busy.
+	// Finished lists and pixels go back through the free queues, so buffers are allocated only once.
+	size_t encode_thread_count = std::max<size_t>(1, settings_.encode_threads);
+	Channel<Evaluated> evaluated(2), free_lists(4);
+	Channel<Rendered> rendered(2), free_pixels(2 + encode_thread_count * 2);
+	std::mutex stats_mutex;
+
+	std::thread render_thread([&] {
+		SoftwareRenderer renderer(settings_.renderer);
+		Evaluated item;
+		while(evaluated.pop(item)) {
+			Rendered result;
+			free_pixels.tryPop(result);
+			result.frame = item.frame;
+			auto render_start = Clock::now();
+			renderer.render(item.list, result.pixels, settings_.width, settings_.height);
+			stats_.render_millis += millisSince(render_start);
+			free_lists.tryPush(std::move(item));
+			rendered.push(std::move(result));
+		}
+		rendered.close();
+	});
+
+	std::vector<std::thread> encode_threads;
+	for(size_t i = 0; i < encode_thread_count; ++i) {
+		encode_threads.emplace_back([&] {
+			double millis = 0;
+			size_t bytes = 0, frames = 0, failed = 0;
+			Rendered item;
+			while(rendered.pop(item)) {
+				auto encode_start = Clock::now();
+				auto path = getFramePath(item.frame);
+				if(write(item.pixels, path, bytes)) {
+					++frames;
+				}
+				else {
+					ofLogError("Exporter") << "Failed to write frame " << item.frame << ": " << path;
+					++failed;
+				}
+				millis += millisSince(encode_start);
+				free_pixels.tryPush(std::move(item));
+			}
+			std::lock_guard<std::mutex> lock(stats_mutex);
+			stats_.encode_millis += millis;
+			stats_.bytes += bytes;
+			stats_.frames += frames;
+			stats_.failed_frames += failed;
+		});
+	}
+
+	// evaluation stays on the calling thread, which owns the composition
+	for(int frame = first; frame <= last; ++frame) {
+		Evaluated item;
+		free_lists.tryPop(item);
+		item.frame = frame;
+		auto evaluate_start = Clock::now();
+		comp.evaluate(static_cast<Frame>(frame), item.list);
+		stats_.evaluate_millis += millisSince(evaluate_start);
+		evaluated.push(std::move(item));
+	}
+	evaluated.close();
+
+	render_thread.join();
+	for(auto &thread : encode_threads) {
+		thread.join();
+	}
+	stats_.total_millis = millisSince(start);
+	return stats_.failed_frames == 0;
+}
+
+}} // namespace ofx::ae
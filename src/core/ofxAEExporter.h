@@ -0,0 +1,68 @@
+#pragma once
+
+#include "ofxAESoftwareRenderer.h"
+#include <filesystem>
+#include <string>
+
+namespace ofx { namespace ae {
+
+class Composition;
+
+// Renders a frame range of a composition to image files, without a GL context.
+// Runs as a pipeline: while frame N is rasterized by SoftwareRenderer, frame N+1 is evaluated
+// on the calling thread and frame N-1 is encoded and written on encoder threads.
+// Each frame goes to its own file named after the frame number, so the output does not
+// depend on thread timing. Call AssetManager::setUploadEnabled(false) before loading the
+// composition if there is no GL context.
+class Exporter
+{
+public:
+	enum class Format {
+		PNG,
+		RAW		// width * height * 4 bytes of RGBA with straight alpha, no header
+	};
+	struct Settings {
+		std::filesystem::path directory;
+		std::string prefix = "frame_";
+		int digits = 5;				// zero padding of the frame number in file names
+		Format format = Format::PNG;
+		int first_frame = 0;
+		int last_frame = -1;		// inclusive; -1 for the last frame of the composition
+		int width = 0;				// 0 for the size of the composition
+		int height = 0;
+		size_t encode_threads = 1;
+		SoftwareRenderer::Settings renderer;
+	};
+	struct Stats {
+		size_t frames = 0;
+		size_t failed_frames = 0;	// frames that could not be written
+		size_t bytes = 0;			// written to disk
+		double evaluate_millis = 0;	// busy time of each stage, totals
+		double render_millis = 0;
+		double encode_millis = 0;
+		double total_millis = 0;	// wall clock time of the whole export
+
+		double getFramesPerSecond() const { return total_millis > 0 ? frames * 1000. / total_millis : 0; }
+	};
+
+	Exporter() = default;
+	explicit Exporter(const Settings &settings) : settings_(settings) {}
+
+	void setSettings(const Settings &settings) { settings_ = settings; }
+	const Settings& getSettings() const { return settings_; }
+
+	// Exports the frame range of comp, leaving comp at the last exported frame.
+	// Returns false if the range is empty, the directory cannot be created or any frame failed.
+	bool run(Composition &comp);
+
+	std::filesystem::path getFramePath(int frame) const;
+	const Stats& getStats() const { return stats_; }
+
+private:
+	bool write(const ofPixels &pixels, const std::filesystem::path &path, size_t &bytes) const;
+
+	Settings settings_;
+	Stats stats_;
+};
+
+}} // namespace ofx::ae
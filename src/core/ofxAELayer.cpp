@@ -10,6 +10,9 @@
 #include "ofxAEVisitor.h"
 #include "../libs/JsonFuncs.h"
 #include "../utils/ofxAETimeUtils.h"
+#include "../utils/ofxAECompiledIO.h"
+#include "../utils/ofxAEEvaluationStats.h"
+#include "../utils/ofxAEFboPool.h"
 
 namespace ofx { namespace ae {
 
@@ -49,7 +52,8 @@ std::vector<Layer::SourceResolver> BUILTIN_RESOLVERS = {
 };
 
 std::unique_ptr<ofShader> mask_shader;
-void drawWithMask(ofTexture &src, ofTexture &mask, float x, float y, float w, float h)
+// sw x sh is the part of src and mask that holds the content
+void drawWithMask(ofTexture &src, ofTexture &mask, float x, float y, float w, float h, float sw, float sh)
 {
 	if(!mask_shader) {
 		mask_shader = std::make_unique<ofShader>();
@@ -88,11 +92,10 @@ void main()
 	m.addVertex({x,y+h,0});
 	m.addVertex({x+w,y+h,0});
 	m.addVertex({x+w,y,0});
-	auto data = src.getTextureData();
 	m.addTexCoord({0,0});
-	m.addTexCoord({0,data.tex_h});
-	m.addTexCoord({data.tex_w,data.tex_h});
-	m.addTexCoord({data.tex_w,0});
+	m.addTexCoord({0,sh});
+	m.addTexCoord({sw,sh});
+	m.addTexCoord({sw,0});
 	m.setMode(OF_PRIMITIVE_TRIANGLE_FAN);
 	m.drawFaces();
 	mask_shader->end();
@@ -139,6 +142,22 @@ std::unique_ptr<LayerSource> Layer::resolveSource(const ofJson &json, const std:
 }
 
 bool Layer::setup(const ofJson &json, const std::filesystem::path &base_dir)
+{
+	setupProperties(json);
+
+	auto source = resolveSource(json, base_dir);
+	if(source) {
+		setSource(std::move(source));
+	}
+	else {
+		ofLogVerbose("Layer") << "No source resolved for layer: " << name_;
+	}
+
+	current_frame_ = -1.0f;
+	return true;
+}
+
+void Layer::setupProperties(const ofJson &json)
 {
 #define EXTRACT(n) json::extract(json, #n, n)
 #define EXTRACT_(n) json::extract(json, #n, n##_)
@@ -172,27 +191,102 @@ bool Layer::setup(const ofJson &json, const std::filesystem::path &base_dir)
 		mask_.setup(json["mask"], mask_kf);
 		mask_collection_.setupFromMaskProp(mask_);
 	}
+#undef EXTRACT_
+#undef EXTRACT
+}
 
-	auto source = resolveSource(json, base_dir);
-	if(source) {
-		setSource(std::move(source));
+void Layer::write(CompiledWriter &writer) const
+{
+	writer.write(name_);
+	writer.write(in_frame_);
+	writer.write(out_frame_);
+	writer.write(blend_mode_);
+	writer.write<uint8_t>(is_adjustment_layer_);
+	writer.write(stretch_);
+	
+	for(const PropertyBase *prop : std::initializer_list<const PropertyBase*>{&transform_, &time_remap_, &mask_}) {
+		auto block = writer.beginBlock();
+		prop->write(writer);
+		writer.endBlock(block);
 	}
-	else {
-		ofLogVerbose("Layer") << "No source resolved for layer: " << name_;
+}
+
+bool Layer::read(CompiledReader &reader)
+{
+	uint8_t is_adjustment_layer;
+	if(!(reader.read(name_) && reader.read(in_frame_) && reader.read(out_frame_)
+		 && reader.read(blend_mode_) && reader.read(is_adjustment_layer)
+		 && reader.read(stretch_))) {
+		return false;
 	}
+	is_adjustment_layer_ = is_adjustment_layer != 0;
+	
+	for(PropertyBase *prop : std::initializer_list<PropertyBase*>{&transform_, &time_remap_, &mask_}) {
+		size_t block_end;
+		if(!reader.beginBlock(block_end) || !prop->read(reader)) {
+			return false;
+		}
+		reader.endBlock(block_end);
+	}
+	mask_collection_.setupFromMaskProp(mask_);
+	
+	SourceType type;
+	size_t block_end;
+	if(!reader.read(type) || !reader.beginBlock(block_end)) {
+		return false;
+	}
+	if(auto source = LayerSource::createSourceOfType(type)) {
+		if(source->read(reader)) {
+			setSource(std::move(source));
+		}
+		else {
+			ofLogWarning("Layer") << "Failed to read source for layer: " << name_;
+		}
+	}
+	reader.endBlock(block_end);
 
 	current_frame_ = -1.0f;
-	return true;
-#undef EXTRACT_
-#undef EXTRACT
+	return reader.isValid();
+}
+
+std::shared_ptr<Layer> Layer::instantiate() const
+{
+	auto ret = std::make_shared<Layer>();
+	ret->name_ = name_;
+	ret->in_frame_ = in_frame_;
+	ret->out_frame_ = out_frame_;
+	ret->blend_mode_ = blend_mode_;
+	ret->is_adjustment_layer_ = is_adjustment_layer_;
+	ret->stretch_ = stretch_;
+	ret->transform_.shareFrom(transform_);
+	ret->time_remap_.shareFrom(time_remap_);
+	ret->mask_.shareFrom(mask_);
+	ret->mask_collection_.setupFromMaskProp(ret->mask_);
+	if(source_) {
+		if(auto source = source_->instantiate()) {
+			ret->setSource(std::move(source));
+		}
+		else {
+			ofLogWarning("Layer") << "Source can not be instantiated for layer: " << name_;
+		}
+	}
+	ret->current_frame_ = -1.0f;
+	return ret;
 }
 
 void Layer::update()
 {
-	refreshMatrix();
+	if(isDirty()) {
+		EvaluationStats::countMatrixUpdated();
+		refreshMatrix();
+	}
 
 	if(source_) {
 		source_->update();
+		if(source_->consumeContentChange()) {
+			is_fbo_dirty_ = true;
+			is_content_changed_ = true;
+		}
 	}
 }
 
@@ -216,52 +310,99 @@ bool Layer::isActiveAtFrame(Frame frame) const
 }
 
 bool Layer::setFrame(Frame frame)
+{
+	evaluate(frame);
+	return apply();
+}
+
+void Layer::gatherEasing(Frame frame, EaseBatch &batch)
 {
 	if(util::isNearFrame(current_frame_, frame)) {
-		return false;
+		return;
+	}
+	transform_.gatherEasing(frame, batch);
+	if(isActiveAtFrame(frame) || isTrackMatte()) {
+		mask_.gatherEasing(frame, batch);
+		// a remapped source frame is only known once the layer is evaluated
+		if(source_ && !time_remap_.hasAnimation()) {
+			source_->gatherEasing(frame / stretch_, batch);
+		}
+	}
+}
+
+void Layer::evaluate(Frame frame)
+{
+	pending_ = PendingFrame();
+	if(util::isNearFrame(current_frame_, frame)) {
+		return;
+	}
+	pending_.is_valid = true;
+	pending_.frame = frame;
+	// entering or leaving the in/out range changes what is drawn even if no property does
+	if(isActiveAtFrame(frame) != isActiveAtFrame(current_frame_)) {
+		pending_.changed = true;
 	}
 
-	bool ret = false;
-	bool need_mask_update = false;
-	
 	if(transform_.setFrame(frame)) {
-		TransformData t;
-		if(!transform_.tryExtract(t)) {
-			ofLogWarning("PropertyExtraction") << "Failed to extract TransformData, using defaults";
-		}
-		TransformNode::setAnchorPoint(t.anchor);
-		TransformNode::setTranslation(t.position);
-		TransformNode::setScale(t.scale);
-		TransformNode::setRotationZ(t.rotateZ);
-		opacity_ = t.opacity;
-		ret |= true;
+		transform_.evaluate(pending_.transform);
+		pending_.has_transform = true;
+		pending_.changed = true;
 	}
 
 	if(isActiveAtFrame(frame) || isTrackMatte()) {
 		if(mask_.setFrame(frame)) {
 			mask_collection_.setupFromMaskProp(mask_);
-			ret |= true;
-			need_mask_update |= true;
+			pending_.changed = true;
+			pending_.need_mask_update = true;
 		}
 
 		if(source_) {
 			Frame source_frame = frame / stretch_;
 			
-			if(time_remap_.setFrame(frame)) {
+			// setFrame() only reports changes, so read the value every frame
+			if(time_remap_.hasAnimation()) {
+				time_remap_.setFrame(frame);
 				source_frame = time_remap_.get();
 			}
 			
-			if(source_->setFrame(source_frame)) {
-				ret |= true;
-				need_mask_update |= !mask_collection_.empty();
+			if(source_->canSetFrameConcurrently()) {
+				if(source_->setFrame(source_frame)) {
+					pending_.changed = true;
+					pending_.need_mask_update |= !mask_collection_.empty();
+				}
+			}
+			else {
+				pending_.has_source_frame = true;
+				pending_.source_frame = source_frame;
 			}
 		}
 	}
-	if(need_mask_update || isTrackMatte() || hasTrackMatte()) {
-		updateLayerFBO();
+}
+
+bool Layer::apply()
+{
+	if(!pending_.is_valid) {
+		return false;
 	}
-	current_frame_ = frame;
-	return ret;
+	pending_.is_valid = false;
+
+	if(pending_.has_transform) {
+		const TransformData &t = pending_.transform;
+		TransformNode::setAnchorPoint(t.anchor);
+		TransformNode::setTranslation(t.position);
+		TransformNode::setScale(t.scale);
+		TransformNode::setRotationZ(t.rotateZ);
+		opacity_ = t.opacity;
+	}
+	if(pending_.has_source_frame && source_->setFrame(pending_.source_frame)) {
+		pending_.changed = true;
+		pending_.need_mask_update |= !mask_collection_.empty();
+	}
+	if(pending_.need_mask_update || isTrackMatte() || hasTrackMatte()) {
+		is_fbo_dirty_ = true;
+	}
+	current_frame_ = pending_.frame;
+	return pending_.changed;
 }
 
 bool Layer::setTime(double time)
@@ -294,6 +435,10 @@ void Layer::draw(float x, float y, float w, float h) const
 	if(current_frame_ < 0.0f) return; // Not initialized
 	if(!isActiveAtFrame(current_frame_)) return;
 
+	if(isUseFbo()) {
+		updateLayerFBOIfNeeded();
+	}
+
 	TransformNode::pushMatrix();
 	RenderContext::push();
 	RenderContext::setOpacity(opacity_);
@@ -301,11 +446,11 @@ void Layer::draw(float x, float y, float w, float h) const
 	
 	if(isUseFbo()) {
 		auto offset = glm::vec2(x, y) - fbo_offset_;
-		if(mask_fbo_.isAllocated()) {
-			drawWithMask(layer_fbo_.getTexture(), mask_fbo_.getTexture(), offset.x, offset.y, w, h);
+		if(layer_fbo_ && mask_fbo_) {
+			drawWithMask(layer_fbo_->getTexture(), mask_fbo_->getTexture(), offset.x, offset.y, w, h, fbo_size_.x, fbo_size_.y);
 		}
-		else {
-			layer_fbo_.draw(offset.x, offset.y, w, h);
+		else if(layer_fbo_) {
+			layer_fbo_->getTexture().drawSubsection(offset.x, offset.y, w, h, 0, 0, fbo_size_.x, fbo_size_.y);
 		}
 	}
 	else {
@@ -318,21 +463,45 @@ void Layer::draw(float x, float y, float w, float h) const
 	TransformNode::popMatrix();
 }
 
-void Layer::updateLayerFBO()
+void Layer::updateLayerFBOIfNeeded() const
+{
+	if(!is_fbo_dirty_) return;
+	is_fbo_dirty_ = false;
+
+	// render the source as it would be at the top level, not with the style of whoever draws us
+	RenderContext::push();
+	RenderContext::setColorRGB(ofFloatColor(1,1,1));
+	RenderContext::setOpacity(1);
+	RenderContext::setBlendMode(BlendMode::NORMAL);
+	updateLayerFBO();
+	RenderContext::pop();
+}
+
+void Layer::updateLayerFBO() const
 {
 	if(!source_) return;
 
 	auto bb = source_->getBoundingBox();
 	if(bb.isEmpty()) return;
 
-	if(layer_fbo_.getWidth() != bb.width || layer_fbo_.getHeight() != bb.height) {
-		layer_fbo_.allocate(bb.width, bb.height, GL_RGBA);
+	// bring the matte up to date before binding our own FBOs
+	auto matte = track_matte_layer_.lock();
+	ofTexture matte_tex;
+	glm::vec2 matte_offset;
+	if(matte) {
+		matte_tex = matte->getTexture();
+		matte_offset = matte->getFboOffset();
 	}
-	if(mask_fbo_.getWidth() != bb.width || mask_fbo_.getHeight() != bb.height) {
-		mask_fbo_.allocate(bb.width, bb.height, GL_RGBA);
+
+	glm::ivec2 size(bb.width, bb.height);
+	if(!layer_fbo_ || size != fbo_size_) {
+		auto &pool = FboPool::getInstance();
+		pool.fit(layer_fbo_, size.x, size.y);
+		pool.fit(mask_fbo_, size.x, size.y);
+		fbo_size_ = size;
 	}
 
-	layer_fbo_.begin();
+	layer_fbo_->begin();
 	ofPushStyle();
 	ofClear(0, 0, 0, 0);
 	ofSetColor(255, 255, 255, 255);
@@ -340,31 +509,95 @@ void Layer::updateLayerFBO()
 	fbo_offset_ = -bb.position;
 	source_->draw(fbo_offset_);
 	ofPopStyle();
-	layer_fbo_.end();
+	layer_fbo_->end();
 
-	mask_collection_.renderCombined(mask_fbo_);
-	mask_fbo_.begin();
+	mask_collection_.renderCombined(*mask_fbo_);
+	mask_fbo_->begin();
 	ofPushStyle();
 	glBlendFuncSeparate(GL_ZERO, GL_SRC_ALPHA, GL_ZERO, GL_SRC_ALPHA);
-	if(auto matte = track_matte_layer_.lock()) {
+	if(matte) {
+		if(!track_matte_shader_) {
+			track_matte_shader_ = createShaderForTrackMatteType(track_matte_type_);
+		}
 		ofMatrix4x4 relative_mat = *getWorldMatrix() * *matte->getWorldMatrixInversed();
 		track_matte_shader_->begin();
 		track_matte_shader_->setUniformMatrix4f("uLayerToMatte", relative_mat);
-		auto offset = matte->getFboOffset();
-		track_matte_shader_->setUniform2f("matteOffset", offset.x, offset.y);
-		auto tex = matte->getTexture();
-		tex.setTextureWrap(GL_CLAMP_TO_BORDER, GL_CLAMP_TO_BORDER);
-		track_matte_shader_->setUniformTexture("matte", tex, 0);
+		track_matte_shader_->setUniform2f("matteOffset", matte_offset.x, matte_offset.y);
+		matte_tex.setTextureWrap(GL_CLAMP_TO_BORDER, GL_CLAMP_TO_BORDER);
+		track_matte_shader_->setUniformTexture("matte", matte_tex, 0);
 
 		ofDrawRectangle(ofGetCurrentViewport());
 		track_matte_shader_->end();
 	}
 	ofPopStyle();
-	mask_fbo_.end();
+	mask_fbo_->end();
 }
 
 
 
+bool Layer::tryExtract(RenderItem &dst) const
+{
+	dst.layer = this;
+	dst.name = name_;
+	dst.visible = is_visible_ && !is_adjustment_layer_;
+	dst.world_matrix = *getWorldMatrix();
+	dst.opacity = opacity_;
+	dst.blend_mode = blend_mode_;
+
+	dst.source = source_.get();
+	dst.source_type = source_ ? source_->getSourceType() : SourceType::UNKNOWN;
+	dst.source_frame = source_ ? source_->getFrame() : 0.0f;
+	dst.bounds = ofRectangle();
+	dst.shape.reset();
+	dst.children.clear();
+	switch(dst.source_type) {
+		case SourceType::SHAPE:
+			if(auto shape = getSource<ShapeSource>()) {
+				auto data = std::make_shared<ShapeData>();
+				if(shape->tryExtract(*data)) {
+					dst.shape = data;
+				}
+			}
+			break;
+		case SourceType::COMPOSITION:
+			if(auto comp = getSource<CompositionSource>()) {
+				if(auto nested = comp->getComposition()) {
+					RenderList list;
+					nested->getRenderList(list);
+					dst.children = std::move(list.items);
+				}
+				dst.bounds = source_->getBoundingBox();
+			}
+			break;
+		case SourceType::UNKNOWN:
+			break;
+		default:
+			dst.bounds = source_->getBoundingBox();
+			break;
+	}
+
+	dst.masks.clear();
+	mask_.tryExtract(dst.masks);
+	// same filter as MaskCollection::setupFromMaskProp
+	dst.masks.erase(std::remove_if(begin(dst.masks), end(dst.masks), [](const MaskAtomData &m) {
+		return m.shape.vertices.empty();
+	}), end(dst.masks));
+
+	auto matte = track_matte_layer_.lock();
+	dst.track_matte = matte.get();
+	dst.track_matte_type = matte ? track_matte_type_ : TrackMatteType::NO_TRACK_MATTE;
+	dst.is_track_matte = is_track_matte_;
+	return true;
+}
+
+bool Layer::tryGetBatchQuad(LayerSource::BatchQuad &dst) const
+{
+	if(!source_ || isUseFbo()) {
+		return false;
+	}
+	return source_->tryGetBatchQuad(dst);
+}
+
 float Layer::getHeight() const
 {
 	if(source_) {
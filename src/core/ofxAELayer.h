@@ -3,6 +3,7 @@
 #include <filesystem>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "ofGraphicsBaseTypes.h"
@@ -18,6 +19,7 @@
 #include "../prop/ofxAETransformProp.h"
 #include "../libs/Hierarchical.h"
 #include "../libs/TransformNode.h"
+#include "ofxAERenderList.h"
 
 namespace ofx { namespace ae {
 class Visitor;
@@ -26,6 +28,8 @@ class Visitor;
 namespace ofx { namespace ae {
 
 class LayerSource;
+class CompiledWriter;
+class CompiledReader;
 
 class Layer : public TransformNode, public ofBaseDraws, public ofBaseUpdates
 {
@@ -39,9 +43,29 @@ public:
 
 	bool load(const std::string &base_dir);
 	bool setup(const ofJson &json, const std::filesystem::path &source_dir="");
+	void setupProperties(const ofJson &json);
+	
+	// Writes everything but the source; the source block is written by Compiler from its JSON description.
+	void write(CompiledWriter &writer) const;
+	bool read(CompiledReader &reader);
+	// A new layer sharing this one's keyframes and source assets, with its own evaluation state.
+	// Parent and track matte links are not copied; Composition::instantiate() links them.
+	std::shared_ptr<Layer> instantiate() const;
 	void update() override;
+	// True once after update() found that the source changed without a setFrame() call.
+	bool consumeContentChange() { return std::exchange(is_content_changed_, false); }
 
 	bool setFrame(Frame frame);
+	// setFrame() split in two for parallel evaluation:
+	// evaluate() only touches this layer's properties (and its source if it allows concurrent setFrame)
+	// and may run on a worker thread; apply() updates the transform hierarchy and the remaining sources.
+	// apply() returns what setFrame() would.
+	// Neither touches GL; the layer FBO is redrawn on the next draw() or getTexture().
+	void evaluate(Frame frame);
+	bool apply();
+	// Adds the bezier segments that evaluate(frame) is going to interpolate to batch.
+	// See Composition::setBatchedEasing().
+	void gatherEasing(Frame frame, EaseBatch &batch);
 	void setFps(float fps);
 	Frame getFrame() const { return current_frame_; }
 	Frame getInFrame() const { return in_frame_; }
@@ -76,12 +100,15 @@ public:
 
 	void setBlendMode(BlendMode mode) { blend_mode_ = mode; }
 	BlendMode getBlendMode() const { return blend_mode_; }
+	float getOpacity() const { return opacity_; }
 
 	bool isActive() const { return isActiveAtFrame(current_frame_); }
 
 	void setTrackMatte(std::shared_ptr<Layer> src, TrackMatteType type) {
 		track_matte_layer_ = src;
-		track_matte_shader_ = createShaderForTrackMatteType(type);
+		track_matte_type_ = type;
+		// compiled on first draw, so loading needs no GL context
+		track_matte_shader_.reset();
 	}
 
 	void setUseAsTrackMatte(bool use) { is_track_matte_ = use; }
@@ -90,13 +117,37 @@ public:
 
 	bool isAdjustmentLayer() const { return is_adjustment_layer_; }
 
-	ofTexture getTexture() const { return layer_fbo_.isAllocated() ? layer_fbo_.getTexture() : ofTexture(); }
-	glm::vec2 getFboOffset() const { return fbo_offset_; }
+	ofTexture getTexture() const {
+		updateLayerFBOIfNeeded();
+		return layer_fbo_ ? layer_fbo_->getTexture() : ofTexture();
+	}
+	glm::vec2 getFboOffset() const {
+		updateLayerFBOIfNeeded();
+		return fbo_offset_;
+	}
+
+	// Current state as plain data (see Composition::evaluate).
+	bool tryExtract(RenderItem &dst) const;
+	// True if draw() would only draw the source's BatchQuad (no FBO for masks or track mattes).
+	bool tryGetBatchQuad(LayerSource::BatchQuad &dst) const;
 
 	std::string getDebugInfo() const;
 
 private:
-	void updateLayerFBO();
+	void updateLayerFBO() const;
+	void updateLayerFBOIfNeeded() const;
+
+	struct PendingFrame {
+		bool is_valid = false;
+		Frame frame = 0.0f;
+		bool changed = false;
+		bool has_transform = false;
+		TransformData transform;
+		bool has_source_frame = false;
+		Frame source_frame = 0.0f;
+		bool need_mask_update = false;
+	};
+	PendingFrame pending_;
 	
 	std::unique_ptr<LayerSource> source_;
 
@@ -112,18 +163,23 @@ private:
 
 	MaskProp mask_;
 	MaskCollection mask_collection_;
-	mutable ofFbo mask_fbo_;
+	mutable std::shared_ptr<ofFbo> mask_fbo_;
 
 	std::weak_ptr<Layer> track_matte_layer_;
-	std::unique_ptr<ofShader> track_matte_shader_;
+	TrackMatteType track_matte_type_ = TrackMatteType::NO_TRACK_MATTE;
+	mutable std::unique_ptr<ofShader> track_matte_shader_;
 	bool is_track_matte_ = false;
 
 	bool is_adjustment_layer_ = false;
 
 	bool isUseFbo() const { return is_track_matte_ || !mask_collection_.empty() || hasTrackMatte(); }
 
-	mutable ofFbo layer_fbo_;
-	glm::vec2 fbo_offset_{0,0};
+	// from FboPool, so they may be larger than the content
+	mutable std::shared_ptr<ofFbo> layer_fbo_;
+	mutable glm::vec2 fbo_offset_{0,0};
+	mutable glm::ivec2 fbo_size_{0,0};
+	mutable bool is_fbo_dirty_ = false;
+	bool is_content_changed_ = false;
 	float opacity_=1;
 	BlendMode blend_mode_;
 	bool is_visible_ = false;
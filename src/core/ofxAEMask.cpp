@@ -1,9 +1,15 @@
 #include "ofGraphics.h"
 #include "ofFbo.h"
+#include "ofShader.h"
+
+#include <algorithm>
+#include <limits>
+#include <memory>
 
 #include "ofxAEMask.h"
 #include "../data/MaskData.h"
 #include "../prop/ofxAEMaskProp.h"
+#include "../utils/ofxAEFboPool.h"
 
 namespace ofx { namespace ae {
 
@@ -72,6 +78,33 @@ void MaskPath::generatePolyline(ofPolyline &polyline, int resolution) const
 	}
 }
 
+void MaskPath::flatten(std::vector<glm::vec2> &dst, float tolerance) const
+{
+	if(vertices.empty()) return;
+	dst.push_back(vertices[0].position);
+	// masks are always filled as closed shapes, so open paths get their closing segment too
+	for(size_t i = 0; i < vertices.size(); ++i) {
+		size_t next = (i + 1) % vertices.size();
+		glm::vec2 p0 = vertices[i].position;
+		glm::vec2 p3 = vertices[next].position;
+		glm::vec2 p1 = p0 + (closed || next != 0 ? vertices[i].outTangent : glm::vec2(0));
+		glm::vec2 p2 = p3 + (closed || next != 0 ? vertices[next].inTangent : glm::vec2(0));
+		if(p1 == p0 && p2 == p3) {
+			if(next != 0) dst.push_back(p3);
+			continue;
+		}
+		// the distance of a cubic to its n-segment polygon is at most max|B''| / (8 n^2)
+		float dd = std::max(glm::length(p0 - 2.f * p1 + p2), glm::length(p1 - 2.f * p2 + p3));
+		int n = ofClamp(std::ceil(std::sqrt(6.f * dd / (8.f * tolerance))), 1, 128);
+		for(int k = 1; k <= n; ++k) {
+			if(k == n && next == 0) break;
+			float t = static_cast<float>(k) / n;
+			float u = 1.f - t;
+			dst.push_back(u*u*u * p0 + 3.f*u*u*t * p1 + 3.f*u*t*t * p2 + t*t*t * p3);
+		}
+	}
+}
+
 void MaskPath::setFromPathData(const PathData &pathData)
 {
 	clear();
@@ -179,10 +212,6 @@ void Mask::renderToFbo(ofFbo &target) const
 
 	ofPopStyle();
 	target.end();
-
-	if(feather.outer > 0 || feather.inner > 0) {
-		applyFeather(target);
-	}
 }
 
 void Mask::renderPath(const MaskPath &path) const
@@ -206,10 +235,6 @@ void Mask::setFromMaskAtomData(const MaskAtomData &atomData)
 	setMode(atomData.mode);
 }
 
-void Mask::applyFeather(ofFbo &target) const
-{
-}
-
 ofRectangle Mask::getBounds() const
 {
 	if(path.getVertexCount() == 0) {
@@ -284,14 +309,186 @@ bool MaskCollection::hasActiveMasks() const
 	return false;
 }
 
+namespace {
+// Outline segments of all masks of a layer, 4 floats (start, end) per texel.
+constexpr int SEGMENTS_PER_ROW = 1024;
+ofTexture segment_texture;
+std::vector<float> segment_data;
+std::vector<glm::vec2> outline;
+std::unique_ptr<ofShader> mask_shader;
+
+const ofShader& getMaskShader()
+{
+	if(mask_shader) {
+		return *mask_shader;
+	}
+	auto mode = [](MaskMode mode) { return std::to_string(static_cast<int>(mode)); };
+	std::string fragment = R"(#version 150
+#define MAX_MASKS )" + std::to_string(MaskCollection::MAX_SINGLE_PASS_MASKS) + R"(
+#define MODE_ADD )" + mode(MaskMode::ADD) + R"(
+#define MODE_SUBTRACT )" + mode(MaskMode::SUBTRACT) + R"(
+#define MODE_INTERSECT )" + mode(MaskMode::INTERSECT) + R"(
+#define MODE_LIGHTEN )" + mode(MaskMode::LIGHTEN) + R"(
+#define MODE_DARKEN )" + mode(MaskMode::DARKEN) + R"(
+#define MODE_DIFFERENCE )" + mode(MaskMode::DIFFERENCE) + R"(
+#define SEGMENTS_PER_ROW )" + std::to_string(SEGMENTS_PER_ROW) + R"(
+uniform sampler2DRect segments;
+uniform int mask_count;
+uniform vec4 mask_ranges[MAX_MASKS];	// first segment, segment count, mode, inverted
+uniform vec4 mask_params[MAX_MASKS];	// opacity, expansion, feather
+uniform vec4 mask_bounds[MAX_MASKS];	// min, max of the outline grown by feather and expansion
+
+in vec2 pos;
+out vec4 fragColor;
+
+// 0 outside, 1 inside, with a falloff across the edge that is one pixel wide or the feather width
+float coverage(int m)
+{
+	vec4 bounds = mask_bounds[m];
+	if(any(lessThan(pos, bounds.xy)) || any(greaterThan(pos, bounds.zw))) {
+		return 0.0;
+	}
+	int first = int(mask_ranges[m].x);
+	int last = first + int(mask_ranges[m].y);
+	int winding = 0;
+	float dist2 = 1e20;
+	vec2 nearest = vec2(1.0, 0.0);
+	for(int i = first; i < last; ++i) {
+		vec4 s = texelFetch(segments, ivec2(i % SEGMENTS_PER_ROW, i / SEGMENTS_PER_ROW));
+		vec2 e = s.zw - s.xy;
+		vec2 pa = pos - s.xy;
+		float t = clamp(dot(pa, e) / max(dot(e, e), 1e-12), 0.0, 1.0);
+		vec2 d = pa - e * t;
+		float dd = dot(d, d);
+		if(dd < dist2) {
+			dist2 = dd;
+			nearest = d;
+		}
+		float side = e.x * pa.y - e.y * pa.x;
+		if(s.y <= pos.y) {
+			if(s.w > pos.y && side > 0.0) ++winding;
+		}
+		else if(s.w <= pos.y && side < 0.0) {
+			--winding;
+		}
+	}
+	float dist = sqrt(dist2);
+	float signed_dist = (winding != 0 ? dist : -dist) + mask_params[m].y;
+	// the feather is elliptic, so its width depends on the direction to the edge
+	vec2 n = dist > 0.0 ? nearest / dist : vec2(1.0, 0.0);
+	float width = 1.0 / length(n / max(mask_params[m].zw, vec2(1.0)));
+	float k = clamp(0.5 + signed_dist / width, 0.0, 1.0);
+	return k * k * (3.0 - 2.0 * k);
+}
+
+void main()
+{
+	float value = 0.0;
+	for(int m = 0; m < mask_count; ++m) {
+		float c = coverage(m);
+		float v = clamp(mask_params[m].x, 0.0, 1.0) * (mask_ranges[m].w > 0.5 ? 1.0 - c : c);
+		if(m == 0) {
+			value = v;
+			continue;
+		}
+		int mode = int(mask_ranges[m].z);
+		if(mode == MODE_ADD) value = min(value + v, 1.0);
+		else if(mode == MODE_SUBTRACT) value = max(value - v, 0.0);
+		else if(mode == MODE_INTERSECT) value *= v;
+		else if(mode == MODE_LIGHTEN) value = max(value, v);
+		else if(mode == MODE_DARKEN) value = min(value, v);
+		else if(mode == MODE_DIFFERENCE) value = abs(value - v);
+	}
+	fragColor = vec4(value, value, value, 1.0);
+}
+)";
+	mask_shader = std::make_unique<ofShader>();
+	mask_shader->setupShaderFromSource(GL_VERTEX_SHADER, R"(#version 150
+uniform mat4 modelViewProjectionMatrix;
+in vec4 position;
+out vec2 pos;
+
+void main()
+{
+	gl_Position = modelViewProjectionMatrix * position;
+	pos = position.xy;
+})");
+	mask_shader->setupShaderFromSource(GL_FRAGMENT_SHADER, fragment);
+	mask_shader->bindDefaults();
+	mask_shader->linkProgram();
+	return *mask_shader;
+}
+}
+
+// All masks are flattened to line segments and uploaded to one texture. A single full-target
+// pass then finds each mask's coverage from the winding number and the distance to its outline
+// (which also gives antialiasing, feather and expansion) and combines the masks in order.
+// Feather is a smooth falloff over the feather width across the edge, which matches a blur for
+// straight edges without the extra passes and per-mask targets a blur would need.
+void MaskCollection::renderSinglePass(ofFbo &target) const
+{
+	std::vector<glm::vec4> ranges, params, bounds;
+	segment_data.clear();
+	int segment_count = 0;
+	for(const auto &mask : masks) {
+		if(!mask.isEnabled()) continue;
+		outline.clear();
+		mask.getPath().flatten(outline);
+		glm::vec2 min_pos(std::numeric_limits<float>::max()), max_pos(std::numeric_limits<float>::lowest());
+		for(size_t i = 0; i < outline.size(); ++i) {
+			const auto &a = outline[i];
+			const auto &b = outline[(i + 1) % outline.size()];
+			segment_data.insert(segment_data.end(), {a.x, a.y, b.x, b.y});
+			min_pos = glm::min(min_pos, a);
+			max_pos = glm::max(max_pos, a);
+		}
+		const auto &feather = mask.getFeather();
+		glm::vec2 margin = glm::max(glm::vec2(feather.inner, feather.outer), glm::vec2(1)) + std::max(mask.getExpansion(), 0.f);
+		ranges.emplace_back(segment_count, outline.size(), static_cast<int>(mask.getMode()), mask.isInverted() ? 1 : 0);
+		params.emplace_back(mask.getOpacity(), mask.getExpansion(), feather.inner, feather.outer);
+		min_pos -= margin;
+		max_pos += margin;
+		bounds.emplace_back(min_pos.x, min_pos.y, max_pos.x, max_pos.y);
+		segment_count += outline.size();
+	}
+
+	int rows = std::max(1, (segment_count + SEGMENTS_PER_ROW - 1) / SEGMENTS_PER_ROW);
+	segment_data.resize(rows * SEGMENTS_PER_ROW * 4, 0.f);
+	if(!segment_texture.isAllocated() || segment_texture.getHeight() < rows) {
+		segment_texture.allocate(SEGMENTS_PER_ROW, rows, GL_RGBA32F, true);
+		segment_texture.setTextureMinMagFilter(GL_NEAREST, GL_NEAREST);
+	}
+	segment_texture.loadData(segment_data.data(), SEGMENTS_PER_ROW, rows, GL_RGBA);
+
+	const auto &shader = getMaskShader();
+	target.begin();
+	ofPushStyle();
+	ofDisableBlendMode();
+	shader.begin();
+	shader.setUniformTexture("segments", segment_texture, 0);
+	shader.setUniform1i("mask_count", ranges.size());
+	shader.setUniform4fv("mask_ranges", &ranges[0].x, ranges.size());
+	shader.setUniform4fv("mask_params", &params[0].x, params.size());
+	shader.setUniform4fv("mask_bounds", &bounds[0].x, bounds.size());
+	ofDrawRectangle(0, 0, target.getWidth(), target.getHeight());
+	shader.end();
+	ofPopStyle();
+	target.end();
+}
+
 void MaskCollection::renderCombined(ofFbo &target) const
 {
-	if(masks.empty()) {
+	if(!hasActiveMasks()) {
 		target.begin();
 		ofClear(255, 255, 255, 255);
 		target.end();
 		return;
 	}
+	int enabled_count = std::count_if(masks.begin(), masks.end(), [](const Mask &mask) { return mask.isEnabled(); });
+	if(enabled_count <= MAX_SINGLE_PASS_MASKS) {
+		renderSinglePass(target);
+		return;
+	}
 
 	target.begin();
 	ofClear(0, 0, 0, 0);
@@ -304,27 +501,20 @@ void MaskCollection::renderCombined(ofFbo &target) const
 			isFirst = false;
 		}
 	}
-
-	if(isFirst) {
-		target.begin();
-		ofClear(255, 255, 255, 255);
-		target.end();
-	}
 }
 
 void MaskCollection::combineMasks(ofFbo &target, const Mask &mask, bool isFirst) const
 {
-	ofFbo maskFbo;
-	maskFbo.allocate(target.getWidth(), target.getHeight(), GL_RGBA);
+	auto maskFbo = FboPool::getInstance().acquire(target.getWidth(), target.getHeight());
 
-	mask.renderToFbo(maskFbo);
+	mask.renderToFbo(*maskFbo);
 
 	target.begin();
 
 	ofPushStyle();
 	if(isFirst) {
 		ofSetColor(ofFloatColor::white);
-		maskFbo.draw(0, 0);
+		maskFbo->draw(0, 0);
 	}
 	else {
 		switch (mask.getMode()) {
@@ -349,7 +539,7 @@ void MaskCollection::combineMasks(ofFbo &target, const Mask &mask, bool isFirst)
 		}
 
 		ofSetColor(ofFloatColor::white);
-		maskFbo.draw(0, 0);
+		maskFbo->draw(0, 0);
 	}
 	ofPopStyle();
 	target.end();
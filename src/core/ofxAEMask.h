@@ -10,6 +10,7 @@ namespace ofx { namespace ae {
 
 class MaskProp;
 struct MaskAtomData;
+// The exported feather vector; AE feathers horizontally by inner and vertically by outer.
 struct MaskFeather {
 	float inner;
 	float outer;
@@ -47,6 +48,9 @@ public:
 
 	glm::vec2 evaluateAt(float t) const;
 	void generatePolyline(ofPolyline& polyline, int resolution = 100) const;
+	// Appends the outline as a closed polygon; curves are split until they are
+	// no further than tolerance pixels from the polygon.
+	void flatten(std::vector<glm::vec2>& dst, float tolerance = 0.1f) const;
 	
 	void setFromPathData(const PathData& pathData);
 	ofPath toOfPath() const;
@@ -101,7 +105,6 @@ private:
 	float expansion;
 
 	void renderPath(const MaskPath& path) const;
-	void applyFeather(ofFbo& target) const;
 };
 
 class MaskCollection {
@@ -119,7 +122,11 @@ public:
 
 	bool hasActiveMasks() const;
 
+	// Writes the combined mask to the red channel of target (rgb hold the same value, alpha is 1).
+	// Up to MAX_SINGLE_PASS_MASKS enabled masks are drawn in a single pass, including feather and expansion.
+	// With more masks, each one is drawn into a temporary FBO and blended into target, without feather.
 	void renderCombined(ofFbo& target) const;
+	static constexpr int MAX_SINGLE_PASS_MASKS = 64;
 	
 	void setupFromMaskProp(const MaskProp& maskProp);
 	bool empty() const { return masks.empty(); }
@@ -129,6 +136,7 @@ public:
 private:
 	std::vector<Mask> masks;
 
+	void renderSinglePass(ofFbo& target) const;
 	void combineMasks(ofFbo& target, const Mask& mask, bool isFirst) const;
 };
 
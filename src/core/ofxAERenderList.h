@@ -0,0 +1,62 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ofMatrix4x4.h"
+#include "ofRectangle.h"
+#include "../data/Enums.h"
+#include "../data/MaskData.h"
+#include "../utils/ofxAETimeUtils.h"
+
+namespace ofx { namespace ae {
+
+class Layer;
+class LayerSource;
+struct ShapeData;
+
+// Plain-data snapshot of one layer as it would be drawn. Holds no GL objects.
+struct RenderItem {
+	const Layer *layer = nullptr;
+	std::string name;
+	// false for layers that are only used as a track matte
+	bool visible = true;
+
+	ofMatrix4x4 world_matrix;
+	float opacity = 1.f;
+	BlendMode blend_mode = BlendMode::NORMAL;
+
+	SourceType source_type = SourceType::UNKNOWN;
+	const LayerSource *source = nullptr;
+	Frame source_frame = 0.0f;
+	// source rectangle in layer space; empty for shapes, whose geometry is in shape
+	ofRectangle bounds;
+
+	// SHAPE: bezier geometry and styles as evaluated by the shape properties
+	std::shared_ptr<const ShapeData> shape;
+	std::vector<MaskAtomData> masks;
+
+	const Layer *track_matte = nullptr;
+	TrackMatteType track_matte_type = TrackMatteType::NO_TRACK_MATTE;
+	bool is_track_matte = false;
+
+	// COMPOSITION: items of the nested composition in its own space
+	std::vector<RenderItem> children;
+};
+
+// Result of Composition::evaluate(). Items are in draw order (bottom layer first).
+struct RenderList {
+	Frame frame = 0.0f;
+	float width = 0.f;
+	float height = 0.f;
+	std::vector<RenderItem> items;
+
+	void clear() {
+		frame = 0.0f;
+		width = height = 0.f;
+		items.clear();
+	}
+};
+
+}} // namespace ofx::ae
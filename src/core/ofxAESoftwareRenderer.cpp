@@ -0,0 +1,910 @@
+#include "ofxAESoftwareRenderer.h"
+
+#include "ofxAEComposition.h"
+#include "ofxAEMask.h"
+#include "../source/ofxAESolidSource.h"
+#include "../source/ofxAEStillSource.h"
+#include "../source/ofxAESequenceSource.h"
+#include "../utils/ofxAEAssetManager.h"
+#include "../utils/ofxAEThreadPool.h"
+#include "../utils/ofxAEVisitorUtils.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace ofx { namespace ae {
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+double millisSince(Clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// 2D part of an ofMatrix4x4: x' = a*x + c*y + tx, y' = b*x + d*y + ty
+struct Affine {
+	float a = 1, b = 0, c = 0, d = 1, tx = 0, ty = 0;
+
+	static Affine from(const ofMatrix4x4 &m) {
+		return {m(0,0), m(0,1), m(1,0), m(1,1), m(3,0), m(3,1)};
+	}
+	glm::vec2 apply(const glm::vec2 &p) const {
+		return {a*p.x + c*p.y + tx, b*p.x + d*p.y + ty};
+	}
+	Affine inverse() const {
+		float det = a*d - b*c;
+		if(std::abs(det) < 1e-12f) {
+			// degenerate, e.g. scaled to 0; nothing maps back into the layer
+			return {0, 0, 0, 0, std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+		}
+		Affine ret{d/det, -b/det, -c/det, a/det, 0, 0};
+		ret.tx = -(ret.a*tx + ret.c*ty);
+		ret.ty = -(ret.b*tx + ret.d*ty);
+		return ret;
+	}
+	// how many pixels one unit covers, averaged over the directions
+	float getScale() const { return std::sqrt(std::abs(a*d - b*c)); }
+};
+
+struct Bounds {
+	glm::vec2 min{std::numeric_limits<float>::max()};
+	glm::vec2 max{std::numeric_limits<float>::lowest()};
+
+	bool isEmpty() const { return min.x > max.x || min.y > max.y; }
+	void add(const glm::vec2 &p) {
+		min = glm::min(min, p);
+		max = glm::max(max, p);
+	}
+	void add(const Bounds &b) {
+		if(b.isEmpty()) return;
+		add(b.min);
+		add(b.max);
+	}
+	void grow(float margin) {
+		if(isEmpty()) return;
+		min -= glm::vec2(margin);
+		max += glm::vec2(margin);
+	}
+};
+
+// fill edge in pixels, y0 < y1; dir is +1 if the outline runs downwards
+struct Edge {
+	float x0, y0, x1, y1;
+	int dir;
+};
+struct Segment {
+	glm::vec2 a, b;
+};
+
+// a RenderGroupItem or RenderPathItem of PathExtractionVisitor, in pixels
+struct ShapeNode {
+	BlendMode blend_mode = BlendMode::NORMAL;
+	Bounds bounds;
+
+	// group
+	bool is_group = false;
+	bool is_isolated = false;	// composited on its own first, where RenderGroupItem::needFbo() uses an FBO
+	float opacity = 1;
+	std::vector<ShapeNode> children;
+
+	// path
+	std::vector<Edge> edges;
+	ofPolyWindingMode winding = OF_POLY_WINDING_NONZERO;
+	ofFloatColor fill_color;
+	bool is_filled = false;
+	std::vector<Segment> segments;
+	ofFloatColor stroke_color;
+	float stroke_width = 0;
+};
+
+// a mask flattened to segments in layer space, with the parameters of the mask shader
+struct MaskShape {
+	std::vector<Segment> segments;
+	Bounds bounds;
+	MaskMode mode = MaskMode::ADD;
+	bool inverted = false;
+	float opacity = 1;
+	float expansion = 0;
+	glm::vec2 feather{0,0};
+};
+
+void convertPath(const PathExtractionVisitor::RenderPathItem &src, const Affine &to_pixel, ShapeNode &dst)
+{
+	const auto &path = src.path;
+	dst.blend_mode = src.blend_mode;
+	dst.is_filled = path.isFilled();
+	dst.fill_color = path.getFillColor();
+	dst.winding = path.getWindingMode();
+	dst.stroke_color = path.getStrokeColor();
+	dst.stroke_width = path.hasOutline() ? path.getStrokeWidth() * to_pixel.getScale() : 0;
+
+	std::vector<glm::vec2> points;
+	for(const auto &outline : path.getOutline()) {
+		points.clear();
+		for(const auto &v : outline.getVertices()) {
+			points.push_back(to_pixel.apply(glm::vec2(v.x, v.y)));
+			dst.bounds.add(points.back());
+		}
+		size_t n = points.size();
+		if(n < 2) continue;
+		if(dst.is_filled) {
+			for(size_t i = 0; i < n; ++i) {
+				const auto &p0 = points[i];
+				const auto &p1 = points[(i + 1) % n];
+				if(p0.y == p1.y) continue;
+				if(p0.y < p1.y) dst.edges.push_back({p0.x, p0.y, p1.x, p1.y, 1});
+				else dst.edges.push_back({p1.x, p1.y, p0.x, p0.y, -1});
+			}
+		}
+		if(dst.stroke_width > 0) {
+			for(size_t i = 0; i + 1 < n; ++i) {
+				dst.segments.push_back({points[i], points[i + 1]});
+			}
+			if(outline.isClosed()) {
+				dst.segments.push_back({points[n - 1], points[0]});
+			}
+		}
+	}
+	dst.bounds.grow(dst.stroke_width * 0.5f + 1);
+}
+
+void convertGroup(const PathExtractionVisitor::RenderGroupItem &src, const ofMatrix4x4 &to_pixel, ShapeNode &dst)
+{
+	dst.is_group = true;
+	dst.is_isolated = src.needFbo();
+	dst.opacity = src.opacity;
+	dst.blend_mode = src.blend_mode;
+	ofMatrix4x4 transform = src.transform * to_pixel;
+	for(const auto &item : src.item) {
+		ShapeNode child;
+		if(auto group = dynamic_cast<const PathExtractionVisitor::RenderGroupItem*>(item.get())) {
+			convertGroup(*group, transform, child);
+		}
+		else if(auto path = dynamic_cast<const PathExtractionVisitor::RenderPathItem*>(item.get())) {
+			convertPath(*path, Affine::from(transform), child);
+		}
+		if(child.bounds.isEmpty()) continue;
+		dst.bounds.add(child.bounds);
+		dst.children.push_back(std::move(child));
+	}
+}
+
+void convertMasks(const std::vector<MaskAtomData> &src, std::vector<MaskShape> &dst)
+{
+	std::vector<glm::vec2> outline;
+	for(const auto &mask : src) {
+		MaskPath path;
+		path.setFromPathData(mask.shape);
+		outline.clear();
+		path.flatten(outline);
+		MaskShape shape;
+		for(size_t i = 0; i < outline.size(); ++i) {
+			shape.segments.push_back({outline[i], outline[(i + 1) % outline.size()]});
+			shape.bounds.add(outline[i]);
+		}
+		// same margin as MaskCollection::renderSinglePass()
+		glm::vec2 margin = glm::max(mask.feather, glm::vec2(1)) + std::max(mask.offset, 0.f);
+		shape.bounds.min -= margin;
+		shape.bounds.max += margin;
+		shape.mode = mask.mode;
+		shape.inverted = mask.inverted;
+		shape.opacity = ofClamp(mask.opacity, 0, 1);
+		shape.expansion = mask.offset;
+		shape.feather = mask.feather;
+		dst.push_back(std::move(shape));
+	}
+}
+
+// CPU version of the coverage() function of the mask shader
+float getMaskCoverage(const MaskShape &mask, const glm::vec2 &pos)
+{
+	if(pos.x < mask.bounds.min.x || pos.y < mask.bounds.min.y || pos.x > mask.bounds.max.x || pos.y > mask.bounds.max.y) {
+		return 0;
+	}
+	int winding = 0;
+	float dist2 = std::numeric_limits<float>::max();
+	glm::vec2 nearest(1, 0);
+	for(const auto &s : mask.segments) {
+		glm::vec2 e = s.b - s.a;
+		glm::vec2 pa = pos - s.a;
+		float t = ofClamp(glm::dot(pa, e) / std::max(glm::dot(e, e), 1e-12f), 0, 1);
+		glm::vec2 d = pa - e * t;
+		float dd = glm::dot(d, d);
+		if(dd < dist2) {
+			dist2 = dd;
+			nearest = d;
+		}
+		float side = e.x * pa.y - e.y * pa.x;
+		if(s.a.y <= pos.y) {
+			if(s.b.y > pos.y && side > 0) ++winding;
+		}
+		else if(s.b.y <= pos.y && side < 0) {
+			--winding;
+		}
+	}
+	float dist = std::sqrt(dist2);
+	float signed_dist = (winding != 0 ? dist : -dist) + mask.expansion;
+	glm::vec2 n = dist > 0 ? nearest / dist : glm::vec2(1, 0);
+	float width = 1 / glm::length(n / glm::max(mask.feather, glm::vec2(1)));
+	float k = ofClamp(0.5f + signed_dist / width, 0, 1);
+	return k * k * (3 - 2 * k);
+}
+
+bool isInside(int winding, ofPolyWindingMode mode)
+{
+	switch(mode) {
+		case OF_POLY_WINDING_ODD: return (winding & 1) != 0;
+		case OF_POLY_WINDING_POSITIVE: return winding > 0;
+		case OF_POLY_WINDING_NEGATIVE: return winding < 0;
+		case OF_POLY_WINDING_ABS_GEQ_TWO: return std::abs(winding) >= 2;
+		default: return winding != 0;
+	}
+}
+
+// B(source, backdrop) of the separable blend modes, on straight colors
+float blendChannel(BlendMode mode, float s, float d)
+{
+	switch(mode) {
+		case BlendMode::MULTIPLY: return s * d;
+		case BlendMode::SCREEN: return s + d - s * d;
+		case BlendMode::OVERLAY: return blendChannel(BlendMode::HARD_LIGHT, d, s);
+		case BlendMode::DARKEN: return std::min(s, d);
+		case BlendMode::LIGHTEN: return std::max(s, d);
+		case BlendMode::COLOR_DODGE:
+		case BlendMode::CLASSIC_COLOR_DODGE:
+			return d <= 0 ? 0 : (s >= 1 ? 1 : std::min(1.f, d / (1 - s)));
+		case BlendMode::COLOR_BURN:
+		case BlendMode::CLASSIC_COLOR_BURN:
+			return d >= 1 ? 1 : (s <= 0 ? 0 : 1 - std::min(1.f, (1 - d) / s));
+		case BlendMode::HARD_LIGHT:
+			return s <= 0.5f ? d * 2 * s : blendChannel(BlendMode::SCREEN, 2 * s - 1, d);
+		case BlendMode::SOFT_LIGHT: {
+			if(s <= 0.5f) return d - (1 - 2 * s) * d * (1 - d);
+			float dd = d <= 0.25f ? ((16 * d - 12) * d + 4) * d : std::sqrt(d);
+			return d + (2 * s - 1) * (dd - d);
+		}
+		case BlendMode::LINEAR_BURN: return std::max(0.f, s + d - 1);
+		case BlendMode::DIFFERENCE: return std::abs(s - d);
+		case BlendMode::EXCLUSION: return s + d - 2 * s * d;
+		case BlendMode::ADD:
+		case BlendMode::LINEAR_DODGE:
+			return std::min(1.f, s + d);
+		case BlendMode::SUBTRACT: return std::max(0.f, d - s);
+		default: return s;
+	}
+}
+
+// premultiplied RGBA in one plane per channel
+struct Buffer {
+	int size = 0;
+	std::vector<float> data;
+
+	explicit Buffer(int pixels) : size(pixels), data(pixels * 4, 0.f) {}
+	float* channel(int c) { return data.data() + c * size; }
+	const float* channel(int c) const { return data.data() + c * size; }
+	void clear() { std::fill(data.begin(), data.end(), 0.f); }
+};
+
+// pixel range inside a tile, x1 and y1 exclusive
+struct Area {
+	int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+	bool isEmpty() const { return x0 >= x1 || y0 >= y1; }
+};
+
+void blend(const Buffer &src, Buffer &dst, BlendMode mode, const Area &area, int stride)
+{
+	const float *sr = src.channel(0), *sg = src.channel(1), *sb = src.channel(2), *sa = src.channel(3);
+	float *dr = dst.channel(0), *dg = dst.channel(1), *db = dst.channel(2), *da = dst.channel(3);
+	for(int y = area.y0; y < area.y1; ++y) {
+		int begin = y * stride + area.x0, end = y * stride + area.x1;
+		if(mode == BlendMode::NORMAL || mode == BlendMode::DISSOLVE || mode == BlendMode::DANCING_DISSOLVE) {
+			for(int i = begin; i < end; ++i) {
+				float k = 1 - sa[i];
+				dr[i] = sr[i] + dr[i] * k;
+				dg[i] = sg[i] + dg[i] * k;
+				db[i] = sb[i] + db[i] * k;
+				da[i] = sa[i] + da[i] * k;
+			}
+			continue;
+		}
+		for(int i = begin; i < end; ++i) {
+			float as = sa[i], ad = da[i];
+			if(as <= 0) continue;
+			float s[3] = {sr[i], sg[i], sb[i]};
+			float *d[3] = {&dr[i], &dg[i], &db[i]};
+			for(int c = 0; c < 3; ++c) {
+				float cs = s[c] / as;
+				float cd = ad > 0 ? *d[c] / ad : 0;
+				*d[c] = s[c] * (1 - ad) + *d[c] * (1 - as) + as * ad * ofClamp(blendChannel(mode, cs, cd), 0, 1);
+			}
+			da[i] = as + ad - as * ad;
+		}
+	}
+}
+
+void multiply(Buffer &dst, const float *value, const Area &area, int stride)
+{
+	for(int c = 0; c < 4; ++c) {
+		float *p = dst.channel(c);
+		for(int y = area.y0; y < area.y1; ++y) {
+			for(int i = y * stride + area.x0, end = y * stride + area.x1; i < end; ++i) {
+				p[i] *= value[i];
+			}
+		}
+	}
+}
+
+void scale(Buffer &dst, float k, const Area &area, int stride)
+{
+	for(int c = 0; c < 4; ++c) {
+		float *p = dst.channel(c);
+		for(int y = area.y0; y < area.y1; ++y) {
+			for(int i = y * stride + area.x0, end = y * stride + area.x1; i < end; ++i) {
+				p[i] *= k;
+			}
+		}
+	}
+}
+
+// adds weight for the part of each pixel in [x0, x1) to row[lo..hi)
+void addSpan(float *row, float x0, float x1, int lo, int hi, float weight)
+{
+	x0 = std::max(x0, static_cast<float>(lo));
+	x1 = std::min(x1, static_cast<float>(hi));
+	if(x0 >= x1) return;
+	int i0 = static_cast<int>(x0);
+	int i1 = static_cast<int>(x1);
+	if(i0 == i1) {
+		row[i0] += (x1 - x0) * weight;
+		return;
+	}
+	row[i0] += (i0 + 1 - x0) * weight;
+	for(int i = i0 + 1; i < i1; ++i) {
+		row[i] += weight;
+	}
+	if(i1 < hi) {
+		row[i1] += (x1 - i1) * weight;
+	}
+}
+}
+
+struct SoftwareRenderer::Node {
+	const RenderItem *item = nullptr;
+	bool is_drawn = true;
+	Affine to_pixel;
+	Affine to_layer;
+	Bounds bounds;
+
+	// SOLID, STILL, SEQUENCE: content rectangle in layer space
+	ofRectangle rect;
+	ofFloatColor color;
+	std::shared_ptr<ofPixels> image;
+	// SHAPE
+	ShapeNode shape;
+	// COMPOSITION
+	std::vector<Node> children;
+
+	std::vector<MaskShape> masks;
+	const Node *matte = nullptr;
+};
+
+// Renders the nodes into one tile of the output.
+struct SoftwareRenderer::Tile {
+	static constexpr int SUBSAMPLES = 4;	// scanlines per pixel row for fills
+
+	int x0, y0, width, height;
+	size_t items = 0;
+
+	Tile(int x, int y, int w, int h) : x0(x), y0(y), width(w), height(h) {}
+
+	Buffer* acquire() {
+		Buffer *ret;
+		if(free_.empty()) {
+			buffers_.push_back(std::make_unique<Buffer>(width * height));
+			ret = buffers_.back().get();
+		}
+		else {
+			ret = free_.back();
+			free_.pop_back();
+		}
+		ret->clear();
+		return ret;
+	}
+	void release(Buffer *buffer) { free_.push_back(buffer); }
+
+	Area clip(const Bounds &bounds) const {
+		Area ret;
+		if(bounds.isEmpty()) return ret;
+		ret.x0 = std::max(0, static_cast<int>(std::floor(bounds.min.x)) - x0);
+		ret.y0 = std::max(0, static_cast<int>(std::floor(bounds.min.y)) - y0);
+		ret.x1 = std::min(width, static_cast<int>(std::ceil(bounds.max.x)) - x0);
+		ret.y1 = std::min(height, static_cast<int>(std::ceil(bounds.max.y)) - y0);
+		return ret;
+	}
+
+	void renderNodes(const std::vector<Node> &nodes, Buffer &dst) {
+		for(const auto &node : nodes) {
+			if(!node.is_drawn) continue;
+			Area area = clip(node.bounds);
+			if(area.isEmpty()) continue;
+			Buffer *layer = acquire();
+			renderLayer(node, *layer, area);
+			blend(*layer, dst, node.item->blend_mode, area, width);
+			release(layer);
+		}
+	}
+
+	// content, masks, track matte and opacity of one layer, into an empty buffer
+	void renderLayer(const Node &node, Buffer &dst, const Area &area) {
+		++items;
+		switch(node.item->source_type) {
+			case SourceType::SOLID:
+			case SourceType::STILL:
+			case SourceType::SEQUENCE:
+				drawRect(node, dst, area);
+				break;
+			case SourceType::SHAPE:
+				drawShape(node.shape, dst, 1);
+				break;
+			case SourceType::COMPOSITION:
+				renderNodes(node.children, dst);
+				break;
+			default:
+				break;
+		}
+		if(!node.masks.empty()) {
+			applyMasks(node, dst, area);
+		}
+		if(node.matte) {
+			applyMatte(node, dst, area);
+		}
+		if(node.item->opacity < 1) {
+			scale(dst, std::max(node.item->opacity, 0.f), area, width);
+		}
+	}
+
+	void drawRect(const Node &node, Buffer &dst, const Area &area) {
+		const auto &rect = node.rect;
+		if(rect.width <= 0 || rect.height <= 0) return;
+		const ofPixels *image = node.image.get();
+		if(node.item->source_type != SourceType::SOLID && (!image || !image->isAllocated())) return;
+		float *r = dst.channel(0), *g = dst.channel(1), *b = dst.channel(2), *a = dst.channel(3);
+		const auto &m = node.to_layer;
+		// edges are antialiased over one pixel
+		float scale = node.to_pixel.getScale();
+		for(int y = area.y0; y < area.y1; ++y) {
+			glm::vec2 p = m.apply(glm::vec2(x0 + area.x0 + 0.5f, y0 + y + 0.5f));
+			for(int x = area.x0; x < area.x1; ++x, p.x += m.a, p.y += m.b) {
+				float ex = std::min(p.x - rect.x, rect.x + rect.width - p.x) * scale + 0.5f;
+				float ey = std::min(p.y - rect.y, rect.y + rect.height - p.y) * scale + 0.5f;
+				if(ex <= 0 || ey <= 0) continue;
+				float coverage = std::min(ex, 1.f) * std::min(ey, 1.f);
+				int i = y * width + x;
+				if(!image) {
+					r[i] = node.color.r * coverage;
+					g[i] = node.color.g * coverage;
+					b[i] = node.color.b * coverage;
+					a[i] = coverage;
+					continue;
+				}
+				float c[4];
+				sample(*image, (p.x - rect.x) / rect.width, (p.y - rect.y) / rect.height, c);
+				float alpha = c[3] * coverage;
+				r[i] = c[0] * alpha;
+				g[i] = c[1] * alpha;
+				b[i] = c[2] * alpha;
+				a[i] = alpha;
+			}
+		}
+	}
+
+	// bilinear, straight RGBA in 0..1; u and v are 0..1 across the image
+	static void sample(const ofPixels &image, float u, float v, float *dst) {
+		int w = image.getWidth(), h = image.getHeight();
+		int channels = image.getNumChannels();
+		float fx = ofClamp(u * w - 0.5f, 0, w - 1);
+		float fy = ofClamp(v * h - 0.5f, 0, h - 1);
+		int ix = std::min(static_cast<int>(fx), w - 2 < 0 ? 0 : w - 2);
+		int iy = std::min(static_cast<int>(fy), h - 2 < 0 ? 0 : h - 2);
+		int ix1 = std::min(ix + 1, w - 1), iy1 = std::min(iy + 1, h - 1);
+		float tx = fx - ix, ty = fy - iy;
+		const unsigned char *data = image.getData();
+		auto texel = [&](int x, int y, float *c) {
+			const unsigned char *p = data + (static_cast<size_t>(y) * w + x) * channels;
+			if(channels >= 3) {
+				c[0] = p[0]; c[1] = p[1]; c[2] = p[2];
+				c[3] = channels == 4 ? p[3] : 255;
+			}
+			else {
+				c[0] = c[1] = c[2] = p[0];
+				c[3] = channels == 2 ? p[1] : 255;
+			}
+		};
+		float c00[4], c10[4], c01[4], c11[4];
+		texel(ix, iy, c00);
+		texel(ix1, iy, c10);
+		texel(ix, iy1, c01);
+		texel(ix1, iy1, c11);
+		for(int c = 0; c < 4; ++c) {
+			float top = c00[c] + (c10[c] - c00[c]) * tx;
+			float bottom = c01[c] + (c11[c] - c01[c]) * tx;
+			dst[c] = (top + (bottom - top) * ty) / 255.f;
+		}
+	}
+
+	void drawShape(const ShapeNode &group, Buffer &dst, float alpha) {
+		alpha *= group.opacity;
+		for(const auto &child : group.children) {
+			Area area = clip(child.bounds);
+			if(area.isEmpty()) continue;
+			if(child.is_group) {
+				if(!child.is_isolated) {
+					drawShape(child, dst, alpha);
+					continue;
+				}
+				Buffer *isolated = acquire();
+				drawShape(child, *isolated, alpha);
+				blend(*isolated, dst, child.blend_mode, area, width);
+				release(isolated);
+				continue;
+			}
+			if(child.is_filled && !child.edges.empty()) {
+				fill(child, area);
+				drawCoverage(child.fill_color, alpha, child.blend_mode, dst, area);
+			}
+			if(child.stroke_width > 0 && !child.segments.empty()) {
+				stroke(child, area);
+				drawCoverage(child.stroke_color, alpha, child.blend_mode, dst, area);
+			}
+		}
+	}
+
+	void drawCoverage(const ofFloatColor &color, float alpha, BlendMode mode, Buffer &dst, const Area &area) {
+		Buffer *src = acquire();
+		float a = color.a * alpha;
+		const float premultiplied[4] = {color.r * a, color.g * a, color.b * a, a};
+		for(int c = 0; c < 4; ++c) {
+			float *p = src->channel(c);
+			float k = premultiplied[c];
+			for(int y = area.y0; y < area.y1; ++y) {
+				for(int i = y * width + area.x0, end = y * width + area.x1; i < end; ++i) {
+					p[i] = coverage_[i] * k;
+				}
+			}
+		}
+		blend(*src, dst, mode, area, width);
+		release(src);
+	}
+
+	// Coverage of the fill into coverage_: SUBSAMPLES scanlines per row, each adding its spans
+	// with exact horizontal coverage at the span ends.
+	void fill(const ShapeNode &path, const Area &area) {
+		coverage_.assign(width * height, 0.f);
+		float top = y0 + area.y0, bottom = y0 + area.y1, right = x0 + area.x1;
+		edges_.clear();
+		for(const auto &e : path.edges) {
+			// edges left of the area still count for the winding
+			if(e.y1 <= top || e.y0 >= bottom || std::min(e.x0, e.x1) >= right) continue;
+			edges_.push_back(e);
+		}
+		const float weight = 1.f / SUBSAMPLES;
+		for(int y = area.y0; y < area.y1; ++y) {
+			float *row = coverage_.data() + y * width;
+			for(int s = 0; s < SUBSAMPLES; ++s) {
+				float sy = y0 + y + (s + 0.5f) * weight;
+				crossings_.clear();
+				for(const auto &e : edges_) {
+					if(e.y0 <= sy && sy < e.y1) {
+						float x = e.x0 + (sy - e.y0) * (e.x1 - e.x0) / (e.y1 - e.y0);
+						crossings_.emplace_back(x - x0, e.dir);
+					}
+				}
+				std::sort(crossings_.begin(), crossings_.end());
+				int winding = 0;
+				for(size_t i = 0; i < crossings_.size(); ++i) {
+					winding += crossings_[i].second;
+					if(isInside(winding, path.winding)) {
+						// the closing edge may have been left out as it is right of the area
+						float end = i + 1 < crossings_.size() ? crossings_[i + 1].first : area.x1;
+						addSpan(row, crossings_[i].first, end, area.x0, area.x1, weight);
+					}
+				}
+			}
+			for(int x = area.x0; x < area.x1; ++x) {
+				row[x] = std::min(row[x], 1.f);
+			}
+		}
+	}
+
+	// Coverage of the stroke into coverage_, from the distance to the outline (round joins and caps).
+	void stroke(const ShapeNode &path, const Area &area) {
+		coverage_.assign(width * height, 0.f);
+		float half = path.stroke_width * 0.5f;
+		float reach = std::max(half, 0.5f) + 0.5f;
+		// lines thinner than a pixel get fainter instead
+		float thin = std::min(path.stroke_width, 1.f);
+		segments_.clear();
+		for(const auto &s : path.segments) {
+			if(std::max(s.a.x, s.b.x) < x0 + area.x0 - reach || std::min(s.a.x, s.b.x) > x0 + area.x1 + reach ||
+			   std::max(s.a.y, s.b.y) < y0 + area.y0 - reach || std::min(s.a.y, s.b.y) > y0 + area.y1 + reach) {
+				continue;
+			}
+			segments_.push_back(s);
+		}
+		if(segments_.empty()) return;
+		for(int y = area.y0; y < area.y1; ++y) {
+			for(int x = area.x0; x < area.x1; ++x) {
+				glm::vec2 p(x0 + x + 0.5f, y0 + y + 0.5f);
+				float dist2 = std::numeric_limits<float>::max();
+				for(const auto &s : segments_) {
+					glm::vec2 e = s.b - s.a;
+					glm::vec2 pa = p - s.a;
+					float t = ofClamp(glm::dot(pa, e) / std::max(glm::dot(e, e), 1e-12f), 0, 1);
+					glm::vec2 d = pa - e * t;
+					dist2 = std::min(dist2, glm::dot(d, d));
+				}
+				coverage_[y * width + x] = ofClamp(reach - std::sqrt(dist2), 0, 1) * thin;
+			}
+		}
+	}
+
+	// combined like the mask shader, in layer space
+	void applyMasks(const Node &node, Buffer &dst, const Area &area) {
+		value_.assign(width * height, 0.f);
+		const auto &m = node.to_layer;
+		for(int y = area.y0; y < area.y1; ++y) {
+			glm::vec2 pos = m.apply(glm::vec2(x0 + area.x0 + 0.5f, y0 + y + 0.5f));
+			for(int x = area.x0; x < area.x1; ++x, pos.x += m.a, pos.y += m.b) {
+				float value = 0;
+				for(size_t i = 0; i < node.masks.size(); ++i) {
+					const auto &mask = node.masks[i];
+					float c = getMaskCoverage(mask, pos);
+					float v = mask.opacity * (mask.inverted ? 1 - c : c);
+					if(i == 0) {
+						value = v;
+						continue;
+					}
+					switch(mask.mode) {
+						case MaskMode::ADD: value = std::min(value + v, 1.f); break;
+						case MaskMode::SUBTRACT: value = std::max(value - v, 0.f); break;
+						case MaskMode::INTERSECT: value *= v; break;
+						case MaskMode::LIGHTEN: value = std::max(value, v); break;
+						case MaskMode::DARKEN: value = std::min(value, v); break;
+						case MaskMode::DIFFERENCE: value = std::abs(value - v); break;
+						default: break;
+					}
+				}
+				value_[y * width + x] = value;
+			}
+		}
+		multiply(dst, value_.data(), area, width);
+	}
+
+	void applyMatte(const Node &node, Buffer &dst, const Area &area) {
+		Buffer *matte = acquire();
+		Area matte_area = clip(node.matte->bounds);
+		if(!matte_area.isEmpty()) {
+			renderLayer(*node.matte, *matte, matte_area);
+		}
+		auto type = node.item->track_matte_type;
+		bool is_luma = type == TrackMatteType::LUMA || type == TrackMatteType::LUMA_INVERTED;
+		bool is_inverted = type == TrackMatteType::ALPHA_INVERTED || type == TrackMatteType::LUMA_INVERTED;
+		const float *r = matte->channel(0), *g = matte->channel(1), *b = matte->channel(2), *a = matte->channel(3);
+		value_.assign(width * height, 0.f);
+		for(int y = area.y0; y < area.y1; ++y) {
+			for(int i = y * width + area.x0, end = y * width + area.x1; i < end; ++i) {
+				float v = is_luma ? 0.2126f * r[i] + 0.7152f * g[i] + 0.0722f * b[i] : a[i];
+				value_[i] = is_inverted ? 1 - v : v;
+			}
+		}
+		release(matte);
+		multiply(dst, value_.data(), area, width);
+	}
+
+	// straight alpha, 8 bits
+	void write(const Buffer &src, ofPixels &dst) const {
+		const float *r = src.channel(0), *g = src.channel(1), *b = src.channel(2), *a = src.channel(3);
+		unsigned char *data = dst.getData();
+		size_t stride = dst.getWidth() * 4;
+		for(int y = 0; y < height; ++y) {
+			unsigned char *out = data + (y0 + y) * stride + x0 * 4;
+			for(int x = 0; x < width; ++x, out += 4) {
+				int i = y * width + x;
+				float alpha = ofClamp(a[i], 0, 1);
+				float k = alpha > 0 ? 255.f / alpha : 0;
+				out[0] = static_cast<unsigned char>(ofClamp(r[i] * k, 0, 255) + 0.5f);
+				out[1] = static_cast<unsigned char>(ofClamp(g[i] * k, 0, 255) + 0.5f);
+				out[2] = static_cast<unsigned char>(ofClamp(b[i] * k, 0, 255) + 0.5f);
+				out[3] = static_cast<unsigned char>(alpha * 255 + 0.5f);
+			}
+		}
+	}
+
+private:
+	std::vector<std::unique_ptr<Buffer>> buffers_;
+	std::vector<Buffer*> free_;
+	std::vector<float> coverage_;
+	std::vector<float> value_;
+	std::vector<Edge> edges_;
+	std::vector<Segment> segments_;
+	std::vector<std::pair<float, int>> crossings_;
+};
+
+std::shared_ptr<ofPixels> SoftwareRenderer::loadImage(const std::filesystem::path &path)
+{
+	if(path.empty()) {
+		return nullptr;
+	}
+	auto image = AssetManager::getInstance().getPixels(path);
+	if(image) {
+		images_.push_back(image);
+	}
+	return image;
+}
+
+void SoftwareRenderer::prepare(const std::vector<RenderItem> &items, const ofMatrix4x4 &to_pixel, std::vector<Node> &dst)
+{
+	dst.clear();
+	dst.reserve(items.size());
+	for(const auto &item : items) {
+		dst.emplace_back();
+		auto &node = dst.back();
+		node.item = &item;
+		node.is_drawn = item.visible && !item.is_track_matte;
+		ofMatrix4x4 matrix = item.world_matrix * to_pixel;
+		node.to_pixel = Affine::from(matrix);
+		node.to_layer = node.to_pixel.inverse();
+
+		switch(item.source_type) {
+			case SourceType::SOLID:
+				if(auto solid = dynamic_cast<const SolidSource*>(item.source)) {
+					// like SolidSource::draw(), which only sets rgb
+					const auto &color = solid->getColor();
+					node.color = ofFloatColor(color.r, color.g, color.b, 1);
+					node.rect = item.bounds;
+				}
+				break;
+			case SourceType::STILL:
+				if(auto still = dynamic_cast<const StillSource*>(item.source)) {
+					node.image = loadImage(still->getFilePath());
+					node.rect = item.bounds;
+				}
+				break;
+			case SourceType::SEQUENCE:
+				if(auto sequence = dynamic_cast<const SequenceSource*>(item.source)) {
+					node.image = loadImage(sequence->getFramePath(item.source_frame));
+					node.rect = item.bounds;
+				}
+				break;
+			case SourceType::SHAPE:
+				if(item.shape) {
+					// the shapes as ShapeSource draws them, without touching TessellationCache
+					PathExtractionVisitor visitor(false);
+					visitor.visit(*item.shape);
+					convertGroup(visitor.getRenderer(), matrix, node.shape);
+					node.bounds = node.shape.bounds;
+				}
+				break;
+			case SourceType::COMPOSITION:
+				prepare(item.children, matrix, node.children);
+				for(const auto &child : node.children) {
+					if(child.is_drawn) {
+						node.bounds.add(child.bounds);
+					}
+				}
+				break;
+			default:
+				stats_.skipped_items++;
+				break;
+		}
+		if(node.rect.width > 0 && node.rect.height > 0) {
+			const auto &r = node.rect;
+			for(auto corner : {glm::vec2(r.x, r.y), glm::vec2(r.x + r.width, r.y), glm::vec2(r.x, r.y + r.height), glm::vec2(r.x + r.width, r.y + r.height)}) {
+				node.bounds.add(node.to_pixel.apply(corner));
+			}
+			node.bounds.grow(1);
+		}
+		convertMasks(item.masks, node.masks);
+	}
+	// mattes are rendered where they are used
+	for(auto &node : dst) {
+		if(!node.item->track_matte) continue;
+		for(const auto &other : dst) {
+			if(other.item->layer == node.item->track_matte) {
+				node.matte = &other;
+				break;
+			}
+		}
+	}
+}
+
+void SoftwareRenderer::render(const RenderList &list, ofPixels &dst, int width, int height)
+{
+	if(width <= 0 || height <= 0) {
+		width = static_cast<int>(list.width);
+		height = static_cast<int>(list.height);
+	}
+	if(width <= 0 || height <= 0) {
+		dst.clear();
+		return;
+	}
+	dst.allocate(width, height, OF_PIXELS_RGBA);
+
+	auto start = Clock::now();
+	// keep the images of the last frame alive until this one has looked its own up
+	previous_images_.swap(images_);
+	images_.clear();
+	std::vector<Node> nodes;
+	float sx = list.width > 0 ? width / list.width : 1;
+	float sy = list.height > 0 ? height / list.height : 1;
+	prepare(list.items, ofMatrix4x4::newScaleMatrix(ofVec3f(sx, sy, 1)), nodes);
+	previous_images_.clear();
+	stats_.prepare_millis += millisSince(start);
+
+	start = Clock::now();
+	int tile_size = std::max(settings_.tile_size, 8);
+	int columns = (width + tile_size - 1) / tile_size;
+	int rows = (height + tile_size - 1) / tile_size;
+	size_t count = static_cast<size_t>(columns) * rows;
+	std::vector<size_t> items(count, 0);
+	auto renderTile = [&](size_t index) {
+		int x = static_cast<int>(index % columns) * tile_size;
+		int y = static_cast<int>(index / columns) * tile_size;
+		Tile tile(x, y, std::min(tile_size, width - x), std::min(tile_size, height - y));
+		Buffer *buffer = tile.acquire();
+		tile.renderNodes(nodes, *buffer);
+		tile.write(*buffer, dst);
+		items[index] = tile.items;
+	};
+	if(settings_.use_threads) {
+		ThreadPool::getShared().parallelFor(count, renderTile);
+	}
+	else {
+		for(size_t i = 0; i < count; ++i) {
+			renderTile(i);
+		}
+	}
+	stats_.raster_millis += millisSince(start);
+	stats_.frames++;
+	stats_.tiles += count;
+	for(auto n : items) {
+		stats_.items += n;
+	}
+}
+
+void SoftwareRenderer::render(Composition &comp, Frame frame, ofPixels &dst, int width, int height)
+{
+	comp.evaluate(frame, list_);
+	render(list_, dst, width, height);
+}
+
+SoftwareRenderer::Difference SoftwareRenderer::compare(const ofPixels &a, const ofPixels &b, int threshold)
+{
+	Difference ret;
+	if(a.getWidth() != b.getWidth() || a.getHeight() != b.getHeight() || a.getNumChannels() != b.getNumChannels()) {
+		ret.is_size_equal = false;
+		return ret;
+	}
+	size_t channels = a.getNumChannels();
+	size_t pixels = a.getWidth() * a.getHeight();
+	const unsigned char *pa = a.getData(), *pb = b.getData();
+	uint64_t total = 0;
+	for(size_t i = 0; i < pixels; ++i) {
+		int pixel_max = 0;
+		for(size_t c = 0; c < channels; ++c) {
+			int diff = std::abs(static_cast<int>(pa[i * channels + c]) - static_cast<int>(pb[i * channels + c]));
+			pixel_max = std::max(pixel_max, diff);
+			total += diff;
+		}
+		ret.max_difference = std::max(ret.max_difference, pixel_max);
+		if(pixel_max > threshold) {
+			ret.differing_pixels++;
+		}
+	}
+	ret.mean_difference = pixels > 0 ? static_cast<double>(total) / (pixels * channels) : 0.0;
+	return ret;
+}
+
+}} // namespace ofx::ae
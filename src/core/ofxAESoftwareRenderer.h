@@ -0,0 +1,82 @@
+#pragma once
+
+#include "ofxAERenderList.h"
+#include "ofMain.h"
+#include <memory>
+#include <vector>
+
+namespace ofx { namespace ae {
+
+class Composition;
+
+// Rasterizes a RenderList on the CPU, without a GL context: for thumbnails, export on machines
+// without a GPU, and pixel-diff regression tests against reference images (see compare()).
+// Covers solids, stills and image sequences (decoded through AssetManager::getPixels()), shape fills
+// and strokes, masks with feather and expansion, track mattes, nested compositions and the separable
+// blend modes. Video layers are skipped. The result is close to the GL renderer, not bit-exact.
+// The image is split into tiles that are rendered in parallel on ThreadPool::getShared(). Inside a tile,
+// fills are accumulated as coverage spans per scanline and composited row by row in float planes.
+// One instance renders one frame at a time; use an instance per thread to render frames in parallel.
+class SoftwareRenderer
+{
+public:
+	struct Settings {
+		int tile_size = 64;
+		bool use_threads = true;
+	};
+	struct Stats {
+		size_t frames = 0;
+		size_t tiles = 0;
+		size_t items = 0;			// items rasterized, once per tile they touch
+		size_t skipped_items = 0;	// items of source types that are not supported (video)
+		double prepare_millis = 0;	// totals
+		double raster_millis = 0;
+
+		void reset() {
+			frames = tiles = items = skipped_items = 0;
+			prepare_millis = raster_millis = 0;
+		}
+	};
+	// Per channel difference of two RGBA images.
+	struct Difference {
+		bool is_size_equal = true;
+		int max_difference = 0;			// 0..255
+		size_t differing_pixels = 0;	// pixels with a channel differing by more than the threshold
+		double mean_difference = 0;		// over all channels
+
+		bool isEqual() const { return is_size_equal && differing_pixels == 0; }
+	};
+
+	SoftwareRenderer() = default;
+	explicit SoftwareRenderer(const Settings &settings) : settings_(settings) {}
+
+	void setSettings(const Settings &settings) { settings_ = settings; }
+	const Settings& getSettings() const { return settings_; }
+
+	// Renders list into dst as RGBA with straight alpha, scaled to width x height.
+	// 0 for width or height uses the size of the list.
+	void render(const RenderList &list, ofPixels &dst, int width = 0, int height = 0);
+	// Evaluates comp at frame (see Composition::evaluate()) and renders it.
+	void render(Composition &comp, Frame frame, ofPixels &dst, int width = 0, int height = 0);
+
+	static Difference compare(const ofPixels &a, const ofPixels &b, int threshold = 0);
+
+	const Stats& getStats() const { return stats_; }
+	void resetStats() { stats_.reset(); }
+
+private:
+	struct Node;
+	struct Tile;
+
+	void prepare(const std::vector<RenderItem> &items, const ofMatrix4x4 &to_pixel, std::vector<Node> &dst);
+	std::shared_ptr<ofPixels> loadImage(const std::filesystem::path &path);
+
+	Settings settings_;
+	Stats stats_;
+	RenderList list_;
+	// images of the last frame, so the next one finds them in AssetManager's cache
+	std::vector<std::shared_ptr<ofPixels>> images_;
+	std::vector<std::shared_ptr<ofPixels>> previous_images_;
+};
+
+}} // namespace ofx::ae
@@ -1,4 +1,7 @@
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <unordered_map>
 
 #include "ofLog.h"
 #include "ofUtils.h"
@@ -7,33 +10,119 @@
 
 namespace ofx { namespace ae {
 
-AssetKey::AssetKey(const std::filesystem::path& path, AssetType type, const std::string& params)
-	: type_(type)
-	, parameters_(params)
+struct AssetKey::InternedPath {
+	std::filesystem::path path;
+	uint64_t hash;
+};
+
+namespace {
+constexpr uint64_t FNV_OFFSET = 14695981039346656037ULL;
+constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+
+uint64_t hashBytes(uint64_t h, const void *data, size_t size)
 {
-	canonicalizePath(path);
+	auto bytes = static_cast<const unsigned char*>(data);
+	for(size_t i = 0; i < size; ++i) {
+		h ^= bytes[i];
+		h *= FNV_PRIME;
+	}
+	return h;
 }
 
-void AssetKey::canonicalizePath(const std::filesystem::path& path)
+std::filesystem::path canonicalize(const std::filesystem::path& path)
 {
 	try {
 		if(std::filesystem::exists(path)) {
-			canonical_path_ = std::filesystem::canonical(path);
-		}
-		else {
-			canonical_path_ = std::filesystem::absolute(path);
+			return std::filesystem::canonical(path);
 		}
+		return std::filesystem::absolute(path).lexically_normal();
 	}
 	catch (const std::filesystem::filesystem_error& e) {
 		ofLogWarning("AssetKey") << "Failed to canonicalize path: " << path << " - " << e.what();
-		canonical_path_ = std::filesystem::absolute(path);
+		return std::filesystem::absolute(path).lexically_normal();
+	}
+}
+
+// Interned canonical paths live until the program ends, so keys can point at them.
+class PathTable
+{
+public:
+	using InternedPath = AssetKey::InternedPath;
+
+	const InternedPath* intern(const std::filesystem::path& path) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		auto found = by_input_.find(path.native());
+		if(found != by_input_.end()) {
+			return found->second;
+		}
+		// canonicalize the directory once; frames of a sequence share it
+		auto filename = path.filename();
+		std::filesystem::path canonical;
+		if(filename.empty() || filename == "." || filename == "..") {
+			canonical = canonicalize(path);
+		}
+		else {
+			auto directory = path.parent_path();
+			auto dir = directories_.find(directory.native());
+			if(dir == directories_.end()) {
+				dir = directories_.emplace(directory.native(), canonicalize(directory.empty() ? "." : directory)).first;
+			}
+			canonical = dir->second / filename;
+		}
+		auto &interned = interned_[canonical.native()];
+		if(!interned) {
+			interned = std::make_unique<InternedPath>();
+			interned->path = canonical;
+			const auto &str = canonical.native();
+			interned->hash = hashBytes(FNV_OFFSET, str.data(), str.size() * sizeof(str[0]));
+		}
+		by_input_.emplace(path.native(), interned.get());
+		return interned.get();
+	}
+
+	void clear() {
+		std::lock_guard<std::mutex> lock(mutex_);
+		by_input_.clear();
+		directories_.clear();
+	}
+
+	static PathTable& getInstance() {
+		static PathTable table;
+		return table;
 	}
+
+private:
+	std::mutex mutex_;
+	std::unordered_map<std::filesystem::path::string_type, const InternedPath*> by_input_;
+	std::unordered_map<std::filesystem::path::string_type, std::filesystem::path> directories_;
+	std::unordered_map<std::filesystem::path::string_type, std::unique_ptr<InternedPath>> interned_;
+};
+}
+
+AssetKey::AssetKey(const std::filesystem::path& path, AssetType type, const std::string& params)
+	: path_(PathTable::getInstance().intern(path))
+	, type_(type)
+	, parameters_(params)
+{
+	auto type_value = static_cast<int>(type_);
+	uint64_t h = hashBytes(path_->hash, &type_value, sizeof(type_value));
+	hash_ = hashBytes(h, parameters_.data(), parameters_.size());
+}
+
+const std::filesystem::path& AssetKey::getPath() const
+{
+	return path_->path;
+}
+
+void AssetKey::clearPathCache()
+{
+	PathTable::getInstance().clear();
 }
 
 bool AssetKey::operator<(const AssetKey& other) const
 {
-	if(canonical_path_ != other.canonical_path_) {
-		return canonical_path_ < other.canonical_path_;
+	if(path_ != other.path_) {
+		return path_->path < other.path_->path;
 	}
 	if(type_ != other.type_) {
 		return type_ < other.type_;
@@ -43,7 +132,9 @@ bool AssetKey::operator<(const AssetKey& other) const
 
 bool AssetKey::operator==(const AssetKey& other) const
 {
-	return canonical_path_ == other.canonical_path_ &&
+	// interned, so equal paths are the same object
+	return hash_ == other.hash_ &&
+		path_ == other.path_ &&
 		type_ == other.type_ &&
 		parameters_ == other.parameters_;
 }
@@ -56,22 +147,13 @@ bool AssetKey::operator!=(const AssetKey& other) const
 std::string AssetKey::toString() const
 {
 	std::ostringstream oss;
-	oss << assetTypeToString(type_) << ":" << canonical_path_.string();
+	oss << assetTypeToString(type_) << ":" << path_->path.string();
 	if(!parameters_.empty()) {
 		oss << "?" << parameters_;
 	}
 	return oss.str();
 }
 
-std::size_t AssetKey::hash() const
-{
-	std::size_t h1 = std::hash<std::string>{}(canonical_path_.string());
-	std::size_t h2 = std::hash<int>{}(static_cast<int>(type_));
-	std::size_t h3 = std::hash<std::string>{}(parameters_);
-	
-	return h1 ^ (h2 << 1) ^ (h3 << 2);
-}
-
 std::string AssetKey::assetTypeToString(AssetType type)
 {
 	switch (type) {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <filesystem>
 #include <string>
 #include <functional>
@@ -15,28 +16,36 @@ public:
 		UNKNOWN
 	};
 
+	// Paths are canonicalized once per directory and interned, so building a key for
+	// a path that was seen before costs a hash lookup instead of file system calls.
 	AssetKey(const std::filesystem::path& path, AssetType type, const std::string& params = "");
 	
 	bool operator<(const AssetKey& other) const;
 	bool operator==(const AssetKey& other) const;
 	bool operator!=(const AssetKey& other) const;
 	
-	const std::filesystem::path& getPath() const { return canonical_path_; }
+	const std::filesystem::path& getPath() const;
 	AssetType getType() const { return type_; }
 	const std::string& getParameters() const { return parameters_; }
 	
 	std::string toString() const;
-	std::size_t hash() const;
+	std::size_t hash() const { return static_cast<std::size_t>(hash_); }
+	uint64_t hash64() const { return hash_; }
 
 	static std::string assetTypeToString(AssetType type);
 	static AssetType stringToAssetType(const std::string& typeStr);
 
+	// Forgets how paths and directories were resolved, e.g. after files were moved or symlinks changed.
+	// Keys that already exist are not affected.
+	static void clearPathCache();
+
+	struct InternedPath;	// defined in AssetKey.cpp
+
 private:
-	std::filesystem::path canonical_path_;
+	const InternedPath *path_;
 	AssetType type_;
 	std::string parameters_;
-	
-	void canonicalizePath(const std::filesystem::path& path);
+	uint64_t hash_;
 };
 
 }} // namespace ofx::ae
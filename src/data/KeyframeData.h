@@ -1,6 +1,7 @@
 #pragma once
 
-#include <vector>
+#include <array>
+#include <cstdint>
 
 namespace ofx { namespace ae {
 
@@ -22,15 +23,30 @@ public:
 		InterpolationType out_type = HOLD;
 		bool roving = false;
 		bool continuous = false;
+		// Written raw into compiled files; spelled out so those bytes are zero instead of
+		// uninitialised padding, and the same input always compiles to the same file.
+		uint8_t reserved[2] = {};
 		TemporalEase in_ease;
 		TemporalEase out_ease;
 	};
 
+	// Stored inline so that keyframes of plain value types stay trivially copyable.
 	struct SpatialTangents {
-		std::vector<float> in_tangent;
-		std::vector<float> out_tangent;
+		static constexpr int MAX_DIMENSIONS = 3;
+		std::array<float, MAX_DIMENSIONS> in_tangent{};
+		std::array<float, MAX_DIMENSIONS> out_tangent{};
+		uint8_t in_size = 0;
+		uint8_t out_size = 0;
+		// see InterpolationData::reserved
+		uint8_t reserved[2] = {};
+		
+		void addIn(float v) { if(in_size < MAX_DIMENSIONS) in_tangent[in_size++] = v; }
+		void addOut(float v) { if(out_size < MAX_DIMENSIONS) out_tangent[out_size++] = v; }
 	};
 
+	static_assert(sizeof(InterpolationData) == 28, "InterpolationData must not have implicit padding");
+	static_assert(sizeof(SpatialTangents) == 28, "SpatialTangents must not have implicit padding");
+
 	template<typename T>
 	struct Data {
 		Data(){}
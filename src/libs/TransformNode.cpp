@@ -21,6 +21,10 @@ TransformNode::TransformNode()
 
 void TransformNode::refreshMatrix()
 {
+	// world matrix only changes with the local transform or the parent chain
+	if(!isDirty(LOCAL | PARENT)) {
+		return;
+	}
 	if(isDirty(LOCAL)) {
 		calcLocalMatrix();
 		clsDirtyFlag(LOCAL);
@@ -55,6 +59,7 @@ void TransformNode::refreshMatrix()
 	else {
 		world_matrix_ptr_ = &local_matrix_;
 		is_world_matrix_identity_ = is_local_matrix_identity_;
+		clsDirtyFlag(PARENT);
 	}
 	if(isWorldMatrixIdentity()) {
 		world_matrix_inversed_ptr_ = world_matrix_ptr_;
@@ -1,6 +1,8 @@
 #include "ofxAEPlayer.h"
 #include "ofUtils.h"
 #include "ofGraphics.h"
+#include "utils/ofxAEAssetManager.h"
+#include "utils/ofxAEFboPool.h"
 
 namespace ofx { namespace ae {
 
@@ -14,6 +16,7 @@ Player::Player()
 	, last_update_time_(0.0f)
 	, target_time_(0.0)
 	, pixel_format_(OF_PIXELS_RGBA)
+	, is_readback_enabled_(false)
 	, use_fbo_(true)
 	, fbo_needs_update_(true)
 {
@@ -93,9 +96,14 @@ void Player::update()
 	}
 
 	composition_.update();
+	AssetManager::getInstance().update();
+	FboPool::getInstance().update();
 	
 	if(use_fbo_ && is_loaded_) {
 		renderToFbo();
+		if(is_readback_enabled_) {
+			pixel_reader_.readback(fbo_, pixel_format_);
+		}
 	}
 }
 
@@ -175,10 +183,15 @@ void Player::close()
 	is_paused_ = false;
 	is_frame_new_ = false;
 	target_time_ = 0.0;
+	pixel_reader_.clear();
 }
 
 bool Player::setPixelFormat(ofPixelFormat pixelFormat)
 {
+	if(!PixelReader::isFormatSupported(pixelFormat)) {
+		ofLogWarning("Player") << "Unsupported pixel format: " << pixelFormat;
+		return false;
+	}
 	pixel_format_ = pixelFormat;
 	return true;
 }
@@ -190,12 +203,21 @@ ofPixelFormat Player::getPixelFormat() const
 
 ofPixels& Player::getPixels()
 {
-	return dummy_pixels_;
+	is_readback_enabled_ = true;
+	return pixel_reader_.getPixels();
 }
 
 const ofPixels& Player::getPixels() const
 {
-	return dummy_pixels_;
+	return pixel_reader_.getPixels();
+}
+
+void Player::setReadbackEnabled(bool enabled)
+{
+	is_readback_enabled_ = enabled;
+	if(!enabled) {
+		pixel_reader_.clear();
+	}
 }
 
 float Player::getPosition() const
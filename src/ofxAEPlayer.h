@@ -3,6 +3,7 @@
 #include "ofVideoBaseTypes.h"
 #include "ofFbo.h"
 #include "core/ofxAEComposition.h"
+#include "utils/ofxAEPixelReader.h"
 
 namespace ofx { namespace ae {
 
@@ -28,11 +29,18 @@ public:
 	void update() override;
 	bool isFrameNew() const override;
 	void close() override;
+	// OF_PIXELS_RGBA, OF_PIXELS_RGB or OF_PIXELS_BGRA
 	bool setPixelFormat(ofPixelFormat pixelFormat) override;
 	ofPixelFormat getPixelFormat() const override;
 	
+	// The first call starts reading frames back in update(). Readback is asynchronous, so the
+	// pixels are a few frames behind the texture (see getReadbackStats()) and empty at first.
 	ofPixels& getPixels() override;
 	const ofPixels& getPixels() const override;
+	void setReadbackEnabled(bool enabled);
+	bool isReadbackEnabled() const { return is_readback_enabled_; }
+	// latency_millis and frames_behind tell how old getPixels() is
+	const PixelReader::Stats& getReadbackStats() const { return pixel_reader_.getStats(); }
 	
 	float getPosition() const override;
 	void setPosition(float pct) override;
@@ -83,8 +91,9 @@ private:
 	float last_update_time_;
 	double target_time_;
 	
-	ofPixels dummy_pixels_;
+	PixelReader pixel_reader_;
 	ofPixelFormat pixel_format_;
+	bool is_readback_enabled_;
 	
 	ofFbo fbo_;
 	bool use_fbo_;
@@ -0,0 +1,382 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+#include "ofColor.h"
+#include "../utils/ofxAECompiledIO.h"
+#include "../utils/ofxAETimeUtils.h"
+
+namespace ofx { namespace ae {
+
+// Float components of the value types that baked tracks can be compressed for.
+template<typename T>
+struct TrackComponents {
+	static constexpr int COUNT = 0;
+};
+
+template<>
+struct TrackComponents<float> {
+	static constexpr int COUNT = 1;
+	static float get(const float &value, int) { return value; }
+	static void set(float &value, int, float component) { value = component; }
+};
+
+template<int N>
+struct TrackComponents<glm::vec<N, float>> {
+	static constexpr int COUNT = N;
+	static float get(const glm::vec<N, float> &value, int i) { return value[i]; }
+	static void set(glm::vec<N, float> &value, int i, float component) { value[i] = component; }
+};
+
+template<>
+struct TrackComponents<ofFloatColor> {
+	static constexpr int COUNT = 4;
+	static float get(const ofFloatColor &value, int i) { return value[i]; }
+	static void set(ofFloatColor &value, int i, float component) { value[i] = component; }
+};
+
+// Opt-in compression of baked tracks (see BakedTrack) set up or read after the call.
+// The tolerance is relative to the value range of each component of a track,
+// e.g. 0.001 allows 1 pixel of error on a position that moves across 1000 pixels.
+struct TrackCompression {
+	// 0, the default, keeps baked tracks uncompressed.
+	static void setTolerance(float tolerance) { storage().store(std::max(tolerance, 0.f), std::memory_order_relaxed); }
+	static float getTolerance() { return storage().load(std::memory_order_relaxed); }
+	static bool isEnabled() { return getTolerance() > 0.f; }
+
+private:
+	static std::atomic<float>& storage() {
+		static std::atomic<float> tolerance{0.f};
+		return tolerance;
+	}
+};
+
+// A baked track with fewer keys and smaller ones:
+// - frames that are within the error budget of a straight line between their neighbours are dropped,
+// - each component is quantized to a step of tolerance * (its range), per track,
+// - keys store 16 bit deltas to the previous key, in blocks of BLOCK_SIZE keys that start from
+//   absolute values, so a lookup decodes at most one block.
+// Values between keys are linear. The error is at most tolerance * range per component;
+// half of it is spent on dropping keys and half on quantization. Components that never change are stored exactly.
+template<typename T>
+class CompressedTrack
+{
+public:
+	static constexpr int COMPONENTS = TrackComponents<T>::COUNT;
+	static constexpr size_t BLOCK_SIZE = 16;
+	// longest run of frames replaced by one line, to bound the work of building
+	static constexpr int MAX_SEGMENT = 256;
+
+	static bool isSupported() { return COMPONENTS > 0; }
+
+	// Returns nullptr if the type is not supported or the track would not get smaller.
+	static std::shared_ptr<CompressedTrack> build(int first_frame, const std::vector<T> &values, float tolerance) {
+		if constexpr (COMPONENTS == 0) {
+			return nullptr;
+		}
+		else {
+			// below that, quantized values may not fit in 32 bits
+			if(values.size() < 2 || tolerance < 1e-8f) {
+				return nullptr;
+			}
+			auto ret = std::make_shared<CompressedTrack>();
+			ret->first_frame_ = first_frame;
+			ret->last_frame_ = first_frame + static_cast<int>(values.size()) - 1;
+			ret->setupQuantization(values, tolerance);
+			ret->encode(ret->reduceKeys(values), values);
+			ret->measureError(values);
+			ret->source_bytes_ = values.size() * sizeof(T);
+			if(ret->getBytes() >= ret->source_bytes_) {
+				return nullptr;
+			}
+			return ret;
+		}
+	}
+
+	T get(Frame frame) const {
+		T ret{};
+		if constexpr (COMPONENTS > 0) {
+			std::array<int32_t, COMPONENTS> q, next;
+			int key_frame, next_frame;
+			if(frame <= first_frame_ || frame >= last_frame_) {
+				// the first and last keys are always kept
+				size_t key = frame <= first_frame_ ? 0 : gaps_.size() - 1;
+				decodeKey(key, q, key_frame);
+				return dequantize(q, q, 0.f);
+			}
+			auto block = std::upper_bound(begin(blocks_), end(blocks_), frame, [](Frame f, const Block &b) {
+				return f < b.frame;
+			}) - 1;
+			size_t key = block->first_key;
+			size_t end_key = block + 1 == end(blocks_) ? gaps_.size() : (block + 1)->first_key;
+			q = block->base;
+			key_frame = block->frame;
+			for(++key; key < end_key; ++key) {
+				next_frame = key_frame + gaps_[key];
+				if(next_frame > frame) {
+					break;
+				}
+				key_frame = next_frame;
+				accumulate(q, key);
+			}
+			if(key < end_key) {
+				next = q;
+				accumulate(next, key);
+			}
+			else {
+				// the segment continues into the next block
+				next = (block + 1)->base;
+				next_frame = (block + 1)->frame;
+			}
+			return dequantize(q, next, static_cast<float>((frame - key_frame) / (next_frame - key_frame)));
+		}
+		return ret;
+	}
+
+	// The components of get(frame), in the order of TrackComponents<T>.
+	void getComponents(Frame frame, float *dst) const { toComponents(get(frame), dst); }
+	static void toComponents(const T &value, float *dst) {
+		if constexpr (COMPONENTS > 0) {
+			for(int c = 0; c < COMPONENTS; ++c) {
+				dst[c] = TrackComponents<T>::get(value, c);
+			}
+		}
+	}
+
+	int getFirstFrame() const { return first_frame_; }
+	size_t getFrameCount() const { return static_cast<size_t>(last_frame_ - first_frame_ + 1); }
+	size_t getKeyCount() const { return gaps_.size(); }
+	size_t getBytes() const {
+		return sizeof(*this) + blocks_.size() * sizeof(Block) + gaps_.size() * sizeof(uint16_t) + deltas_.size() * sizeof(int16_t);
+	}
+	// values of the uncompressed baked track
+	size_t getSourceBytes() const { return source_bytes_; }
+	// Largest difference to the uncompressed values over all frames, measured when building, in quantization steps
+	// (tolerance * range) of each component: at most 1 up to float rounding. Constant components are exact.
+	float getMaxError() const { return max_error_; }
+
+	void write(CompiledWriter &writer) const {
+		if constexpr (COMPONENTS > 0) {
+			writer.write<int32_t>(first_frame_);
+			writer.write<int32_t>(last_frame_);
+			writer.write(offset_);
+			writer.write(step_);
+			writer.write(max_error_);
+			writer.write<uint64_t>(source_bytes_);
+			writer.writeArray(blocks_);
+			writer.writeArray(gaps_);
+			writer.writeArray(deltas_);
+		}
+	}
+
+	static std::shared_ptr<CompressedTrack> read(CompiledReader &reader) {
+		if constexpr (COMPONENTS == 0) {
+			return nullptr;
+		}
+		else {
+			auto ret = std::make_shared<CompressedTrack>();
+			uint64_t source_bytes;
+			if(!(reader.read(ret->first_frame_) && reader.read(ret->last_frame_)
+				 && reader.read(ret->offset_) && reader.read(ret->step_)
+				 && reader.read(ret->max_error_) && reader.read(source_bytes))) {
+				return nullptr;
+			}
+			ret->source_bytes_ = static_cast<size_t>(source_bytes);
+			uint32_t block_count, gap_count, delta_count;
+			auto blocks = reader.template readArray<Block>(block_count);
+			auto gaps = reader.template readArray<uint16_t>(gap_count);
+			auto deltas = reader.template readArray<int16_t>(delta_count);
+			if(!reader.isValid() || block_count == 0 || gap_count == 0
+			   || delta_count != static_cast<uint64_t>(gap_count) * COMPONENTS) {
+				return nullptr;
+			}
+			ret->blocks_.assign(blocks, blocks + block_count);
+			ret->gaps_.assign(gaps, gaps + gap_count);
+			ret->deltas_.assign(deltas, deltas + delta_count);
+			if(!ret->isConsistent()) {
+				return nullptr;
+			}
+			return ret;
+		}
+	}
+
+private:
+	static constexpr int STORED_COMPONENTS = std::max(COMPONENTS, 1);
+	struct Block {
+		int32_t frame;
+		uint32_t first_key;
+		std::array<int32_t, STORED_COMPONENTS> base;	// quantized values of the first key
+	};
+
+	void setupQuantization(const std::vector<T> &values, float tolerance) {
+		for(int c = 0; c < COMPONENTS; ++c) {
+			float min = std::numeric_limits<float>::max();
+			float max = std::numeric_limits<float>::lowest();
+			for(const auto &v : values) {
+				float x = TrackComponents<T>::get(v, c);
+				min = std::min(min, x);
+				max = std::max(max, x);
+			}
+			offset_[c] = min;
+			float range = max - min;
+			// 0 for a constant component, which then decodes to offset_ exactly
+			step_[c] = range > 0.f ? std::max(range * tolerance, std::numeric_limits<float>::min()) : 0.f;
+		}
+	}
+
+	// Indices of the frames kept as keys.
+	std::vector<size_t> reduceKeys(const std::vector<T> &values) const {
+		std::array<float, STORED_COMPONENTS> budget;
+		for(int c = 0; c < COMPONENTS; ++c) {
+			budget[c] = step_[c] * 0.5f;
+		}
+		auto fits = [&](size_t a, size_t b) {
+			for(size_t i = a + 1; i < b; ++i) {
+				float t = static_cast<float>(i - a) / (b - a);
+				for(int c = 0; c < COMPONENTS; ++c) {
+					float va = TrackComponents<T>::get(values[a], c);
+					float vb = TrackComponents<T>::get(values[b], c);
+					if(std::abs(va + (vb - va) * t - TrackComponents<T>::get(values[i], c)) > budget[c]) {
+						return false;
+					}
+				}
+			}
+			return true;
+		};
+		std::vector<size_t> keys{0};
+		size_t last = values.size() - 1;
+		while(keys.back() < last) {
+			size_t start = keys.back();
+			size_t end = start + 1;
+			while(end < last && end - start < MAX_SEGMENT && fits(start, end + 1)) {
+				++end;
+			}
+			keys.push_back(end);
+		}
+		return keys;
+	}
+
+	std::array<int32_t, STORED_COMPONENTS> quantize(const T &value) const {
+		std::array<int32_t, STORED_COMPONENTS> q{};
+		for(int c = 0; c < COMPONENTS; ++c) {
+			if(step_[c] > 0.f) {
+				q[c] = static_cast<int32_t>(std::lround((TrackComponents<T>::get(value, c) - offset_[c]) / step_[c]));
+			}
+		}
+		return q;
+	}
+
+	void encode(const std::vector<size_t> &keys, const std::vector<T> &values) {
+		std::array<int32_t, STORED_COMPONENTS> previous{};
+		size_t previous_index = 0;
+		for(size_t k = 0; k < keys.size(); ++k) {
+			auto q = quantize(values[keys[k]]);
+			bool fits = k > 0 && k - blocks_.back().first_key < BLOCK_SIZE;
+			for(int c = 0; c < COMPONENTS && fits; ++c) {
+				int32_t delta = q[c] - previous[c];
+				fits = delta >= std::numeric_limits<int16_t>::min() && delta <= std::numeric_limits<int16_t>::max();
+			}
+			if(fits) {
+				gaps_.push_back(static_cast<uint16_t>(keys[k] - previous_index));
+				for(int c = 0; c < COMPONENTS; ++c) {
+					deltas_.push_back(static_cast<int16_t>(q[c] - previous[c]));
+				}
+			}
+			else {
+				blocks_.push_back({first_frame_ + static_cast<int32_t>(keys[k]), static_cast<uint32_t>(k), q});
+				gaps_.push_back(0);
+				deltas_.insert(end(deltas_), COMPONENTS, 0);
+			}
+			previous = q;
+			previous_index = keys[k];
+		}
+	}
+
+	void measureError(const std::vector<T> &values) {
+		max_error_ = 0.f;
+		for(size_t i = 0; i < values.size(); ++i) {
+			T decoded = get(static_cast<Frame>(first_frame_ + static_cast<int>(i)));
+			for(int c = 0; c < COMPONENTS; ++c) {
+				float error = std::abs(TrackComponents<T>::get(decoded, c) - TrackComponents<T>::get(values[i], c));
+				if(error > 0.f) {
+					max_error_ = std::max(max_error_, step_[c] > 0.f ? error / step_[c] : std::numeric_limits<float>::infinity());
+				}
+			}
+		}
+	}
+
+	// Whether blocks and keys are laid out as encode() writes them, which get() and decodeKey()
+	// rely on to stay in range: the first block starts at key 0 and the first frame, blocks start
+	// at increasing keys and frames, keys advance by at least one frame, and the last key is the last frame.
+	bool isConsistent() const {
+		if(blocks_.front().first_key != 0 || blocks_.front().frame != first_frame_ || first_frame_ >= last_frame_) {
+			return false;
+		}
+		size_t block = 0;
+		int64_t frame = first_frame_;
+		for(size_t key = 0; key < gaps_.size(); ++key) {
+			if(block < blocks_.size() && blocks_[block].first_key == key) {
+				if(gaps_[key] != 0 || (key > 0 && blocks_[block].frame <= frame)) {
+					return false;
+				}
+				frame = blocks_[block].frame;
+				++block;
+			}
+			else {
+				if(gaps_[key] == 0) {
+					return false;
+				}
+				frame += gaps_[key];
+			}
+		}
+		// a block left over starts past the last key, or its first_key did not increase
+		return block == blocks_.size() && frame == last_frame_;
+	}
+
+	void decodeKey(size_t key, std::array<int32_t, STORED_COMPONENTS> &q, int &frame) const {
+		auto block = std::upper_bound(begin(blocks_), end(blocks_), key, [](size_t k, const Block &b) {
+			return k < b.first_key;
+		}) - 1;
+		q = block->base;
+		frame = block->frame;
+		for(size_t k = block->first_key + 1; k <= key; ++k) {
+			frame += gaps_[k];
+			accumulate(q, k);
+		}
+	}
+
+	// plain loops over the (at most 4) components; the compiler may unroll them, they are not explicitly vectorized
+	void accumulate(std::array<int32_t, STORED_COMPONENTS> &q, size_t key) const {
+		const int16_t *delta = &deltas_[key * COMPONENTS];
+		for(int c = 0; c < COMPONENTS; ++c) {
+			q[c] += delta[c];
+		}
+	}
+
+	T dequantize(const std::array<int32_t, STORED_COMPONENTS> &a, const std::array<int32_t, STORED_COMPONENTS> &b, float ratio) const {
+		T ret{};
+		for(int c = 0; c < COMPONENTS; ++c) {
+			float q = a[c] + (b[c] - a[c]) * ratio;
+			TrackComponents<T>::set(ret, c, offset_[c] + q * step_[c]);
+		}
+		return ret;
+	}
+
+	int32_t first_frame_ = 0;
+	int32_t last_frame_ = 0;
+	std::array<float, STORED_COMPONENTS> offset_{};
+	std::array<float, STORED_COMPONENTS> step_{};
+	float max_error_ = 0.f;
+	size_t source_bytes_ = 0;
+	std::vector<Block> blocks_;
+	std::vector<uint16_t> gaps_;	// frames since the previous key; 0 for the first key of a block
+	std::vector<int16_t> deltas_;	// COMPONENTS per key: quantized change since the previous key
+};
+
+}} // namespace ofx::ae
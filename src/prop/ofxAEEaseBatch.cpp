@@ -0,0 +1,196 @@
+#include "ofxAEEaseBatch.h"
+#include "ofxAEKeyframe.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace ofx { namespace ae {
+
+namespace interpolation {
+
+namespace {
+// Each lane follows the scalar solveForX() step by step: same operations in the same order,
+// and a lane whose derivative gets too flat stops where the scalar loop would break.
+#if defined(__AVX2__)
+constexpr size_t LANES = 8;
+void solveLanes(const float *x_in, const float *p1_in, const float *p2_in, float *t_out)
+{
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.f);
+	const __m256 three = _mm256_set1_ps(3.f);
+	const __m256 six = _mm256_set1_ps(6.f);
+	const __m256 epsilon = _mm256_set1_ps(1e-6f);
+	const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+	__m256 x = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(x_in), zero), one);
+	__m256 p1 = _mm256_loadu_ps(p1_in);
+	__m256 p2 = _mm256_loadu_ps(p2_in);
+	__m256 t = x;
+	__m256 active = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+	for(int i = 0; i < 8; ++i) {
+		__m256 u = _mm256_sub_ps(one, t);
+		__m256 uu = _mm256_mul_ps(u, u);
+		__m256 tt = _mm256_mul_ps(t, t);
+		__m256 f = _mm256_add_ps(_mm256_add_ps(
+			_mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(three, uu), t), p1),
+			_mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(three, u), tt), p2)),
+			_mm256_mul_ps(tt, t));
+		f = _mm256_sub_ps(f, x);
+		__m256 df = _mm256_add_ps(_mm256_add_ps(
+			_mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(three, u), u), p1),
+			_mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(six, u), t), _mm256_sub_ps(p2, p1))),
+			_mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(three, t), t), _mm256_sub_ps(one, p2)));
+		active = _mm256_and_ps(active, _mm256_cmp_ps(_mm256_and_ps(df, abs_mask), epsilon, _CMP_GE_OQ));
+		if(_mm256_movemask_ps(active) == 0) {
+			break;
+		}
+		__m256 next = _mm256_min_ps(_mm256_max_ps(_mm256_sub_ps(t, _mm256_div_ps(f, df)), zero), one);
+		t = _mm256_blendv_ps(t, next, active);
+	}
+	_mm256_storeu_ps(t_out, t);
+}
+#elif defined(__SSE2__) || defined(_M_X64)
+constexpr size_t LANES = 4;
+void solveLanes(const float *x_in, const float *p1_in, const float *p2_in, float *t_out)
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.f);
+	const __m128 three = _mm_set1_ps(3.f);
+	const __m128 six = _mm_set1_ps(6.f);
+	const __m128 epsilon = _mm_set1_ps(1e-6f);
+	const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+	__m128 x = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(x_in), zero), one);
+	__m128 p1 = _mm_loadu_ps(p1_in);
+	__m128 p2 = _mm_loadu_ps(p2_in);
+	__m128 t = x;
+	__m128 active = _mm_castsi128_ps(_mm_set1_epi32(-1));
+	for(int i = 0; i < 8; ++i) {
+		__m128 u = _mm_sub_ps(one, t);
+		__m128 uu = _mm_mul_ps(u, u);
+		__m128 tt = _mm_mul_ps(t, t);
+		__m128 f = _mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(_mm_mul_ps(_mm_mul_ps(three, uu), t), p1),
+			_mm_mul_ps(_mm_mul_ps(_mm_mul_ps(three, u), tt), p2)),
+			_mm_mul_ps(tt, t));
+		f = _mm_sub_ps(f, x);
+		__m128 df = _mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(_mm_mul_ps(_mm_mul_ps(three, u), u), p1),
+			_mm_mul_ps(_mm_mul_ps(_mm_mul_ps(six, u), t), _mm_sub_ps(p2, p1))),
+			_mm_mul_ps(_mm_mul_ps(_mm_mul_ps(three, t), t), _mm_sub_ps(one, p2)));
+		active = _mm_and_ps(active, _mm_cmpge_ps(_mm_and_ps(df, abs_mask), epsilon));
+		if(_mm_movemask_ps(active) == 0) {
+			break;
+		}
+		__m128 next = _mm_min_ps(_mm_max_ps(_mm_sub_ps(t, _mm_div_ps(f, df)), zero), one);
+		t = _mm_or_ps(_mm_and_ps(active, next), _mm_andnot_ps(active, t));
+	}
+	_mm_storeu_ps(t_out, t);
+}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+constexpr size_t LANES = 4;
+void solveLanes(const float *x_in, const float *p1_in, const float *p2_in, float *t_out)
+{
+	const float32x4_t zero = vdupq_n_f32(0.f);
+	const float32x4_t one = vdupq_n_f32(1.f);
+	const float32x4_t three = vdupq_n_f32(3.f);
+	const float32x4_t six = vdupq_n_f32(6.f);
+	const float32x4_t epsilon = vdupq_n_f32(1e-6f);
+	float32x4_t x = vminq_f32(vmaxq_f32(vld1q_f32(x_in), zero), one);
+	float32x4_t p1 = vld1q_f32(p1_in);
+	float32x4_t p2 = vld1q_f32(p2_in);
+	float32x4_t t = x;
+	uint32x4_t active = vdupq_n_u32(0xffffffff);
+	for(int i = 0; i < 8; ++i) {
+		// vmulq/vaddq rather than vmlaq/vfmaq, which would round differently
+		float32x4_t u = vsubq_f32(one, t);
+		float32x4_t uu = vmulq_f32(u, u);
+		float32x4_t tt = vmulq_f32(t, t);
+		float32x4_t f = vaddq_f32(vaddq_f32(
+			vmulq_f32(vmulq_f32(vmulq_f32(three, uu), t), p1),
+			vmulq_f32(vmulq_f32(vmulq_f32(three, u), tt), p2)),
+			vmulq_f32(tt, t));
+		f = vsubq_f32(f, x);
+		float32x4_t df = vaddq_f32(vaddq_f32(
+			vmulq_f32(vmulq_f32(vmulq_f32(three, u), u), p1),
+			vmulq_f32(vmulq_f32(vmulq_f32(six, u), t), vsubq_f32(p2, p1))),
+			vmulq_f32(vmulq_f32(vmulq_f32(three, t), t), vsubq_f32(one, p2)));
+		active = vandq_u32(active, vcgeq_f32(vabsq_f32(df), epsilon));
+		if(vmaxvq_u32(active) == 0) {
+			break;
+		}
+		float32x4_t next = vminq_f32(vmaxq_f32(vsubq_f32(t, vdivq_f32(f, df)), zero), one);
+		t = vbslq_f32(active, next, t);
+	}
+	vst1q_f32(t_out, t);
+}
+#else
+constexpr size_t LANES = 1;
+void solveLanes(const float *x_in, const float *p1_in, const float *p2_in, float *t_out)
+{
+	*t_out = solveForX(*x_in, *p1_in, *p2_in);
+}
+#endif
+}
+
+void solveForX(const float *x, const float *p1x, const float *p2x, float *t, size_t count)
+{
+	size_t i = 0;
+	for(; i + LANES <= count; i += LANES) {
+		solveLanes(x + i, p1x + i, p2x + i, t + i);
+	}
+	for(; i < count; ++i) {
+		t[i] = solveForX(x[i], p1x[i], p2x[i]);
+	}
+}
+
+const char* getSolveForXInstructionSet()
+{
+#if defined(__AVX2__)
+	return "AVX2";
+#elif defined(__SSE2__) || defined(_M_X64)
+	return "SSE2";
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	return "NEON";
+#else
+	return "scalar";
+#endif
+}
+
+} // namespace interpolation
+
+EaseBatch::Ticket EaseBatch::add(Frame frame, float ratio, float p1x, float p2x)
+{
+	Ticket ret;
+	ret.batch_ = this;
+	ret.generation_ = generation_;
+	ret.index_ = x_.size();
+	ret.frame_ = frame;
+	x_.push_back(ratio);
+	p1x_.push_back(p1x);
+	p2x_.push_back(p2x);
+	is_solved_ = false;
+	return ret;
+}
+
+void EaseBatch::solve()
+{
+	t_.resize(x_.size());
+	interpolation::solveForX(x_.data(), p1x_.data(), p2x_.data(), t_.data(), x_.size());
+	is_solved_ = true;
+}
+
+void EaseBatch::clear()
+{
+	x_.clear();
+	p1x_.clear();
+	p2x_.clear();
+	t_.clear();
+	++generation_;
+	is_solved_ = false;
+}
+
+}} // namespace ofx::ae
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+#include "ofColor.h"
+#include "../utils/ofxAETimeUtils.h"
+
+namespace ofx { namespace ae {
+
+namespace interpolation {
+// solveForX() for count values at once, with SSE, AVX2 or NEON where the build enables them.
+// Takes the same steps as solveForX() for each, so results only differ where the compiler
+// fuses multiply-adds in the scalar code.
+void solveForX(const float *x, const float *p1x, const float *p2x, float *t, size_t count);
+// "AVX2", "SSE2", "NEON" or "scalar", as chosen when this was compiled.
+const char* getSolveForXInstructionSet();
+
+// Value types whose temporal bezier segments can be solved in an EaseBatch.
+template<typename T>
+struct IsEaseBatchable : std::is_same<T, float> {};
+template<int N>
+struct IsEaseBatchable<glm::vec<N, float>> : std::true_type {};
+template<>
+struct IsEaseBatchable<ofFloatColor> : std::true_type {};
+} // namespace interpolation
+
+// Temporal ease of many bezier segments, solved together.
+// Composition::setFrame() gathers the segments of every animated property at the frame,
+// solves them in one pass, and the properties pick up their result in setFrame() instead of
+// each running solveForX() on its own.
+class EaseBatch
+{
+public:
+	// Where a property finds its solved ease. Only valid for the frame it was added for,
+	// until the batch is cleared.
+	class Ticket {
+	public:
+		// Sets eased and forgets the ticket if it is valid for frame.
+		bool take(Frame frame, float &eased) {
+			if(!batch_ || batch_->generation_ != generation_ || !batch_->is_solved_ || frame != frame_) {
+				batch_ = nullptr;
+				return false;
+			}
+			eased = batch_->t_[index_];
+			batch_ = nullptr;
+			return true;
+		}
+		void reset() { batch_ = nullptr; }
+
+	private:
+		friend class EaseBatch;
+		const EaseBatch *batch_ = nullptr;
+		uint64_t generation_ = 0;
+		size_t index_ = 0;
+		Frame frame_ = 0;
+	};
+
+	// ratio, p1x and p2x as passed to solveForX().
+	Ticket add(Frame frame, float ratio, float p1x, float p2x);
+	void solve();
+	// Invalidates the tickets handed out so far.
+	void clear();
+
+	size_t size() const { return x_.size(); }
+	bool empty() const { return x_.empty(); }
+
+private:
+	std::vector<float> x_, p1x_, p2x_, t_;
+	uint64_t generation_ = 1;
+	bool is_solved_ = false;
+};
+
+}} // namespace ofx::ae
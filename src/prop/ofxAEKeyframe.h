@@ -2,7 +2,9 @@
 
 #include <cmath>
 #include <algorithm>
+#include <array>
 #include <map>
+#include <vector>
 #include "data/PathData.h"
 #include "data/Enums.h"
 #include "utils/ofxAEBlendMode.h"
@@ -77,19 +79,13 @@ inline ofFloatColor normalize(const ofFloatColor &a) {
 	return ofFloatColor{v.x,v.y,v.z,v.w};
 }
 
+// s is solveForX() of the ratio; see bezier().
 template<typename T>
-inline T bezier(const T &value_a, const T &value_b,
+inline T bezierEased(const T &value_a, const T &value_b,
 	 const Keyframe::TemporalEase &ease_out_a,
 	 const Keyframe::TemporalEase &ease_in_b,
-	 float dt, float ratio)
+	 float dt, float s)
 {
-	if(ratio<=0.f) return value_a;
-	if(ratio>=1.f) return value_b;
-	if(dt <= 0.f) return value_a;
-
-	const float p1x = ease_out_a.influence;
-	const float p2x = 1.f - ease_in_b.influence;
-
 	const T p0y = value_a;
 	const T p3y = value_b;
 
@@ -99,8 +95,6 @@ inline T bezier(const T &value_a, const T &value_b,
 	const T p1y = value_a + dir * (ease_out_a.speed * dt * ease_out_a.influence);
 	const T p2y = value_b - dir * (ease_in_b.speed * dt * ease_in_b.influence);
 
-	const float s = solveForX(ratio, p1x, p2x);
-
 	const float u = 1.f - s;
 	const T y = p0y*u*u*u
 			  + p1y*3*u*u*s
@@ -109,6 +103,21 @@ inline T bezier(const T &value_a, const T &value_b,
 	return y;
 }
 
+template<typename T>
+inline T bezier(const T &value_a, const T &value_b,
+	 const Keyframe::TemporalEase &ease_out_a,
+	 const Keyframe::TemporalEase &ease_in_b,
+	 float dt, float ratio)
+{
+	if(ratio<=0.f) return value_a;
+	if(ratio>=1.f) return value_b;
+	if(dt <= 0.f) return value_a;
+
+	const float p1x = ease_out_a.influence;
+	const float p2x = 1.f - ease_in_b.influence;
+	return bezierEased(value_a, value_b, ease_out_a, ease_in_b, dt, solveForX(ratio, p1x, p2x));
+}
+
 template<typename T>
 inline T evaluateBezier(const T &p0, const T &p1, const T &p2, const T &p3, float t) {
 	const float u = 1.f - t;
@@ -178,6 +187,63 @@ inline float findParameterForArcLength(const T &p0, const T &p1, const T &p2, co
 }
 
 
+// Cumulative arc length of one spatial bezier segment, sampled at uniform t.
+// Built once per segment so that evaluation is a table lookup instead of
+// re-integrating the curve every frame.
+struct ArcLengthTable {
+	static constexpr int SAMPLES = 64;
+	static constexpr int SUBSTEPS = 4;
+	std::array<float, SAMPLES+1> lengths{};
+	bool valid = false;
+
+	template<typename T>
+	void build(const T &p0, const T &p1, const T &p2, const T &p3) {
+		lengths[0] = 0.f;
+		T prev_point = p0;
+		float total_length = 0.f;
+		for(int i = 1; i <= SAMPLES; ++i) {
+			for(int j = 1; j <= SUBSTEPS; ++j) {
+				const float t = static_cast<float>((i-1) * SUBSTEPS + j) / static_cast<float>(SAMPLES * SUBSTEPS);
+				const T current_point = evaluateBezier(p0, p1, p2, p3, t);
+				total_length += glm::length(current_point - prev_point);
+				prev_point = current_point;
+			}
+			lengths[i] = total_length;
+		}
+		valid = true;
+	}
+
+	float getTotalLength() const { return lengths[SAMPLES]; }
+
+	// Curve parameter at which the given fraction of the total length is reached.
+	float findParameter(float ratio) const {
+		const float target = ratio * getTotalLength();
+		if(target <= 0.f) return 0.f;
+		if(target >= getTotalLength()) return 1.f;
+		auto upper = std::upper_bound(lengths.begin(), lengths.end(), target);
+		const int i = std::clamp(static_cast<int>(std::distance(lengths.begin(), upper)) - 1, 0, SAMPLES - 1);
+		const float segment = lengths[i+1] - lengths[i];
+		const float f = segment > 0.f ? (target - lengths[i]) / segment : 0.f;
+		return (static_cast<float>(i) + f) / static_cast<float>(SAMPLES);
+	}
+};
+
+template<typename T>
+inline T spatialBezierLinearTime(const T &value_a, const T &value_b,
+		  const T &out_tangent_a, const T &in_tangent_b,
+		  float ratio, const ArcLengthTable &table)
+{
+	if(ratio<=0.f) return value_a;
+	if(ratio>=1.f) return value_b;
+
+	const T p0 = value_a;
+	const T p1 = value_a + out_tangent_a;
+	const T p2 = value_b + in_tangent_b;
+	const T p3 = value_b;
+
+	return evaluateBezier(p0, p1, p2, p3, table.findParameter(ratio));
+}
+
 template<typename T>
 inline T spatialBezierLinearTime(const T &value_a, const T &value_b,
 		  const T &out_tangent_a, const T &in_tangent_b,
@@ -240,41 +306,68 @@ inline float temporalEase01(const Keyframe::TemporalEase &ease_out_a,
 	return s;
 }
 
+inline bool isSameTopology(const PathData &va, const PathData &vb)
+{
+	return va.vertices.size() == vb.vertices.size()
+		&& va.inTangents.size() == vb.inTangents.size()
+		&& va.outTangents.size() == vb.outTangents.size();
+}
+
+// Points of dst between va and vb, which must have the same topology. Writes into dst's
+// vectors, so an animated path does not allocate once dst has been as large as va.
+// The other members are left to the caller.
+inline void lerpPoints(PathData &dst, const PathData &va, const PathData &vb, float ratio)
+{
+	auto lerp = [ratio](std::vector<glm::vec2> &d, const std::vector<glm::vec2> &a, const std::vector<glm::vec2> &b) {
+		d.resize(a.size());
+		for(size_t i=0;i<a.size();++i)
+			d[i] = a[i] + (b[i] - a[i]) * ratio;
+	};
+	lerp(dst.vertices, va.vertices, vb.vertices);
+	lerp(dst.inTangents, va.inTangents, vb.inTangents);
+	lerp(dst.outTangents, va.outTangents, vb.outTangents);
+}
+
+// bezier<PathData>() into dst.
+inline void bezier(PathData &dst, const PathData &va, const PathData &vb,
+				   const Keyframe::TemporalEase &ease_out_a,
+				   const Keyframe::TemporalEase &ease_in_b,
+				   float ratio)
+{
+	if(!isSameTopology(va, vb)) {
+		dst = va;
+		return;
+	}
+	lerpPoints(dst, va, vb, temporalEase01(ease_out_a, ease_in_b, ratio));
+	dst.closed	 = vb.closed;
+	dst.direction = vb.direction;
+	dst.visible = va.visible;
+}
+
 template<>
 inline PathData bezier<PathData>(const PathData &va, const PathData &vb,
 								 const Keyframe::TemporalEase &ease_out_a,
 								 const Keyframe::TemporalEase &ease_in_b,
 								 float /*dt*/, float ratio)
 {
-	PathData ret = va;
-	if(va.vertices.size()!=vb.vertices.size()
-	 || va.inTangents.size()!=vb.inTangents.size()
-	 || va.outTangents.size()!=vb.outTangents.size()) {
-		return va;
-	}
-
-	const float eased = temporalEase01(ease_out_a, ease_in_b, ratio);
-
-	auto lerp = [&](const glm::vec2 &a, const glm::vec2 &b){
-		return a + (b - a) * eased;
-	};
-
-	ret.vertices.resize(va.vertices.size());
-	ret.inTangents.resize(va.inTangents.size());
-	ret.outTangents.resize(va.outTangents.size());
-
-	for(size_t i=0;i<ret.vertices.size();++i)
-		ret.vertices[i] = lerp(va.vertices[i], vb.vertices[i]);
-	for(size_t i=0;i<ret.inTangents.size();++i)
-		ret.inTangents[i] = lerp(va.inTangents[i], vb.inTangents[i]);
-	for(size_t i=0;i<ret.outTangents.size();++i)
-		ret.outTangents[i] = lerp(va.outTangents[i], vb.outTangents[i]);
-
-	ret.closed	 = vb.closed;
-	ret.direction = vb.direction;
+	PathData ret;
+	bezier(ret, va, vb, ease_out_a, ease_in_b, ratio);
 	return ret;
 }
 
+// linear() into dst: the points of va moved towards vb, if both have the same topology.
+inline void linear(PathData &dst, const PathData &va, const PathData &vb, float ratio)
+{
+	if(!isSameTopology(va, vb)) {
+		dst = va;
+		return;
+	}
+	lerpPoints(dst, va, vb, ratio);
+	dst.closed = va.closed;
+	dst.direction = va.direction;
+	dst.visible = va.visible;
+}
+
 template<typename T>
 bool hasSpatialTangents(const Keyframe::Data<T> &/*kf*/) {
 	return false;
@@ -282,9 +375,7 @@ bool hasSpatialTangents(const Keyframe::Data<T> &/*kf*/) {
 
 template<int N, typename T>
 bool hasSpatialTangents(const Keyframe::Data<glm::vec<N,T>> &kf) {
-	const auto &st_out = kf.spatial_tangents.out_tangent;
-	const auto &st_in  = kf.spatial_tangents.in_tangent;
-	return st_out.size() >= 2 && st_in.size() >= 2;
+	return kf.spatial_tangents.out_size >= 2 && kf.spatial_tangents.in_size >= 2;
 }
 
 template<typename T>
@@ -310,6 +401,44 @@ T calculate(const Keyframe::Data<T> &keyframe_a,
 	}
 }
 
+template<int N, typename T>
+void getSpatialTangents(const Keyframe::Data<glm::vec<N,T>> &keyframe_a,
+						const Keyframe::Data<glm::vec<N,T>> &keyframe_b,
+						glm::vec<N,T> &out_tangent, glm::vec<N,T> &in_tangent) {
+	out_tangent = glm::vec<N,T>{};
+	in_tangent = glm::vec<N,T>{};
+	for(int i = 0; i < std::min(N, 2); ++i) {
+		if(i < keyframe_a.spatial_tangents.out_size)
+			out_tangent[i] = static_cast<T>(keyframe_a.spatial_tangents.out_tangent[i]);
+		if(i < keyframe_b.spatial_tangents.in_size)
+			in_tangent[i] = static_cast<T>(keyframe_b.spatial_tangents.in_tangent[i]);
+	}
+}
+
+// Only linear-time segments with spatial tangents need an arc length table.
+template<typename T>
+void buildArcLengthTables(const std::vector<Keyframe::Data<T>> &/*keys*/, std::vector<ArcLengthTable> &tables) {
+	tables.clear();
+}
+
+template<int N, typename T>
+void buildArcLengthTables(const std::vector<Keyframe::Data<glm::vec<N,T>>> &keys, std::vector<ArcLengthTable> &tables) {
+	tables.clear();
+	for(size_t i = 0; i + 1 < keys.size(); ++i) {
+		const auto &a = keys[i];
+		const auto &b = keys[i+1];
+		if(a.interpolation.out_type != Keyframe::LINEAR || !hasSpatialTangents(a) || !hasSpatialTangents(b)) {
+			continue;
+		}
+		if(tables.empty()) {
+			tables.resize(keys.size() - 1);
+		}
+		glm::vec<N,T> out_tangent, in_tangent;
+		getSpatialTangents(a, b, out_tangent, in_tangent);
+		tables[i].build(a.value, a.value + out_tangent, b.value + in_tangent, b.value);
+	}
+}
+
 template<int N, typename T>
 glm::vec<N,T> calculate(const Keyframe::Data<glm::vec<N,T>> &keyframe_a,
 						const Keyframe::Data<glm::vec<N,T>> &keyframe_b,
@@ -317,13 +446,7 @@ glm::vec<N,T> calculate(const Keyframe::Data<glm::vec<N,T>> &keyframe_a,
 	if(hasSpatialTangents(keyframe_a) && hasSpatialTangents(keyframe_b)) {
 		glm::vec<N,T> out_tangent{};
 		glm::vec<N,T> in_tangent{};
-
-		for(int i = 0; i < std::min(N, 2); ++i) {
-			if(i < (int)keyframe_a.spatial_tangents.out_tangent.size())
-				out_tangent[i] = static_cast<T>(keyframe_a.spatial_tangents.out_tangent[i]);
-			if(i < (int)keyframe_b.spatial_tangents.in_tangent.size())
-				in_tangent[i] = static_cast<T>(keyframe_b.spatial_tangents.in_tangent[i]);
-		}
+		getSpatialTangents(keyframe_a, keyframe_b, out_tangent, in_tangent);
 
 		Keyframe::InterpolationType interp_type = keyframe_a.interpolation.out_type;
 
@@ -387,6 +510,121 @@ inline MaskMode calculate(const Keyframe::Data<MaskMode> &keyframe_a,
 	return ratio < 1.f ? keyframe_a.value : keyframe_b.value;
 }
 
+template<typename T>
+T calculate(const Keyframe::Data<T> &keyframe_a,
+			const Keyframe::Data<T> &keyframe_b,
+			float dt, float ratio, const ArcLengthTable &/*table*/) {
+	return calculate(keyframe_a, keyframe_b, dt, ratio);
+}
+
+template<int N, typename T>
+glm::vec<N,T> calculate(const Keyframe::Data<glm::vec<N,T>> &keyframe_a,
+						const Keyframe::Data<glm::vec<N,T>> &keyframe_b,
+						float /*dt*/, float ratio, const ArcLengthTable &table) {
+	glm::vec<N,T> out_tangent, in_tangent;
+	getSpatialTangents(keyframe_a, keyframe_b, out_tangent, in_tangent);
+	return spatialBezierLinearTime(keyframe_a.value, keyframe_b.value, out_tangent, in_tangent, ratio, table);
+}
+
+// calculate() into dst. Types other than PathData are simply assigned.
+template<typename T>
+void calculate(T &dst,
+			   const Keyframe::Data<T> &keyframe_a,
+			   const Keyframe::Data<T> &keyframe_b,
+			   float dt, float ratio, const ArcLengthTable *table) {
+	if(table && table->valid) {
+		dst = calculate(keyframe_a, keyframe_b, dt, ratio, *table);
+	}
+	else {
+		dst = calculate(keyframe_a, keyframe_b, dt, ratio);
+	}
+}
+
+inline void calculate(PathData &dst,
+					  const Keyframe::Data<PathData> &keyframe_a,
+					  const Keyframe::Data<PathData> &keyframe_b,
+					  float /*dt*/, float ratio, const ArcLengthTable */*table*/) {
+	switch(keyframe_a.interpolation.out_type) {
+		case Keyframe::HOLD:
+			dst = ratio >= 1.0f ? keyframe_b.value : keyframe_a.value;
+			break;
+		case Keyframe::BEZIER:
+			bezier(dst, keyframe_a.value, keyframe_b.value,
+				   keyframe_a.interpolation.out_ease,
+				   keyframe_b.interpolation.in_ease, ratio);
+			break;
+		default:
+			linear(dst, keyframe_a.value, keyframe_b.value, ratio);
+			break;
+	}
+}
+
+// A BEZIER segment whose temporal ease s was solved beforehand, e.g. in an EaseBatch.
+template<typename T>
+T calculateEased(const Keyframe::Data<T> &keyframe_a,
+				 const Keyframe::Data<T> &keyframe_b,
+				 float dt, float s) {
+	return bezierEased(keyframe_a.value, keyframe_b.value,
+					   keyframe_a.interpolation.out_ease,
+					   keyframe_b.interpolation.in_ease, dt, s);
+}
+
+template<int N, typename T>
+glm::vec<N,T> calculateEased(const Keyframe::Data<glm::vec<N,T>> &keyframe_a,
+							 const Keyframe::Data<glm::vec<N,T>> &keyframe_b,
+							 float dt, float s) {
+	if(hasSpatialTangents(keyframe_a) && hasSpatialTangents(keyframe_b)) {
+		glm::vec<N,T> out_tangent, in_tangent;
+		getSpatialTangents(keyframe_a, keyframe_b, out_tangent, in_tangent);
+		return evaluateBezier(keyframe_a.value, keyframe_a.value + out_tangent,
+							  keyframe_b.value + in_tangent, keyframe_b.value, s);
+	}
+	return bezierEased(keyframe_a.value, keyframe_b.value,
+					   keyframe_a.interpolation.out_ease,
+					   keyframe_b.interpolation.in_ease, dt, s);
+}
+
+// Blends two consecutive frames of baked animation; types that cannot be blended hold the earlier frame.
+template<typename T>
+inline T blendFrames(const T &value_a, const T &value_b, float ratio) {
+	return linear(value_a, value_b, ratio);
+}
+
+// blendFrames() into dst.
+template<typename T>
+inline void blendFrames(T &dst, const T &value_a, const T &value_b, float ratio) {
+	dst = blendFrames(value_a, value_b, ratio);
+}
+
+inline void blendFrames(PathData &dst, const PathData &value_a, const PathData &value_b, float ratio) {
+	linear(dst, value_a, value_b, ratio);
+}
+
+template<>
+inline bool blendFrames(const bool &value_a, const bool &/*value_b*/, float /*ratio*/) {
+	return value_a;
+}
+
+template<>
+inline BlendMode blendFrames(const BlendMode &value_a, const BlendMode &/*value_b*/, float /*ratio*/) {
+	return value_a;
+}
+
+template<>
+inline FillRule blendFrames(const FillRule &value_a, const FillRule &/*value_b*/, float /*ratio*/) {
+	return value_a;
+}
+
+template<>
+inline WindingDirection blendFrames(const WindingDirection &value_a, const WindingDirection &/*value_b*/, float /*ratio*/) {
+	return value_a;
+}
+
+template<>
+inline MaskMode blendFrames(const MaskMode &value_a, const MaskMode &/*value_b*/, float /*ratio*/) {
+	return value_a;
+}
+
 } // namespace interpolation
 
 template<typename T>
@@ -396,4 +634,25 @@ T interpolateKeyframe(const Keyframe::Data<T> &keyframe_a,
 	return interpolation::calculate(keyframe_a, keyframe_b, dt, ratio);
 }
 
+template<typename T>
+T interpolateKeyframe(const Keyframe::Data<T> &keyframe_a,
+					  const Keyframe::Data<T> &keyframe_b,
+					  float dt, float ratio,
+					  const interpolation::ArcLengthTable *arc_length_table) {
+	if(arc_length_table && arc_length_table->valid) {
+		return interpolation::calculate(keyframe_a, keyframe_b, dt, ratio, *arc_length_table);
+	}
+	return interpolation::calculate(keyframe_a, keyframe_b, dt, ratio);
+}
+
+// Writes into dst, reusing its storage where the type has any (PathData).
+template<typename T>
+void interpolateKeyframe(T &dst,
+						 const Keyframe::Data<T> &keyframe_a,
+						 const Keyframe::Data<T> &keyframe_b,
+						 float dt, float ratio,
+						 const interpolation::ArcLengthTable *arc_length_table) {
+	interpolation::calculate(dst, keyframe_a, keyframe_b, dt, ratio, arc_length_table);
+}
+
 }} // namespace ofx::ae
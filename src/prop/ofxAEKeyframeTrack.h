@@ -0,0 +1,327 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../data/KeyframeData.h"
+#include "ofxAEKeyframe.h"
+#include "../utils/ofxAETimeUtils.h"
+
+namespace ofx { namespace ae {
+
+// Sorted, contiguous keyframe storage used for evaluation.
+// Frames are kept in their own array so segment lookup only touches floats;
+// the caller keeps a cursor (index of the last segment) so sequential playback
+// finds the next segment without searching.
+template<typename T>
+class KeyframeTrack
+{
+public:
+	using Data = Keyframe::Data<T>;
+
+	KeyframeTrack() = default;
+	explicit KeyframeTrack(const std::map<Frame, Data> &keyframes) { build(keyframes); }
+
+	void build(const std::map<Frame, Data> &keyframes) {
+		clear();
+		reserve(keyframes.size());
+		for(auto &&[frame, kf] : keyframes) {
+			frames_.push_back(frame);
+			keys_.push_back(kf);
+		}
+		buildArcLengthTables();
+	}
+
+	// Adds keyframes from a builder; existing keyframes win on equal frames like std::map::insert.
+	void merge(const std::map<Frame, Data> &keyframes) {
+		if(empty()) {
+			build(keyframes);
+			return;
+		}
+		std::map<Frame, Data> merged;
+		toMap(merged);
+		merged.insert(begin(keyframes), end(keyframes));
+		build(merged);
+	}
+
+	void toMap(std::map<Frame, Data> &dst) const {
+		for(size_t i = 0; i < size(); ++i) {
+			dst.insert({frames_[i], keys_[i]});
+		}
+	}
+
+	// Appends a keyframe; frames must be added in ascending order.
+	// Call buildArcLengthTables() after the last one.
+	bool push_back(Frame frame, const Data &kf) {
+		if(!frames_.empty() && frame <= frames_.back()) {
+			return false;
+		}
+		frames_.push_back(frame);
+		keys_.push_back(kf);
+		return true;
+	}
+
+	void reserve(size_t size) {
+		frames_.reserve(size);
+		keys_.reserve(size);
+	}
+
+	void clear() {
+		frames_.clear();
+		keys_.clear();
+		arc_length_tables_.clear();
+	}
+	
+	void buildArcLengthTables() {
+		interpolation::buildArcLengthTables(keys_, arc_length_tables_);
+	}
+	
+	// Table for the segment starting at the given keyframe, or nullptr if that segment does not need one.
+	const interpolation::ArcLengthTable* getArcLengthTable(size_t segment) const {
+		if(segment >= arc_length_tables_.size() || !arc_length_tables_[segment].valid) {
+			return nullptr;
+		}
+		return &arc_length_tables_[segment];
+	}
+
+	bool empty() const { return frames_.empty(); }
+	size_t size() const { return frames_.size(); }
+	Frame getFrame(size_t index) const { return frames_[index]; }
+	const Data& getKeyframe(size_t index) const { return keys_[index]; }
+	const std::vector<Frame>& getFrames() const { return frames_; }
+	const std::vector<Data>& getKeyframes() const { return keys_; }
+
+	// Same result as util::findFrameKeyframePair on the equivalent map.
+	util::FrameKeyframePair<T> find(Frame frame, size_t &cursor) const {
+		util::FrameKeyframePair<T> result;
+		const size_t count = frames_.size();
+		if(count == 0) {
+			return result;
+		}
+		if(count == 1 || frame < frames_.front()) {
+			return single(0, result);
+		}
+		if(frame >= frames_.back()) {
+			return single(count - 1, result);
+		}
+
+		// segment i covers [frames_[i], frames_[i+1])
+		size_t i = std::min(cursor, count - 2);
+		if(!(frames_[i] <= frame && frame < frames_[i+1])) {
+			if(i + 2 < count && frames_[i+1] <= frame && frame < frames_[i+2]) {
+				++i;
+			}
+			else {
+				auto upper = std::upper_bound(frames_.begin(), frames_.end(), frame);
+				i = std::distance(frames_.begin(), upper) - 1;
+			}
+		}
+		cursor = i;
+
+		result.keyframe_a = &keys_[i];
+		result.keyframe_b = &keys_[i+1];
+		result.frame_a = frames_[i];
+		result.frame_b = frames_[i+1];
+		if(!util::isNearFrame(result.frame_b, result.frame_a)) {
+			result.ratio = static_cast<float>((frame - result.frame_a) / (result.frame_b - result.frame_a));
+		}
+		else {
+			result.ratio = 0.0f;
+		}
+		return result;
+	}
+
+private:
+	util::FrameKeyframePair<T>& single(size_t index, util::FrameKeyframePair<T> &result) const {
+		result.keyframe_a = &keys_[index];
+		result.keyframe_b = &keys_[index];
+		result.frame_a = frames_[index];
+		result.frame_b = frames_[index];
+		result.ratio = 0.0f;
+		return result;
+	}
+
+	std::vector<Frame> frames_;
+	std::vector<Data> keys_;
+	std::vector<interpolation::ArcLengthTable> arc_length_tables_;
+};
+
+// Values of consecutive integer frames, as exported with full frame animation (baking).
+// Holds only the values, and a frame is found by its offset from the first one.
+// Fractional frames blend the two neighbouring frames; frames outside the range hold the first or last value.
+template<typename T>
+class BakedTrack
+{
+public:
+	BakedTrack() = default;
+	BakedTrack(int first_frame, std::vector<T> values)
+	: first_frame_(first_frame)
+	, values_(std::move(values)) {}
+
+	bool empty() const { return values_.empty(); }
+	size_t size() const { return values_.size(); }
+	int getFirstFrame() const { return first_frame_; }
+	const std::vector<T>& getValues() const { return values_; }
+
+	T get(Frame frame) const {
+		float position = frame - first_frame_;
+		if(position <= 0.f) {
+			return values_.front();
+		}
+		size_t index = static_cast<size_t>(position);
+		if(index + 1 >= values_.size()) {
+			return values_.back();
+		}
+		float ratio = position - index;
+		if(ratio <= 0.f) {
+			return values_[index];
+		}
+		return interpolation::blendFrames(values_[index], values_[index+1], ratio);
+	}
+	// get() into dst, reusing its storage where the type has any (PathData).
+	void get(Frame frame, T &dst) const {
+		float position = frame - first_frame_;
+		if(position <= 0.f) {
+			dst = values_.front();
+			return;
+		}
+		size_t index = static_cast<size_t>(position);
+		if(index + 1 >= values_.size()) {
+			dst = values_.back();
+			return;
+		}
+		float ratio = position - index;
+		if(ratio <= 0.f) {
+			dst = values_[index];
+			return;
+		}
+		interpolation::blendFrames(dst, values_[index], values_[index+1], ratio);
+	}
+
+private:
+	int first_frame_ = 0;
+	std::vector<T> values_;
+};
+
+// Memory used by baked tracks, summed per composition while it loads.
+struct BakedTrackStats {
+	// A baked track stored as a CompressedTrack, for the report of each property.
+	struct Compressed {
+		std::string name;		// layer and property, e.g. "Layer 1/position"
+		size_t frames = 0;
+		size_t keys = 0;
+		size_t source_bytes = 0;	// values of the uncompressed baked track
+		size_t bytes = 0;
+		float max_error = 0;	// in quantization steps, see CompressedTrack::getMaxError()
+		int components = 0;
+		int first_frame = 0;
+		// Writes the components of the track at frame, decoded the way Property::setFrame() does.
+		std::function<void(Frame, float*)> decode;
+		// components of every frame before compression; only kept after setKeepSourceValues(true)
+		std::vector<float> source_values;
+
+		float getRatio() const { return bytes > 0 ? static_cast<float>(source_bytes) / bytes : 0.f; }
+	};
+
+	size_t properties = 0;
+	size_t frames = 0;
+	size_t bytes = 0;		// values stored in baked tracks
+	size_t saved_bytes = 0;	// compared to storing every frame as a keyframe
+	std::vector<Compressed> compressed;
+
+	// Names the tracks set up on the calling thread while it exists, by appending name to the enclosing ones.
+	class NameScope {
+	public:
+		explicit NameScope(const std::string &name) : length_(path().size()) { path() += name; }
+		~NameScope() { path().resize(length_); }
+		NameScope(const NameScope&) = delete;
+		NameScope& operator=(const NameScope&) = delete;
+	private:
+		size_t length_;
+	};
+
+	// Baked tracks set up on the calling thread are added to stats, until it is set to nullptr.
+	// Returns the previous collector, so that nested loads can restore it.
+	static BakedTrackStats* setCollector(BakedTrackStats *stats) {
+		std::swap(stats, collector());
+		return stats;
+	}
+	template<typename T>
+	static void add(const BakedTrack<T> &track) {
+		if(auto stats = collector()) {
+			stats->add(track.size(), track.size() * sizeof(T), sizeof(Frame) + sizeof(Keyframe::Data<T>));
+		}
+	}
+	// Track is a CompressedTrack<T>; values are the ones it was built from, if it was not read compressed.
+	template<typename T, typename Track>
+	static void addCompressed(const std::shared_ptr<Track> &track, const std::vector<T> *values = nullptr) {
+		if(auto stats = collector()) {
+			stats->add(track->getFrameCount(), track->getBytes(), sizeof(Frame) + sizeof(Keyframe::Data<T>));
+			Compressed entry;
+			entry.name = path();
+			entry.frames = track->getFrameCount();
+			entry.keys = track->getKeyCount();
+			entry.source_bytes = track->getSourceBytes();
+			entry.bytes = track->getBytes();
+			entry.max_error = track->getMaxError();
+			entry.components = Track::COMPONENTS;
+			entry.first_frame = track->getFirstFrame();
+			entry.decode = [track](Frame frame, float *dst) { track->getComponents(frame, dst); };
+			if(values && isKeepingSourceValues()) {
+				entry.source_values.resize(values->size() * Track::COMPONENTS);
+				for(size_t i = 0; i < values->size(); ++i) {
+					Track::toComponents((*values)[i], &entry.source_values[i * Track::COMPONENTS]);
+				}
+			}
+			stats->compressed.push_back(std::move(entry));
+		}
+	}
+	// Whether compressed tracks built afterwards keep the values they were built from in Compressed::source_values,
+	// so that they can be checked against the decoded track (tools/CheckComposition). Off by default.
+	static void setKeepSourceValues(bool keep) { keepSourceValues().store(keep, std::memory_order_relaxed); }
+	static bool isKeepingSourceValues() { return keepSourceValues().load(std::memory_order_relaxed); }
+
+	// Of all compressed tracks together.
+	float getCompressionRatio() const {
+		size_t source = 0, stored = 0;
+		for(const auto &c : compressed) {
+			source += c.source_bytes;
+			stored += c.bytes;
+		}
+		return stored > 0 ? static_cast<float>(source) / stored : 0.f;
+	}
+	float getMaxError() const {
+		float ret = 0;
+		for(const auto &c : compressed) {
+			ret = std::max(ret, c.max_error);
+		}
+		return ret;
+	}
+
+private:
+	void add(size_t frame_count, size_t stored_bytes, size_t keyframe_bytes) {
+		properties++;
+		frames += frame_count;
+		bytes += stored_bytes;
+		saved_bytes += frame_count * keyframe_bytes - stored_bytes;
+	}
+	static BakedTrackStats*& collector() {
+		thread_local BakedTrackStats *stats = nullptr;
+		return stats;
+	}
+	static std::string& path() {
+		thread_local std::string name;
+		return name;
+	}
+	static std::atomic<bool>& keepSourceValues() {
+		static std::atomic<bool> keep{false};
+		return keep;
+	}
+};
+
+}} // namespace ofx::ae
@@ -148,4 +148,15 @@ void MaskProp::setupMaskAtom(const ofJson &atomBase, const ofJson &atomKeyframes
 		PropertyArray::accept(visitor);
 	}
 
+PropertyBase* MaskProp::addPropertyForType(const std::string &type)
+{
+	if(type == "atom") return addProperty<MaskAtomProp>();
+	return addProperty<PropertyBase>();
+}
+
+std::string MaskProp::getPropertyType(size_t index) const
+{
+	return dynamic_cast<const MaskAtomProp*>(getProperty(index)) ? "atom" : "";
+}
+
 }} // namespace ofx::ae
@@ -47,6 +47,8 @@ public:
 	
 	void setup(const ofJson &base, const ofJson &keyframes) override;
 	void accept(Visitor &visitor) override;
+	PropertyBase* addPropertyForType(const std::string &type) override;
+	std::string getPropertyType(size_t index) const override;
 private:
 	void setupMaskAtom(const ofJson &atomBase, const ofJson &atomKeyframes);
 };
@@ -6,7 +6,12 @@
 #include <memory>
 #include "ofJson.h"
 #include "ofxAEKeyframe.h"
+#include "ofxAEKeyframeTrack.h"
+#include "ofxAECompressedTrack.h"
+#include "ofxAEEaseBatch.h"
 #include "../utils/ofxAETimeUtils.h"
+#include "../utils/ofxAECompiledIO.h"
+#include "../utils/ofxAEEvaluationStats.h"
 
 namespace ofx { namespace ae {
 
@@ -20,6 +25,9 @@ public:
 	virtual bool hasAnimation() const { return false; }
 	
 	virtual bool setFrame(Frame frame) { return false; }
+	// Adds the bezier segments that setFrame(frame) is going to interpolate to batch.
+	// Once the batch is solved, setFrame(frame) uses its results.
+	virtual void gatherEasing(Frame frame, EaseBatch &batch) {}
 	virtual Frame getFrame() const { return 0.0f; }
 	
 	virtual bool setTime(double time) { return false; }
@@ -28,6 +36,13 @@ public:
 	virtual void setup(const ofJson &base, const ofJson &keyframes={}) {}
 	virtual void setFps(float fps) {}
 	
+	virtual void write(CompiledWriter &writer) const {}
+	virtual bool read(CompiledReader &reader) { return true; }
+	
+	// Makes this a new instance of src, which must have the same structure:
+	// keyframes are shared, evaluation state (current value, frame) is this property's own.
+	virtual void shareFrom(const PropertyBase &src) {}
+	
 	template<typename T>
 	bool tryExtract(T &out) const {
 		auto it = extractors_.find(std::type_index(typeid(T)));
@@ -35,6 +50,11 @@ public:
 		return it->second(reinterpret_cast<void*>(&out));
 	}
 	
+	// Containers evaluate subtrees without keyframes once and skip them afterwards.
+	// This is reset when the container itself is set up or gets children; call it
+	// after adding keyframes to a child of a container that was already evaluated.
+	void invalidateStatic() { static_state_ = StaticState::UNKNOWN; }
+	
 protected:
 	using ExtractFn = std::function<bool(void*)>;
 	template<typename T, typename Fn>
@@ -44,9 +64,25 @@ protected:
 				return fn(*reinterpret_cast<T*>(dst));
 			};
 	}
+	
+	bool isStaticEvaluated() const { return static_state_ == StaticState::STATIC_EVALUATED; }
+	bool skipStaticFrame() {
+		switch(static_state_) {
+			case StaticState::UNKNOWN:
+				static_state_ = hasAnimation() ? StaticState::ANIMATED : StaticState::STATIC_EVALUATED;
+				return false;
+			case StaticState::STATIC_EVALUATED:
+				EvaluationStats::countSkipped();
+				return true;
+			default:
+				return false;
+		}
+	}
 
 private:
 	std::unordered_map<std::type_index, ExtractFn> extractors_;
+	enum class StaticState { UNKNOWN, ANIMATED, STATIC_EVALUATED };
+	StaticState static_state_ = StaticState::UNKNOWN;
 };
 
 template<typename T>
@@ -62,9 +98,22 @@ public:
 		});
 	}
 	
+	using PropertyBase::tryExtract;
+	// Preferred over the registered extractor when the property's type is known statically.
+	bool tryExtract(T &out) const {
+		out = get();
+		return true;
+	}
+	
 	void setup(const ofJson &base, const ofJson &keyframes) override {
 		setBaseValue(parse(base));
 		keyframes_.clear();
+		track_ = getEmptyTrack();
+		baked_.reset();
+		compressed_.reset();
+		eased_.reset();
+		cursor_ = 0;
+		held_keyframe_ = nullptr;
 
 		if(!keyframes.empty()) {
 			if(keyframes.is_array()) {
@@ -74,7 +123,7 @@ public:
 					addKeyframe(frame, parseKeyframeValue(kf));
 				}
 			}
-			else if(keyframes.is_object()) {
+			else if(keyframes.is_object() && !setupBaked(keyframes)) {
 				for(auto it = keyframes.begin(); it != keyframes.end(); ++it) {
 					int frame = ofToInt(it.key());
 					auto &&value = it.value();
@@ -86,14 +135,153 @@ public:
 				}
 			}
 		}
+		finalize();
 	}
 	
-	void setBaseValue(const T &t) { base_ = t; }
+	void write(CompiledWriter &writer) const override {
+		KeyframeTrack<T> pending;
+		const KeyframeTrack<T> *track = track_.get();
+		if(!keyframes_.empty()) {
+			pending = *track_;
+			pending.merge(keyframes_);
+			track = &pending;
+		}
+		std::vector<T> values;
+		std::vector<Keyframe::InterpolationData> interpolations;
+		std::vector<Keyframe::SpatialTangents> tangents;
+		values.reserve(track->size());
+		interpolations.reserve(track->size());
+		tangents.reserve(track->size());
+		for(const auto &kf : track->getKeyframes()) {
+			values.push_back(kf.value);
+			interpolations.push_back(kf.interpolation);
+			tangents.push_back(kf.spatial_tangents);
+		}
+		writer.write(base_);
+		writer.writeArray(track->getFrames());
+		writer.writeValues(values);
+		writer.writeArray(interpolations);
+		writer.writeArray(tangents);
+		writer.write<uint8_t>(compressed_ ? BAKED_COMPRESSED : baked_ ? BAKED_VALUES : BAKED_NONE);
+		if(compressed_) {
+			compressed_->write(writer);
+		}
+		else if(baked_) {
+			writer.write<int32_t>(baked_->getFirstFrame());
+			writer.writeValues(baked_->getValues());
+		}
+	}
 	
+	bool read(CompiledReader &reader) override {
+		keyframes_.clear();
+		track_ = getEmptyTrack();
+		baked_.reset();
+		compressed_.reset();
+		eased_.reset();
+		cursor_ = 0;
+		held_keyframe_ = nullptr;
+		cache_.reset();
+		if(!reader.read(base_)) return false;
+		
+		uint32_t frame_count, interpolation_count, tangent_count;
+		const Frame *frames = reader.template readArray<Frame>(frame_count);
+		std::vector<T> values;
+		reader.readValues(values);
+		auto interpolations = reader.template readArray<Keyframe::InterpolationData>(interpolation_count);
+		auto tangents = reader.template readArray<Keyframe::SpatialTangents>(tangent_count);
+		uint8_t baked = BAKED_NONE;
+		reader.read(baked);
+		if(!reader.isValid()
+		   || values.size() != frame_count
+		   || interpolation_count != frame_count
+		   || tangent_count != frame_count) {
+			return false;
+		}
+		if(baked == BAKED_VALUES) {
+			int32_t first_frame;
+			std::vector<T> baked_values;
+			if(!reader.read(first_frame) || !reader.readValues(baked_values) || baked_values.empty()) {
+				return false;
+			}
+			setBaked(first_frame, std::move(baked_values));
+		}
+		else if(baked == BAKED_COMPRESSED) {
+			auto compressed = CompressedTrack<T>::read(reader);
+			if(!compressed) {
+				return false;
+			}
+			BakedTrackStats::addCompressed<T>(compressed);
+			compressed_ = compressed;
+		}
+		
+		if(frame_count == 0) {
+			return true;
+		}
+		auto track = std::make_shared<KeyframeTrack<T>>();
+		track->reserve(frame_count);
+		for(uint32_t i = 0; i < frame_count; ++i) {
+			Keyframe::Data<T> kf(values[i]);
+			kf.interpolation = interpolations[i];
+			kf.spatial_tangents = tangents[i];
+			if(!track->push_back(frames[i], kf)) {
+				return false;
+			}
+		}
+		track->buildArcLengthTables();
+		track_ = track;
+		return true;
+	}
+	
+	void setBaseValue(const T &t) {
+		base_ = t;
+		cache_.reset();
+	}
+	
+	// Keyframes are collected in a map while building and moved into the flat track by finalize().
 	void addKeyframe(Frame frame, const Keyframe::Data<T> &keyframe) {
 		keyframes_.insert({frame, keyframe});
 	}
 	
+	void finalize() {
+		if(keyframes_.empty()) return;
+		// the track may be shared with other instances; build a new one
+		auto track = std::make_shared<KeyframeTrack<T>>(*track_);
+		track->merge(keyframes_);
+		track_ = track;
+		keyframes_.clear();
+		cursor_ = 0;
+		held_keyframe_ = nullptr;
+	}
+	
+	const KeyframeTrack<T>& getTrack() {
+		finalize();
+		return *track_;
+	}
+	
+	void shareFrom(const PropertyBase &src) override {
+		auto other = dynamic_cast<const Property<T>*>(&src);
+		if(!other) return;
+		base_ = other->base_;
+		keyframes_ = other->keyframes_;
+		track_ = other->track_;
+		baked_ = other->baked_;
+		compressed_ = other->compressed_;
+		eased_.reset();
+		cache_.reset();
+		cursor_ = 0;
+		held_keyframe_ = nullptr;
+		current_frame_ = 0.0f;
+		fps_ = other->fps_;
+	}
+	// True if this and other use the same keyframe data, e.g. after shareFrom().
+	bool isSharingTrack(const Property<T> &other) const {
+		return track_ == other.track_ && baked_ == other.baked_ && compressed_ == other.compressed_;
+	}
+	// Set for full frame animation; used instead of the keyframe track.
+	const BakedTrack<T>* getBakedTrack() const { return baked_.get(); }
+	// Set instead of getBakedTrack() if the baked track was compressed (see TrackCompression).
+	const CompressedTrack<T>* getCompressedTrack() const { return compressed_.get(); }
+	
 	virtual T parse(const ofJson &json) const = 0;
 	
 	Keyframe::InterpolationType parseInterpolationType(const std::string &type) const {
@@ -159,16 +347,16 @@ public:
 			const auto &spatialTangents = json["spatialTangents"];
 			if(spatialTangents.contains("inTangent") && spatialTangents["inTangent"].is_array()) {
 				const auto &inTangent = spatialTangents["inTangent"];
-				kf.spatial_tangents.in_tangent.clear();
+				kf.spatial_tangents.in_size = 0;
 				for(const auto &val : inTangent) {
-					kf.spatial_tangents.in_tangent.push_back(val.get<float>());
+					kf.spatial_tangents.addIn(val.get<float>());
 				}
 			}
 			if(spatialTangents.contains("outTangent") && spatialTangents["outTangent"].is_array()) {
 				const auto &outTangent = spatialTangents["outTangent"];
-				kf.spatial_tangents.out_tangent.clear();
+				kf.spatial_tangents.out_size = 0;
 				for(const auto &val : outTangent) {
-					kf.spatial_tangents.out_tangent.push_back(val.get<float>());
+					kf.spatial_tangents.addOut(val.get<float>());
 				}
 			}
 		}
@@ -178,34 +366,84 @@ public:
 	
 	void set(const T &t) { cache_ = t; }
 	const T& get() const { return cache_.has_value() ? *cache_ : base_; }
-	bool hasAnimation() const override { return !keyframes_.empty(); }
+	bool hasAnimation() const override { return baked_ || compressed_ || !track_->empty() || !keyframes_.empty(); }
 	
 	bool setFrame(Frame frame) override {
 		bool is_first = !cache_.has_value();
+		finalize();
 		
-		if(keyframes_.empty()) {
-			cache_ = base_;
+		if(baked_) {
+			EvaluationStats::countEvaluated();
+			baked_->get(frame, getCache());
 			current_frame_ = frame;
-			return is_first;
+			return true;
+		}
+		if(compressed_) {
+			EvaluationStats::countEvaluated();
+			cache_ = compressed_->get(frame);
+			current_frame_ = frame;
+			return true;
+		}
+		if(track_->empty()) {
+			current_frame_ = frame;
+			if(!is_first) {
+				EvaluationStats::countSkipped();
+				return false;
+			}
+			cache_ = base_;
+			return true;
 		}
 		
-		auto pair = util::findFrameKeyframePair(keyframes_, frame);
+		EvaluationStats::countEvaluated();
+		auto pair = track_->find(frame, cursor_);
 		if(pair.keyframe_a == nullptr || pair.keyframe_b == nullptr) {
 			cache_ = base_;
 			current_frame_ = frame;
 			return is_first;
 		}
 		if(pair.frame_a == pair.frame_b) {
+			// holding a keyframe only changes the value when a different one is reached
+			bool changed = is_first || held_keyframe_ != pair.keyframe_a;
+			held_keyframe_ = pair.keyframe_a;
 			cache_ = pair.keyframe_a->value;
 			current_frame_ = pair.frame_a;
-			return is_first;
+			return changed;
 		}
 
+		held_keyframe_ = nullptr;
 		float dt = static_cast<float>((pair.frame_b - pair.frame_a) / fps_);
-		cache_ = interpolateKeyframe(*pair.keyframe_a, *pair.keyframe_b, dt, pair.ratio);
+		float eased;
+		if(eased_.take(frame, eased)) {
+			if constexpr (interpolation::IsEaseBatchable<T>::value) {
+				cache_ = interpolation::calculateEased(*pair.keyframe_a, *pair.keyframe_b, dt, eased);
+			}
+		}
+		else {
+			interpolateKeyframe(getCache(), *pair.keyframe_a, *pair.keyframe_b, dt, pair.ratio, track_->getArcLengthTable(cursor_));
+		}
 		current_frame_ = frame;
 		return true;
 	}
+
+	void gatherEasing(Frame frame, EaseBatch &batch) override {
+		eased_.reset();
+		if constexpr (interpolation::IsEaseBatchable<T>::value) {
+			finalize();
+			if(baked_ || compressed_ || track_->empty()) {
+				return;
+			}
+			auto pair = track_->find(frame, cursor_);
+			// the same cases as interpolation::bezier() solves
+			if(pair.keyframe_a == nullptr || pair.keyframe_b == nullptr || pair.frame_b <= pair.frame_a
+			   || pair.keyframe_a->interpolation.out_type != Keyframe::BEZIER
+			   || pair.ratio <= 0.f || pair.ratio >= 1.f) {
+				return;
+			}
+			const auto &ease_out = pair.keyframe_a->interpolation.out_ease;
+			const auto &ease_in = pair.keyframe_b->interpolation.in_ease;
+			eased_ = batch.add(frame, pair.ratio, ease_out.influence, 1.f - ease_in.influence);
+		}
+	}
 	
 	Frame getFrame() const override { return current_frame_; }
 	
@@ -220,9 +458,82 @@ public:
 	void setFps(float fps) override { fps_ = fps; }
 	
 private:
+	// Full frame animation comes as {"first frame": [value per frame, ...], ...}.
+	// If the runs cover a range of frames without gaps, the values go straight into a BakedTrack.
+	bool setupBaked(const ofJson &keyframes) {
+		std::vector<std::pair<int, const ofJson*>> runs;
+		runs.reserve(keyframes.size());
+		for(auto it = keyframes.begin(); it != keyframes.end(); ++it) {
+			if(!it.value().is_array() || it.value().empty()) {
+				return false;
+			}
+			runs.emplace_back(ofToInt(it.key()), &it.value());
+		}
+		// keys are strings, so "10" comes before "2"
+		std::sort(begin(runs), end(runs), [](const auto &a, const auto &b) { return a.first < b.first; });
+		size_t count = 0;
+		for(auto &&[frame, values] : runs) {
+			if(frame != runs.front().first + static_cast<int>(count)) {
+				return false;
+			}
+			count += values->size();
+		}
+		std::vector<T> values;
+		values.reserve(count);
+		for(auto &&run : runs) {
+			for(const auto &value : *run.second) {
+				values.push_back(parse(value));
+			}
+		}
+		setBaked(runs.front().first, std::move(values));
+		return true;
+	}
+
+	// Compresses the values instead if TrackCompression is enabled and that makes them smaller.
+	void setBaked(int first_frame, std::vector<T> values) {
+		if(TrackCompression::isEnabled()) {
+			if(auto compressed = CompressedTrack<T>::build(first_frame, values, TrackCompression::getTolerance())) {
+				BakedTrackStats::addCompressed<T>(compressed, &values);
+				compressed_ = compressed;
+				return;
+			}
+		}
+		auto baked = std::make_shared<BakedTrack<T>>(first_frame, std::move(values));
+		BakedTrackStats::add(*baked);
+		baked_ = baked;
+	}
+
+	// how the full frame animation is stored in compiled files
+	enum : uint8_t {
+		BAKED_NONE,
+		BAKED_VALUES,
+		BAKED_COMPRESSED
+	};
+	
+	// The value to evaluate into. Kept across frames, so that types with storage
+	// (PathData) reuse it instead of allocating a new value every frame.
+	T& getCache() {
+		if(!cache_) {
+			cache_.emplace(base_);
+		}
+		return *cache_;
+	}
+
+	static const std::shared_ptr<const KeyframeTrack<T>>& getEmptyTrack() {
+		static const std::shared_ptr<const KeyframeTrack<T>> empty = std::make_shared<KeyframeTrack<T>>();
+		return empty;
+	}
+	
 	T base_;
 	std::optional<T> cache_;
 	std::map<Frame, Keyframe::Data<T>> keyframes_;
+	// immutable once built, so instances made with shareFrom() can point at the same one
+	std::shared_ptr<const KeyframeTrack<T>> track_ = getEmptyTrack();
+	std::shared_ptr<const BakedTrack<T>> baked_;
+	std::shared_ptr<const CompressedTrack<T>> compressed_;
+	EaseBatch::Ticket eased_;
+	size_t cursor_ = 0;
+	const Keyframe::Data<T> *held_keyframe_ = nullptr;
 	Frame current_frame_ = 0.0f;
 	float fps_ = 30.0f;
 };
@@ -234,6 +545,7 @@ public:
 	
 	template<typename T>
 	T* registerProperty(std::string key) {
+		invalidateStatic();
 		auto result = props_.insert(std::make_pair(key, std::make_unique<T>()));
 		return static_cast<T*>(result.first->second.get());
 	}
@@ -253,14 +565,57 @@ public:
 	}
 	
 	void setup(const ofJson &base, const ofJson &keyframes) override {
+		invalidateStatic();
 		for(auto &&[k,v] : props_) {
 			auto p = nlohmann::json::json_pointer(k);
 			auto propValue = base.value(p, ofJson{});
 			auto keyframeValue = keyframes.is_null() ? ofJson{} : keyframes.value(p, ofJson{});
+			BakedTrackStats::NameScope name(k);
 			v->setup(propValue, keyframeValue);
 		}
 	}
 	
+	void write(CompiledWriter &writer) const override {
+		writer.write<uint32_t>(static_cast<uint32_t>(props_.size()));
+		for(auto &&[k,v] : props_) {
+			writer.write(k);
+			auto block = writer.beginBlock();
+			v->write(writer);
+			writer.endBlock(block);
+		}
+	}
+	
+	void shareFrom(const PropertyBase &src) override {
+		auto other = dynamic_cast<const PropertyGroup*>(&src);
+		if(!other) return;
+		invalidateStatic();
+		fps_ = other->fps_;
+		for(auto &&[k,v] : props_) {
+			auto found = other->props_.find(k);
+			if(found != end(other->props_)) {
+				v->shareFrom(*found->second);
+			}
+		}
+	}
+	
+	bool read(CompiledReader &reader) override {
+		invalidateStatic();
+		uint32_t count;
+		if(!reader.read(count)) return false;
+		for(uint32_t i = 0; i < count; ++i) {
+			std::string key;
+			size_t block_end;
+			if(!reader.read(key) || !reader.beginBlock(block_end)) return false;
+			auto found = props_.find(key);
+			BakedTrackStats::NameScope name(key);
+			if(found != end(props_) && !found->second->read(reader)) {
+				return false;
+			}
+			reader.endBlock(block_end);
+		}
+		return reader.isValid();
+	}
+	
 	bool hasAnimation() const override {
 		for(auto &&[_,p] : props_) {
 			if(p->hasAnimation()) return true;
@@ -269,6 +624,7 @@ public:
 	}
 	
 	bool setFrame(Frame frame) override {
+		if(skipStaticFrame()) return false;
 		bool ret = false;
 		for(auto &&[_,p] : props_) {
 			ret |= p->setFrame(frame);
@@ -276,6 +632,13 @@ public:
 		return ret;
 	}
 	
+	void gatherEasing(Frame frame, EaseBatch &batch) override {
+		if(isStaticEvaluated()) return;
+		for(auto &&[_,p] : props_) {
+			p->gatherEasing(frame, batch);
+		}
+	}
+	
 	Frame getFrame() const override {
 		// Return first property's frame (all should be in sync)
 		for(auto &&[_,p] : props_) {
@@ -308,7 +671,10 @@ class PropertyArray : public PropertyBase
 {
 public:
 	void accept(Visitor &visitor) override;
-	void clear() { properties_.clear(); }
+	void clear() {
+		invalidateStatic();
+		properties_.clear();
+	}
 	
 	template<typename T>
 	T* addProperty() {
@@ -319,9 +685,52 @@ public:
 	}
 	
 	void addProperty(std::unique_ptr<PropertyBase> property) {
+		invalidateStatic();
 		properties_.push_back(std::move(property));
 	}
 	
+	// Type tags used to recreate the elements when reading a compiled composition.
+	virtual PropertyBase* addPropertyForType(const std::string &type) { return nullptr; }
+	virtual std::string getPropertyType(size_t index) const { return ""; }
+	
+	void write(CompiledWriter &writer) const override {
+		writer.write<uint32_t>(static_cast<uint32_t>(properties_.size()));
+		for(size_t i = 0; i < properties_.size(); ++i) {
+			writer.write(getPropertyType(i));
+			auto block = writer.beginBlock();
+			properties_[i]->write(writer);
+			writer.endBlock(block);
+		}
+	}
+	
+	bool read(CompiledReader &reader) override {
+		clear();
+		uint32_t count;
+		if(!reader.read(count)) return false;
+		for(uint32_t i = 0; i < count; ++i) {
+			std::string type;
+			size_t block_end;
+			if(!reader.read(type) || !reader.beginBlock(block_end)) return false;
+			if(auto p = addPropertyForType(type)) {
+				if(!p->read(reader)) return false;
+			}
+			reader.endBlock(block_end);
+		}
+		return reader.isValid();
+	}
+	
+	void shareFrom(const PropertyBase &src) override {
+		auto other = dynamic_cast<const PropertyArray*>(&src);
+		if(!other) return;
+		clear();
+		fps_ = other->fps_;
+		for(size_t i = 0; i < other->properties_.size(); ++i) {
+			if(auto p = addPropertyForType(other->getPropertyType(i))) {
+				p->shareFrom(*other->properties_[i]);
+			}
+		}
+	}
+	
 	template<typename T=PropertyBase>
 	T* getProperty(size_t index) {
 		if(index >= properties_.size()) return nullptr;
@@ -344,6 +753,7 @@ public:
 	}
 	
 	bool setFrame(Frame frame) override {
+		if(skipStaticFrame()) return false;
 		bool changed = false;
 		for(auto &p : properties_) {
 			if(p) {
@@ -353,6 +763,15 @@ public:
 		return changed;
 	}
 	
+	void gatherEasing(Frame frame, EaseBatch &batch) override {
+		if(isStaticEvaluated()) return;
+		for(auto &p : properties_) {
+			if(p) {
+				p->gatherEasing(frame, batch);
+			}
+		}
+	}
+	
 	Frame getFrame() const override {
 		// Return first property's frame (all should be in sync)
 		for(const auto &p : properties_) {
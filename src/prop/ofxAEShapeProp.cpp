@@ -47,70 +47,58 @@ PathData PathProp::parse(const ofJson &json) const
 }
 
 
+namespace {
+// data[index] as a T. The node already there is reused if it is a T, so that extracting
+// the same structure again does not allocate.
+template<typename T>
+T& reuseNode(std::vector<std::unique_ptr<ShapeDataBase>> &data, size_t index)
+{
+	if(index < data.size()) {
+		if(auto node = dynamic_cast<T*>(data[index].get())) {
+			return *node;
+		}
+		data[index] = std::make_unique<T>();
+	}
+	else {
+		data.push_back(std::make_unique<T>());
+	}
+	return static_cast<T&>(*data[index]);
+}
+
+template<typename Data, typename Prop>
+bool extractNode(const PropertyBase *prop, std::vector<std::unique_ptr<ShapeDataBase>> &data, size_t &count, const char *name)
+{
+	auto typed = dynamic_cast<const Prop*>(prop);
+	if(!typed) {
+		return false;
+	}
+	if(typed->tryExtract(reuseNode<Data>(data, count))) {
+		++count;
+	}
+	else {
+		ofLogWarning("PropertyExtraction") << "Failed to extract " << name << ", skipping";
+	}
+	return true;
+}
+}
+
 ShapeProp::ShapeProp()
 {
 	registerExtractor<ShapeData>([this](ShapeData &t) -> bool {
 		try {
 			auto &data = t.data;
-			data.clear();
+			size_t count = 0;
 			for(const auto &prop : properties_) {
-				if(auto ellipseProp = dynamic_cast<const EllipseProp*>(prop.get())) {
-					auto ellipse = std::make_unique<EllipseData>();
-					if(!ellipseProp->tryExtract(*ellipse)) {
-						ofLogWarning("PropertyExtraction") << "Failed to extract EllipseData, skipping";
-						continue;
-					}
-					data.push_back(std::move(ellipse));
-				}
-				else if(auto rectProp = dynamic_cast<const RectangleProp*>(prop.get())) {
-					auto rectangle = std::make_unique<RectangleData>();
-					if(!rectProp->tryExtract(*rectangle)) {
-						ofLogWarning("PropertyExtraction") << "Failed to extract RectangleData, skipping";
-						continue;
-					}
-					data.push_back(std::move(rectangle));
-				}
-				else if(auto fillProp = dynamic_cast<const FillProp*>(prop.get())) {
-					auto fill = std::make_unique<FillData>();
-					if(!fillProp->tryExtract(*fill)) {
-						ofLogWarning("PropertyExtraction") << "Failed to extract FillData, skipping";
-						continue;
-					}
-					data.push_back(std::move(fill));
-				}
-				else if(auto strokeProp = dynamic_cast<const StrokeProp*>(prop.get())) {
-					auto stroke = std::make_unique<StrokeData>();
-					if(!strokeProp->tryExtract(*stroke)) {
-						ofLogWarning("PropertyExtraction") << "Failed to extract StrokeData, skipping";
-						continue;
-					}
-					data.push_back(std::move(stroke));
-				}
-				else if(auto pathProp = dynamic_cast<const PathProp*>(prop.get())) {
-					auto path = std::make_unique<PathData>();
-					if(!pathProp->tryExtract(*path)) {
-						ofLogWarning("PropertyExtraction") << "Failed to extract PathData, skipping";
-						continue;
-					}
-					data.push_back(std::move(path));
-				}
-				else if(auto polygonProp = dynamic_cast<const PolygonProp*>(prop.get())) {
-					auto polygon = std::make_unique<PolygonData>();
-					if(!polygonProp->tryExtract(*polygon)) {
-						ofLogWarning("PropertyExtraction") << "Failed to extract PolygonData, skipping";
-						continue;
-					}
-					data.push_back(std::move(polygon));
-				}
-				else if(auto groupProp = dynamic_cast<const GroupProp*>(prop.get())) {
-					auto group = std::make_unique<GroupData>();
-					if(!groupProp->tryExtract(*group)) {
-						ofLogWarning("PropertyExtraction") << "Failed to extract GroupData, skipping";
-						continue;
-					}
-					data.push_back(std::move(group));
-				}
+				extractNode<EllipseData, EllipseProp>(prop.get(), data, count, "EllipseData")
+				|| extractNode<RectangleData, RectangleProp>(prop.get(), data, count, "RectangleData")
+				|| extractNode<FillData, FillProp>(prop.get(), data, count, "FillData")
+				|| extractNode<StrokeData, StrokeProp>(prop.get(), data, count, "StrokeData")
+				|| extractNode<PathData, PathProp>(prop.get(), data, count, "PathData")
+				|| extractNode<PolygonData, PolygonProp>(prop.get(), data, count, "PolygonData")
+				|| extractNode<GroupData, GroupProp>(prop.get(), data, count, "GroupData");
 			}
+			// nodes past count belong to properties that are gone or failed to extract
+			data.resize(count);
 			return true;
 		}
 		catch(const std::exception& ex) {
@@ -135,7 +123,7 @@ void ShapeProp::setup(const ofJson &base, const ofJson &keyframes)
 	}
 }
 
-PropertyBase* ShapeProp::addPropertyForType(std::string type)
+PropertyBase* ShapeProp::addPropertyForType(const std::string &type)
 {
 	if(type == "ellipse") return addProperty<EllipseProp>();
 	if(type == "rectangle") return addProperty<RectangleProp>();
@@ -147,6 +135,19 @@ PropertyBase* ShapeProp::addPropertyForType(std::string type)
 	return nullptr;
 }
 
+std::string ShapeProp::getPropertyType(size_t index) const
+{
+	const PropertyBase *prop = getProperty(index);
+	if(dynamic_cast<const EllipseProp*>(prop)) return "ellipse";
+	if(dynamic_cast<const RectangleProp*>(prop)) return "rectangle";
+	if(dynamic_cast<const PathProp*>(prop)) return "path";
+	if(dynamic_cast<const FillProp*>(prop)) return "fill";
+	if(dynamic_cast<const StrokeProp*>(prop)) return "stroke";
+	if(dynamic_cast<const PolygonProp*>(prop)) return "polygon";
+	if(dynamic_cast<const GroupProp*>(prop)) return "group";
+	return "";
+}
+
 GroupProp::GroupProp()
 {
 	registerProperty<BlendModeProp>("/blendMode");
@@ -169,11 +170,7 @@ GroupProp::GroupProp()
 			success = false;
 		}
 
-		if(!getProperty<TransformProp>("/transform")->tryExtract(g.transform)) {
-			ofLogWarning("PropertyExtraction") << "Failed to extract group transform data, using empty";
-			g.transform = TransformData();
-			success = false;
-		}
+		getProperty<TransformProp>("/transform")->evaluate(g.transform);
 
 		if(!getProperty<BoolProp>("/visible")->tryExtract(g.visible)) {
 			g.visible = true;
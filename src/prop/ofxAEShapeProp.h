@@ -368,9 +368,8 @@ class ShapeProp : public PropertyArray
 public:
 	ShapeProp();
 	virtual void setup(const ofJson &base, const ofJson &keyframes) override;
-
-private:
-	PropertyBase* addPropertyForType(std::string type);
+	PropertyBase* addPropertyForType(const std::string &type) override;
+	std::string getPropertyType(size_t index) const override;
 };
 
 class GroupProp : public PropertyGroup
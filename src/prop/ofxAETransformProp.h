@@ -9,48 +9,35 @@ class TransformProp : public PropertyGroup
 {
 public:
 	TransformProp() {
-		registerProperty<VecProp<3>>("/anchor");
-		registerProperty<VecProp<3>>("/position");
-		registerProperty<PercentVecProp<3>>("/scale");
-		registerProperty<FloatProp>("/rotateZ");
-		registerProperty<PercentProp>("/opacity");
+		anchor_ = registerProperty<VecProp<3>>("/anchor");
+		position_ = registerProperty<VecProp<3>>("/position");
+		scale_ = registerProperty<PercentVecProp<3>>("/scale");
+		rotate_z_ = registerProperty<FloatProp>("/rotateZ");
+		opacity_ = registerProperty<PercentProp>("/opacity");
 
 		registerExtractor<TransformData>([this](TransformData &t) -> bool {
-			bool success = true;
-
-			if(!getProperty<VecProp<3>>("/anchor")->tryExtract(t.anchor)) {
-				ofLogWarning("PropertyExtraction") << "Failed to extract anchor, using default";
-				t.anchor = glm::vec3(0.0f, 0.0f, 0.0f);
-				success = false;
-			}
-
-			if(!getProperty<VecProp<3>>("/position")->tryExtract(t.position)) {
-				ofLogWarning("PropertyExtraction") << "Failed to extract position, using default";
-				t.position = glm::vec3(0.0f, 0.0f, 0.0f);
-				success = false;
-			}
-
-			if(!getProperty<PercentVecProp<3>>("/scale")->tryExtract(t.scale)) {
-				ofLogWarning("PropertyExtraction") << "Failed to extract scale, using default";
-				t.scale = glm::vec3(1.0f, 1.0f, 1.0f);
-				success = false;
-			}
-
-			if(!getProperty<FloatProp>("/rotateZ")->tryExtract(t.rotateZ)) {
-				ofLogWarning("PropertyExtraction") << "Failed to extract rotateZ, using default";
-				t.rotateZ = 0.0f;
-				success = false;
-			}
-
-			if(!getProperty<PercentProp>("/opacity")->tryExtract(t.opacity)) {
-				ofLogWarning("PropertyExtraction") << "Failed to extract opacity, using default";
-				t.opacity = 1.0f;
-				success = false;
-			}
-
-			return success;
+			evaluate(t);
+			return true;
 		});
 	}
+
+	// The current values, read straight from the properties.
+	// Same as tryExtract(TransformData&) without looking anything up by type or key.
+	void evaluate(TransformData &dst) const {
+		dst.anchor = anchor_->get();
+		dst.position = position_->get();
+		dst.scale = scale_->get();
+		dst.rotateZ = rotate_z_->get();
+		dst.opacity = opacity_->get();
+	}
+
+private:
+	// owned by the group, resolved once in the constructor
+	VecProp<3> *anchor_;
+	VecProp<3> *position_;
+	PercentVecProp<3> *scale_;
+	FloatProp *rotate_z_;
+	PercentProp *opacity_;
 };
 
 }}
@@ -1,9 +1,13 @@
+#include <cmath>
 #include <sstream>
+#include <utility>
 
 #include "ofLog.h"
 
 #include "../core/ofxAEVisitor.h"
 #include "../utils/ofxAEAssetManager.h"
+#include "../utils/ofxAECompiledIO.h"
+#include "../utils/ofxAEPrecompCache.h"
 
 #include "ofxAECompositionSource.h"
 
@@ -15,10 +19,22 @@ CompositionSource::CompositionSource()
 {
 }
 
+CompositionSource::~CompositionSource()
+{
+	// a later composition at the same address must not find our frames
+	if(composition_) {
+		PrecompCache::getInstance().invalidate(*composition_);
+	}
+}
+
 bool CompositionSource::load(const std::filesystem::path &filepath)
 {
 	filepath_ = filepath;
-	composition_ = AssetManager::getInstance().getComposition(filepath);
+	if(composition_) {
+		PrecompCache::getInstance().invalidate(*composition_);
+	}
+	prototype_ = AssetManager::getInstance().getComposition(filepath);
+	composition_ = prototype_ ? prototype_->instantiate() : nullptr;
 	
 	if(composition_) {
 		ofLogVerbose("CompositionSource") << "Loaded composition via AssetManager: " << filepath;
@@ -30,6 +46,36 @@ bool CompositionSource::load(const std::filesystem::path &filepath)
 	}
 }
 
+bool CompositionSource::read(CompiledReader &reader)
+{
+	uint32_t index;
+	if(!reader.read(index) || !reader.readPath(filepath_)) {
+		return false;
+	}
+	if(composition_) {
+		PrecompCache::getInstance().invalidate(*composition_);
+	}
+	prototype_ = reader.getArchive().getComposition(index);
+	composition_ = prototype_ ? prototype_->instantiate() : nullptr;
+	if(!composition_) {
+		ofLogError("CompositionSource") << "Failed to read nested composition: " << filepath_;
+		return false;
+	}
+	return true;
+}
+
+std::unique_ptr<LayerSource> CompositionSource::instantiate() const
+{
+	auto ret = std::make_unique<CompositionSource>();
+	ret->fps_ = fps_;
+	ret->filepath_ = filepath_;
+	ret->prototype_ = prototype_;
+	if(prototype_) {
+		ret->composition_ = prototype_->instantiate();
+	}
+	return ret;
+}
+
 bool CompositionSource::setFrame(Frame frame)
 {
 	if(!composition_) return false;
@@ -44,7 +90,11 @@ bool CompositionSource::setFrame(Frame frame)
 	Frame nested_frame = (fps_ == nested_fps) ? frame :
 		(frame * nested_fps / fps_);
 	
-	return composition_->setFrame(nested_frame);
+	if(!composition_->setFrame(nested_frame)) {
+		return false;
+	}
+	render_frame_ = nested_frame;
+	return true;
 }
 
 FrameCount CompositionSource::getDurationFrames() const
@@ -59,6 +109,31 @@ void CompositionSource::update()
 		return;
 	}
 	composition_->update();
+	if(composition_->consumeContentChange()) {
+		PrecompCache::getInstance().invalidate(*composition_);
+		is_content_changed_ = true;
+	}
+}
+
+bool CompositionSource::consumeContentChange()
+{
+	return std::exchange(is_content_changed_, false);
+}
+
+namespace {
+// How much the current model matrix enlarges what is drawn, at least 1. Rounded up to quarter
+// steps so that a precomp with animated scale keeps hitting the same cache entries.
+float getDrawScale()
+{
+	glm::mat4 model = glm::inverse(ofGetCurrentViewMatrix()) * ofGetCurrentMatrix(OF_MATRIX_MODELVIEW);
+	float scale_x = glm::length(glm::vec3(model[0].x, model[0].y, model[0].z));
+	float scale_y = glm::length(glm::vec3(model[1].x, model[1].y, model[1].z));
+	float scale = std::max(scale_x, scale_y);
+	if(!(scale > 1.f)) {
+		return 1.f;
+	}
+	return std::ceil(scale * 4.f) / 4.f;
+}
 }
 
 void CompositionSource::draw(float x, float y, float w, float h) const
@@ -66,9 +141,27 @@ void CompositionSource::draw(float x, float y, float w, float h) const
 	if(!composition_) {
 		return;
 	}
+	auto &cache = PrecompCache::getInstance();
+	if(cache.isEnabled()) {
+		float scale = getDrawScale();
+		if(auto texture = cache.get(*composition_, render_frame_, std::ceil(w * scale), std::ceil(h * scale))) {
+			texture->draw(x, y, w, h);
+			return;
+		}
+	}
 	composition_->draw(x, y, w, h);
 }
 
+void CompositionSource::setComposition(std::shared_ptr<Composition> comp)
+{
+	if(composition_) {
+		PrecompCache::getInstance().invalidate(*composition_);
+	}
+	composition_ = comp;
+	prototype_ = comp;
+	render_frame_ = comp ? comp->getFrame() : 0.0f;
+}
+
 float CompositionSource::getWidth() const
 {
 	if(!composition_) {
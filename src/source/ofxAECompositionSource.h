@@ -12,15 +12,19 @@ class CompositionSource : public LayerSource
 {
 public:
 	CompositionSource();
+	~CompositionSource();
 	
 	void accept(Visitor &visitor) override;
 	bool load(const std::filesystem::path &filepath) override;
+	bool read(CompiledReader &reader) override;
+	std::unique_ptr<LayerSource> instantiate() const override;
 	
 	bool setFrame(Frame frame) override;
 	
 	FrameCount getDurationFrames() const override;
 	
 	void update() override;
+	bool consumeContentChange() override;
 	void draw(float x, float y, float w, float h) const override;
 
 	SourceType getSourceType() const override { return SourceType::COMPOSITION; }
@@ -28,12 +32,23 @@ public:
 	float getHeight() const override;
 	std::string getDebugInfo() const override;
 	
-	void setComposition(std::shared_ptr<Composition> comp) { composition_ = comp; }
-	std::shared_ptr<Composition> getComposition() { return composition_; }
+	// The composition given here is used as is; it is not instantiated.
+	void setComposition(std::shared_ptr<Composition> comp);
+	// This instance's own composition.
+	std::shared_ptr<Composition> getComposition() const { return composition_; }
+	// The shared composition from AssetManager that this instance was made from.
+	std::shared_ptr<Composition> getPrototype() const { return prototype_; }
 	
 private:
+	// Layers referencing the same precomp share the prototype's keyframes and assets,
+	// but each evaluates its own instance, so they can show different frames.
+	std::shared_ptr<Composition> prototype_;
 	std::shared_ptr<Composition> composition_;
 	std::filesystem::path filepath_;
+	// the nested frame whose content is shown; stays put while setFrame() changes nothing,
+	// so held frames are found in PrecompCache under one key
+	Frame render_frame_ = 0.0f;
+	bool is_content_changed_ = false;
 };
 
 }}
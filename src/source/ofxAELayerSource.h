@@ -12,6 +12,9 @@
 namespace ofx { namespace ae {
 
 class Visitor;
+class CompiledWriter;
+class CompiledReader;
+class EaseBatch;
 
 class LayerSource : public ofBaseDraws, public ofBaseUpdates
 {
@@ -22,11 +25,25 @@ public:
 
 	virtual bool setup(const ofJson &json) { return false; }
 	virtual bool load(const std::filesystem::path &filepath) { return setup(ofLoadJson(filepath)); }
+	
+	virtual void write(CompiledWriter &writer) const {}
+	virtual bool read(CompiledReader &reader) { return false; }
+	// A new source for another instance of the same layer (see Composition::instantiate()).
+	// Loaded assets and keyframes are shared; the playback state is its own. nullptr if not supported.
+	virtual std::unique_ptr<LayerSource> instantiate() const { return nullptr; }
 
 	virtual void update() override {}
+	// True once after update() changed what draw() shows without a setFrame() call
+	// (e.g. a streamed frame that arrived late), so the layer knows to redraw its FBO.
+	virtual bool consumeContentChange() { return false; }
 	
 	virtual bool setFrame(Frame frame) = 0;
+	// True if setFrame() only touches this source's own CPU-side state,
+	// so that it may run on a worker thread during parallel evaluation.
+	virtual bool canSetFrameConcurrently() const { return false; }
 	virtual Frame getFrame() const { return current_frame_; }
+	// Adds the bezier segments that setFrame(frame) is going to interpolate to batch.
+	virtual void gatherEasing(Frame frame, EaseBatch &batch) {}
 
 	virtual bool setTime(double time);
 	virtual double getTime() const;
@@ -41,6 +58,16 @@ public:
 
 	virtual ofRectangle getBoundingBox() const { return ofRectangle{0,0,getWidth(),getHeight()}; }
 
+	// Sources whose draw() is a single rectangle, filled with a color or a texture,
+	// describe it here so that DrawBatch can merge them with neighbouring layers.
+	struct BatchQuad {
+		const ofTexture *texture = nullptr;
+		ofRectangle tex_rect;	// part of texture to draw, in texture pixels
+		bool has_color = false;	// color.rgb replaces the inherited RenderContext color
+		ofFloatColor color;
+	};
+	virtual bool tryGetBatchQuad(BatchQuad &dst) const { return false; }
+
 	virtual SourceType getSourceType() const = 0;
 
 	virtual std::string getDebugInfo() const { return "LayerSource"; }
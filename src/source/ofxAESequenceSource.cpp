@@ -4,21 +4,109 @@
 #include "ofJson.h"
 #include "../utils/ofxAEAssetManager.h"
 #include "../utils/ofxAETimeUtils.h"
+#include "../utils/ofxAECompiledIO.h"
 #include <algorithm>
+#include <utility>
 
 namespace ofx { namespace ae {
 
+namespace {
+bool is_streaming_enabled = false;
+SequenceStreamer::Settings streaming_settings;
+}
+
+void SequenceSource::setStreamingEnabled(bool enable, const SequenceStreamer::Settings &settings)
+{
+	is_streaming_enabled = enable;
+	streaming_settings = settings;
+}
+
+bool SequenceSource::isStreamingEnabled()
+{
+	return is_streaming_enabled;
+}
+
 bool SequenceSource::load(const std::filesystem::path &filepath)
 {
-	pool_.clear();
+	std::vector<std::filesystem::path> frames;
+	Frame frame_offset = 0.0f;
+	if(!listFrames(filepath, frames, frame_offset)) {
+		frames_.reset();
+		pool_.reset();
+		texture_.reset();
+		return false;
+	}
+	return setupFrames(frames, frame_offset);
+}
+
+std::unique_ptr<LayerSource> SequenceSource::instantiate() const
+{
+	auto ret = std::make_unique<SequenceSource>();
+	ret->fps_ = fps_;
+	ret->frame_offset_ = frame_offset_;
+	ret->frames_ = frames_;
+	if(streamer_) {
+		// every instance streams its own frames; decoded images are not shared
+		ret->streamer_ = std::make_unique<SequenceStreamer>(streamer_->getFrames(), streamer_->getSettings());
+		if(!ret->streamer_->setup()) {
+			return nullptr;
+		}
+	}
+	else {
+		ret->pool_ = pool_;
+	}
+	return ret;
+}
+
+bool SequenceSource::read(CompiledReader &reader)
+{
+	Frame frame_offset;
+	uint32_t count;
+	if(!reader.read(frame_offset) || !reader.read(count)) {
+		return false;
+	}
+	std::vector<std::filesystem::path> frames(count);
+	for(auto &frame : frames) {
+		if(!reader.readPath(frame)) return false;
+	}
+	return setupFrames(frames, frame_offset);
+}
+
+bool SequenceSource::setupFrames(const std::vector<std::filesystem::path> &frames, Frame frame_offset)
+{
+	pool_.reset();
 	texture_.reset();
-	frame_offset_ = 0.0f;
+	streamer_.reset();
+	frame_offset_ = frame_offset;
+	frames_ = std::make_shared<const std::vector<std::filesystem::path>>(frames);
+	
+	if(is_streaming_enabled) {
+		streamer_ = std::make_unique<SequenceStreamer>(frames, streaming_settings);
+		if(!streamer_->setup()) {
+			streamer_.reset();
+			return false;
+		}
+		return true;
+	}
+	auto pool = std::make_shared<std::vector<std::shared_ptr<TextureRegion>>>();
+	pool->reserve(frames.size());
+	for(const auto &frame : frames) {
+		pool->push_back(AssetManager::getInstance().getTextureRegion(frame));
+	}
+	pool_ = pool;
+	return !pool_->empty();
+}
+
+bool SequenceSource::listFrames(const std::filesystem::path &filepath, std::vector<std::filesystem::path> &frames, Frame &frame_offset)
+{
+	frames.clear();
+	frame_offset = 0.0f;
 	
 	if(filepath.extension() == ".json") {
 		ofJson json = ofLoadJson(filepath);
 		try {
 			if(json.contains("frameOffset")) {
-				frame_offset_ = json["frameOffset"].get<float>();
+				frame_offset = json["frameOffset"].get<float>();
 			}
 			
 			if(!json.contains("directory")) {
@@ -38,15 +126,14 @@ bool SequenceSource::load(const std::filesystem::path &filepath)
 				auto fileList = json["frames"]["list"].get<std::vector<std::string>>();
 				auto indices = json["frames"]["indices"].get<std::vector<int>>();
 
-				pool_.reserve(indices.size());
+				frames.reserve(indices.size());
 				for(const auto& index : indices) {
-					std::filesystem::path fullPath = sequenceDir / fileList[index];
-					pool_.push_back(AssetManager::getInstance().getTexture(fullPath));
+					frames.push_back(sequenceDir / fileList[index]);
 				}
 
-				return !pool_.empty();
+				return !frames.empty();
 			}
-			return loadImagesFromDirectory(sequenceDir);
+			return listFramesInDirectory(sequenceDir, frames);
 			
 		} catch(const std::exception &e) {
 			ofLogError("SequenceSource") << "Error parsing JSON metadata: " << e.what();
@@ -54,11 +141,11 @@ bool SequenceSource::load(const std::filesystem::path &filepath)
 		}
 	}
 	else {
-		return loadImagesFromDirectory(filepath);
+		return listFramesInDirectory(filepath, frames);
 	}
 }
 
-bool SequenceSource::loadImagesFromDirectory(const std::filesystem::path &dirpath)
+bool SequenceSource::listFramesInDirectory(const std::filesystem::path &dirpath, std::vector<std::filesystem::path> &frames)
 {
 	if(!ofDirectory::doesDirectoryExist(dirpath)) {
 		ofLogError("SequenceSource") << "Directory does not exist: " << dirpath;
@@ -68,17 +155,16 @@ bool SequenceSource::loadImagesFromDirectory(const std::filesystem::path &dirpat
 	ofDirectory dir;
 	dir.open(dirpath);
 	dir.sort();
-	pool_.reserve(dir.size());
+	frames.reserve(dir.size());
 	for(auto &&file : dir.getFiles()) {
-		auto tex = AssetManager::getInstance().getTexture(file.path());
-		pool_.push_back(tex);
+		frames.push_back(file.path());
 	}
 
-	if(pool_.empty()) {
+	if(frames.empty()) {
 		ofLogWarning("SequenceSource") << "No images loaded from directory: " << dirpath;
 	}
 	
-	return !pool_.empty();
+	return !frames.empty();
 }
 
 bool SequenceSource::setFrame(Frame frame)
@@ -89,14 +175,15 @@ bool SequenceSource::setFrame(Frame frame)
 	
 	current_frame_ = frame;
 	
-	int new_index = static_cast<int>(frame + frame_offset_);
-	new_index = std::clamp(new_index, 0, static_cast<int>(pool_.size()) - 1);
-	
+	int new_index = getIndex(frame);
 	bool changed = (new_index != current_index_);
 	current_index_ = new_index;
 	
-	if(new_index >= 0 && static_cast<size_t>(new_index) < pool_.size()) {
-		texture_ = pool_[new_index];
+	if(streamer_) {
+		streamer_->setIndex(new_index);
+	}
+	else if(pool_ && new_index >= 0 && static_cast<size_t>(new_index) < pool_->size()) {
+		texture_ = (*pool_)[new_index];
 	}
 	else {
 		texture_.reset();
@@ -105,16 +192,84 @@ bool SequenceSource::setFrame(Frame frame)
 	return changed;
 }
 
+int SequenceSource::getIndex(Frame frame) const
+{
+	int index = static_cast<int>(frame + frame_offset_);
+	return std::clamp(index, 0, static_cast<int>(getDurationFrames()) - 1);
+}
+
+std::filesystem::path SequenceSource::getFramePath(Frame frame) const
+{
+	if(!frames_ || frames_->empty()) {
+		return {};
+	}
+	return (*frames_)[getIndex(frame)];
+}
+
+void SequenceSource::update()
+{
+	if(streamer_ && streamer_->update()) {
+		is_content_changed_ = true;
+	}
+}
+
+bool SequenceSource::consumeContentChange()
+{
+	return std::exchange(is_content_changed_, false);
+}
+
 void SequenceSource::draw(float x, float y, float w, float h) const
 {
+	if(streamer_) {
+		auto tex = streamer_->getTexture();
+		if(tex && tex->isAllocated()) {
+			tex->draw(x,y,w,h);
+		}
+		return;
+	}
 	if(auto tex = texture_.lock()) {
 		tex->draw(x,y,w,h);
 	}
 }
 
+float SequenceSource::getWidth() const
+{
+	if(streamer_) return streamer_->getWidth();
+	return !pool_ || pool_->empty() ? 0.f : (*pool_)[0]->getWidth();
+}
+
+float SequenceSource::getHeight() const
+{
+	if(streamer_) return streamer_->getHeight();
+	return !pool_ || pool_->empty() ? 0.f : (*pool_)[0]->getHeight();
+}
+
+bool SequenceSource::tryGetBatchQuad(BatchQuad &dst) const
+{
+	if(streamer_) {
+		auto tex = streamer_->getTexture();
+		if(!tex || !tex->isAllocated()) {
+			return false;
+		}
+		dst.texture = tex;
+		dst.tex_rect.set(0, 0, tex->getWidth(), tex->getHeight());
+		dst.has_color = false;
+		return true;
+	}
+	auto tex = texture_.lock();
+	if(!tex || !tex->isAllocated()) {
+		return false;
+	}
+	dst.texture = tex->texture.get();
+	dst.tex_rect = tex->rect;
+	dst.has_color = false;
+	return true;
+}
+
 FrameCount SequenceSource::getDurationFrames() const
 {
-	return static_cast<FrameCount>(pool_.size());
+	if(streamer_) return static_cast<FrameCount>(streamer_->getFrameCount());
+	return pool_ ? static_cast<FrameCount>(pool_->size()) : 0.0f;
 }
 
 void SequenceSource::accept(Visitor &visitor) {
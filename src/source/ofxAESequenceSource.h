@@ -1,6 +1,8 @@
 #pragma once
 
 #include "ofxAELayerSource.h"
+#include "../utils/ofxAETextureAtlas.h"
+#include "ofxAESequenceStreamer.h"
 
 namespace ofx { namespace ae {
 
@@ -11,22 +13,45 @@ class SequenceSource : public LayerSource
 public:
 	void accept(Visitor &visitor) override;
 	bool load(const std::filesystem::path &filepath) override;
+	bool read(CompiledReader &reader) override;
+	std::unique_ptr<LayerSource> instantiate() const override;
+	bool setupFrames(const std::vector<std::filesystem::path> &frames, Frame frame_offset);
+	
+	// Resolves the frame files of a sequence from its JSON metadata or from a directory.
+	static bool listFrames(const std::filesystem::path &filepath, std::vector<std::filesystem::path> &frames, Frame &frame_offset);
+	
+	// Sequences loaded while streaming is enabled decode their frames in the background
+	// instead of loading every frame as a texture up front (see SequenceStreamer).
+	static void setStreamingEnabled(bool enable, const SequenceStreamer::Settings &settings = SequenceStreamer::Settings());
+	static bool isStreamingEnabled();
+	const SequenceStreamer* getStreamer() const { return streamer_.get(); }
+	// Image file shown at frame, for renderers that read the images themselves.
+	std::filesystem::path getFramePath(Frame frame) const;
 	
 	bool setFrame(Frame frame) override;
+	bool canSetFrameConcurrently() const override { return true; }
+	void update() override;
+	bool consumeContentChange() override;
 	
 	FrameCount getDurationFrames() const override;
 
 	void draw(float x, float y, float w, float h) const override;
-	float getWidth() const override { return pool_.empty() ? 0.f : pool_[0]->getWidth(); }
-	float getHeight() const override { return pool_.empty() ? 0.f : pool_[0]->getHeight(); }
+	bool tryGetBatchQuad(BatchQuad &dst) const override;
+	float getWidth() const override;
+	float getHeight() const override;
 	SourceType getSourceType() const override { return SourceType::SEQUENCE; }
 	std::string getDebugInfo() const override { return "SequenceSource"; }
 	
 private:
-	bool loadImagesFromDirectory(const std::filesystem::path &dirpath);
+	static bool listFramesInDirectory(const std::filesystem::path &dirpath, std::vector<std::filesystem::path> &frames);
+	int getIndex(Frame frame) const;
 	
-	std::vector<std::shared_ptr<ofTexture>> pool_;
-	std::weak_ptr<ofTexture> texture_;
+	// shared with the instances made by instantiate()
+	std::shared_ptr<const std::vector<std::filesystem::path>> frames_;
+	std::shared_ptr<const std::vector<std::shared_ptr<TextureRegion>>> pool_;
+	std::weak_ptr<TextureRegion> texture_;
+	std::unique_ptr<SequenceStreamer> streamer_;
+	bool is_content_changed_ = false;
 	Frame frame_offset_ = 0.0f;
 	int current_index_ = -1;
 };
@@ -0,0 +1,220 @@
+#include "ofxAESequenceStreamer.h"
+
+#include "ofLog.h"
+#include "../utils/ofxAETaskQueue.h"
+#include <algorithm>
+#include <chrono>
+
+namespace ofx { namespace ae {
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+double millisSince(Clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+}
+
+SequenceStreamer::SequenceStreamer(const std::vector<std::filesystem::path> &frames, const Settings &settings)
+: frames_(frames)
+, settings_(settings)
+, shared_(std::make_shared<Shared>())
+{
+	settings_.prefetch_frames = std::max(0, settings_.prefetch_frames);
+	settings_.uploads_per_update = std::max(1, settings_.uploads_per_update);
+	// wanted frames plus the one on screen
+	size_t slot_count = settings_.prefetch_frames + 2;
+	shared_->slots.resize(slot_count);
+	textures_.resize(slot_count);
+}
+
+bool SequenceStreamer::setup()
+{
+	if(frames_.empty()) {
+		return false;
+	}
+	auto start = Clock::now();
+	ofPixels pixels;
+	if(!ofLoadImage(pixels, frames_[0])) {
+		ofLogError("SequenceStreamer") << "Failed to load image: " << frames_[0];
+		return false;
+	}
+	double millis = millisSince(start);
+	width_ = pixels.getWidth();
+	height_ = pixels.getHeight();
+
+	std::lock_guard<std::mutex> lock(shared_->mutex);
+	auto &slot = shared_->slots[0];
+	slot.index = 0;
+	slot.state = SlotState::DECODED;
+	slot.request = ++request_count_;
+	slot.pixels = std::move(pixels);
+	auto &stats = shared_->stats;
+	stats.decoded++;
+	stats.decode_millis += millis;
+	stats.max_decode_millis = std::max(stats.max_decode_millis, millis);
+	return true;
+}
+
+void SequenceStreamer::collectWanted(int index, std::vector<int> &dst) const
+{
+	dst.clear();
+	const int last = static_cast<int>(frames_.size()) - 1;
+	index = std::clamp(index, 0, last);
+	dst.push_back(index);
+	for(int i = 1; i <= settings_.prefetch_frames; ++i) {
+		int next = index + i * direction_;
+		if(next < 0 || next > last) break;
+		dst.push_back(next);
+	}
+}
+
+int SequenceStreamer::findSlot(int index) const
+{
+	auto &slots = shared_->slots;
+	for(size_t i = 0; i < slots.size(); ++i) {
+		if(slots[i].index == index) return static_cast<int>(i);
+	}
+	return -1;
+}
+
+void SequenceStreamer::requestDecode(size_t slot_index, int index)
+{
+	auto &slot = shared_->slots[slot_index];
+	slot.index = index;
+	slot.state = SlotState::DECODING;
+	slot.request = ++request_count_;
+	slot.pixels.clear();
+
+	std::weak_ptr<Shared> weak_shared = shared_;
+	auto path = frames_[index];
+	uint64_t request = slot.request;
+	TaskQueue::getShared().push([weak_shared, path, slot_index, request]() {
+		if(weak_shared.expired()) return;
+		auto start = Clock::now();
+		ofPixels pixels;
+		bool loaded = ofLoadImage(pixels, path);
+		double millis = millisSince(start);
+
+		auto shared = weak_shared.lock();
+		if(!shared) return;
+		std::lock_guard<std::mutex> lock(shared->mutex);
+		auto &slot = shared->slots[slot_index];
+		if(slot.request != request) return;
+		if(!loaded) {
+			ofLogError("SequenceStreamer") << "Failed to load image: " << path;
+			slot.state = SlotState::FAILED;
+			return;
+		}
+		slot.pixels = std::move(pixels);
+		slot.state = SlotState::DECODED;
+		auto &stats = shared->stats;
+		stats.decoded++;
+		stats.decode_millis += millis;
+		stats.max_decode_millis = std::max(stats.max_decode_millis, millis);
+	});
+}
+
+void SequenceStreamer::upload(size_t slot_index, ofPixels &pixels)
+{
+	auto start = Clock::now();
+	textures_[slot_index].loadData(pixels);
+	double millis = millisSince(start);
+
+	std::lock_guard<std::mutex> lock(shared_->mutex);
+	auto &stats = shared_->stats;
+	stats.uploaded++;
+	stats.upload_millis += millis;
+	stats.max_upload_millis = std::max(stats.max_upload_millis, millis);
+}
+
+bool SequenceStreamer::update()
+{
+	if(frames_.empty()) return false;
+
+	int index = std::clamp(requested_index_, 0, static_cast<int>(frames_.size()) - 1);
+	bool index_changed = index != last_index_;
+	if(index_changed && last_index_ >= 0) {
+		direction_ = index < last_index_ ? -1 : 1;
+	}
+	collectWanted(index, wanted_);
+
+	std::vector<std::pair<size_t, ofPixels>> uploads;
+	{
+		std::lock_guard<std::mutex> lock(shared_->mutex);
+		auto &slots = shared_->slots;
+		auto isWanted = [this](int i) {
+			return std::find(begin(wanted_), end(wanted_), i) != end(wanted_);
+		};
+		// nearest frames first, so the current one is decoded and uploaded before the prefetched ones
+		for(int wanted : wanted_) {
+			if(findSlot(wanted) >= 0) continue;
+			int reuse = -1;
+			for(size_t i = 0; i < slots.size(); ++i) {
+				auto &slot = slots[i];
+				if(static_cast<int>(i) == visible_slot_ || slot.state == SlotState::DECODING || isWanted(slot.index)) {
+					continue;
+				}
+				if(reuse < 0 || slot.state == SlotState::EMPTY) {
+					reuse = static_cast<int>(i);
+					if(slot.state == SlotState::EMPTY) break;
+				}
+			}
+			if(reuse < 0) break;
+			requestDecode(reuse, wanted);
+		}
+		for(int wanted : wanted_) {
+			if(static_cast<int>(uploads.size()) >= settings_.uploads_per_update) break;
+			int i = findSlot(wanted);
+			if(i >= 0 && slots[i].state == SlotState::DECODED) {
+				uploads.emplace_back(i, std::move(slots[i].pixels));
+				slots[i].pixels.clear();
+				slots[i].state = SlotState::UPLOADED;
+			}
+		}
+	}
+	for(auto &&[slot, pixels] : uploads) {
+		upload(slot, pixels);
+	}
+
+	bool visible_changed = false;
+	int slot = -1;
+	{
+		std::lock_guard<std::mutex> lock(shared_->mutex);
+		slot = findSlot(index);
+		if(slot >= 0 && shared_->slots[slot].state != SlotState::UPLOADED) {
+			slot = -1;
+		}
+		if(slot < 0 && index_changed) {
+			shared_->stats.underruns++;
+		}
+	}
+	if(slot >= 0 && index != visible_index_) {
+		visible_slot_ = slot;
+		visible_index_ = index;
+		visible_changed = true;
+	}
+	last_index_ = index;
+	return visible_changed;
+}
+
+const ofTexture* SequenceStreamer::getTexture() const
+{
+	if(visible_slot_ < 0) return nullptr;
+	return &textures_[visible_slot_];
+}
+
+SequenceStreamer::Stats SequenceStreamer::getStats() const
+{
+	std::lock_guard<std::mutex> lock(shared_->mutex);
+	return shared_->stats;
+}
+
+void SequenceStreamer::resetStats()
+{
+	std::lock_guard<std::mutex> lock(shared_->mutex);
+	shared_->stats.reset();
+}
+
+}} // namespace ofx::ae
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "ofMain.h"
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ofx { namespace ae {
+
+// Streams the frames of an image sequence instead of keeping every frame as a texture.
+// Frames are decoded on TaskQueue::getShared() into a bounded ring of ofPixels, starting at the
+// current frame and reaching ahead in the playback direction. update() uploads at most
+// Settings::uploads_per_update decoded frames. If the current frame is not uploaded yet,
+// the last uploaded frame stays visible and an underrun is counted.
+class SequenceStreamer
+{
+public:
+	struct Settings {
+		int prefetch_frames = 8;
+		int uploads_per_update = 2;
+	};
+	struct Stats {
+		size_t decoded = 0;
+		size_t uploaded = 0;
+		size_t underruns = 0;		// frames that were not ready when they had to be shown
+		double decode_millis = 0;	// totals
+		double upload_millis = 0;
+		double max_decode_millis = 0;
+		double max_upload_millis = 0;
+
+		double getAverageDecodeMillis() const { return decoded > 0 ? decode_millis / decoded : 0.0; }
+		double getAverageUploadMillis() const { return uploaded > 0 ? upload_millis / uploaded : 0.0; }
+
+		void reset() {
+			decoded = uploaded = underruns = 0;
+			decode_millis = upload_millis = 0;
+			max_decode_millis = max_upload_millis = 0;
+		}
+	};
+
+	SequenceStreamer(const std::vector<std::filesystem::path> &frames, const Settings &settings);
+
+	// Decodes the first frame synchronously to know the size.
+	bool setup();
+
+	// Only stores the index; safe to call from setFrame() on a worker thread.
+	void setIndex(int index) { requested_index_ = index; }
+	// Main thread. Schedules decodes, uploads and returns true if the visible frame changed.
+	bool update();
+
+	const ofTexture* getTexture() const;
+	int getVisibleIndex() const { return visible_index_; }
+	size_t getFrameCount() const { return frames_.size(); }
+	const std::vector<std::filesystem::path>& getFrames() const { return frames_; }
+	const Settings& getSettings() const { return settings_; }
+	float getWidth() const { return width_; }
+	float getHeight() const { return height_; }
+
+	Stats getStats() const;
+	void resetStats();
+
+private:
+	enum class SlotState {
+		EMPTY,
+		DECODING,
+		DECODED,
+		UPLOADED,
+		FAILED
+	};
+	struct Slot {
+		int index = -1;
+		SlotState state = SlotState::EMPTY;
+		uint64_t request = 0;
+		ofPixels pixels;
+	};
+	// shared with decode jobs, which may finish after the streamer is gone
+	struct Shared {
+		std::mutex mutex;
+		std::vector<Slot> slots;
+		Stats stats;
+	};
+
+	void collectWanted(int index, std::vector<int> &dst) const;
+	int findSlot(int index) const;
+	void requestDecode(size_t slot, int index);
+	void upload(size_t slot, ofPixels &pixels);
+
+	std::vector<std::filesystem::path> frames_;
+	Settings settings_;
+	std::shared_ptr<Shared> shared_;
+	std::vector<ofTexture> textures_;	// one per slot, main thread only
+	uint64_t request_count_ = 0;
+
+	int requested_index_ = 0;
+	int last_index_ = -1;
+	int direction_ = 1;
+	int visible_slot_ = -1;
+	int visible_index_ = -1;
+	float width_ = 0;
+	float height_ = 0;
+	std::vector<int> wanted_;
+};
+
+}} // namespace ofx::ae
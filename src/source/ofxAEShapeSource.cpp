@@ -7,6 +7,7 @@
 #include "../utils/ofxAEBlendMode.h"
 #include "../utils/ofxAETimeUtils.h"
 #include "ofxAEVisitorUtils.h"
+#include "../utils/ofxAECompiledIO.h"
 
 namespace ofx { namespace ae {
 
@@ -26,12 +27,41 @@ bool ShapeSource::setup(const ofJson &json)
 	}
 
 	shape_props_.setup(shapeJson, keyframes);
+	is_shape_dirty_ = true;
 
 	return true;
 }
 
+void ShapeSource::write(CompiledWriter &writer) const
+{
+	shape_props_.write(writer);
+}
+
+bool ShapeSource::read(CompiledReader &reader)
+{
+	visitor_ = std::make_shared<PathExtractionVisitor>();
+	is_shape_dirty_ = true;
+	return shape_props_.read(reader);
+}
+
+std::unique_ptr<LayerSource> ShapeSource::instantiate() const
+{
+	auto ret = std::make_unique<ShapeSource>();
+	ret->fps_ = fps_;
+	ret->visitor_ = std::make_shared<PathExtractionVisitor>();
+	ret->shape_props_.shareFrom(shape_props_);
+	ret->is_shape_dirty_ = true;
+	return ret;
+}
+
 void ShapeSource::update()
 {
+	if(!is_shape_dirty_) {
+		return;
+	}
+	is_shape_dirty_ = false;
+	// the previous render items stay alive until the new ones are built,
+	// so groups whose geometry did not change reuse their cached tessellation
 	if(shape_props_.tryExtract(shape_data_)) {
 		visitor_ = std::make_shared<PathExtractionVisitor>();
 		visitor_->visit(shape_data_);
@@ -46,7 +76,18 @@ bool ShapeSource::setFrame(Frame frame)
 	
 	current_frame_ = frame;
 	
-	return shape_props_.setFrame(frame);
+	if(!shape_props_.setFrame(frame)) {
+		return false;
+	}
+	is_shape_dirty_ = true;
+	return true;
+}
+
+void ShapeSource::gatherEasing(Frame frame, EaseBatch &batch)
+{
+	if(!util::isNearFrame(current_frame_, frame)) {
+		shape_props_.gatherEasing(frame, batch);
+	}
 }
 
 bool ShapeSource::tryExtract(ShapeData &dst) const
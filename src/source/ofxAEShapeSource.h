@@ -15,10 +15,15 @@ public:
 	void accept(Visitor &visitor) override;
 
 	bool setup(const ofJson &json) override;
+	void write(CompiledWriter &writer) const override;
+	bool read(CompiledReader &reader) override;
+	std::unique_ptr<LayerSource> instantiate() const override;
 	void update() override;
 	void draw(float x, float y, float w, float h) const override;
 	
 	bool setFrame(Frame frame) override;
+	void gatherEasing(Frame frame, EaseBatch &batch) override;
+	bool canSetFrameConcurrently() const override { return true; }
 	
 	FrameCount getDurationFrames() const override { return std::numeric_limits<FrameCount>::max(); }
 	
@@ -34,6 +39,8 @@ private:
 	ShapeProp shape_props_;
 	ShapeData shape_data_;
 	std::shared_ptr<PathExtractionVisitor> visitor_;
+	// render items are rebuilt only after the shape properties changed
+	bool is_shape_dirty_ = true;
 };
 
 }} // namespace ofx::ae
@@ -1,6 +1,7 @@
 #include "ofxAESolidSource.h"
 #include "ofxAEVisitor.h"
 #include "../utils/ofxAETimeUtils.h"
+#include "../utils/ofxAECompiledIO.h"
 
 namespace ofx { namespace ae {
 
@@ -9,6 +10,17 @@ void SolidSource::accept(Visitor &visitor)
 	visitor.visit(*this);
 }
 
+void SolidSource::write(CompiledWriter &writer) const
+{
+	writer.write(size_);
+	writer.write(color_);
+}
+
+bool SolidSource::read(CompiledReader &reader)
+{
+	return reader.read(size_) && reader.read(color_);
+}
+
 bool SolidSource::setFrame(Frame frame)
 {
 	if(util::isNearFrame(current_frame_, frame)) {
@@ -21,9 +21,13 @@ public:
 		color_.b = json["color"][2];
 		return true;
 	}
+	void write(CompiledWriter &writer) const override;
+	bool read(CompiledReader &reader) override;
+	std::unique_ptr<LayerSource> instantiate() const override { return std::make_unique<SolidSource>(*this); }
 	void update() override {}
 	
 	bool setFrame(Frame frame) override;
+	bool canSetFrameConcurrently() const override { return true; }
 	
 	FrameCount getDurationFrames() const override { return std::numeric_limits<FrameCount>::max(); }
 
@@ -33,6 +37,12 @@ public:
 		ofDrawRectangle(x,y,w,h);
 		RenderContext::pop();
 	}
+	bool tryGetBatchQuad(BatchQuad &dst) const override {
+		dst.texture = nullptr;
+		dst.has_color = true;
+		dst.color = color_;
+		return true;
+	}
 	float getWidth() const override { return size_.x; }
 	float getHeight() const override { return size_.y; }
 
@@ -40,6 +50,7 @@ public:
 	std::string getDebugInfo() const override { return "SolidSource"; }
 	
 	void setColor(const ofFloatColor &color) { color_ = color; }
+	const ofFloatColor& getColor() const { return color_; }
 	void setSize(float width, float height) { size_.x = width; size_.y = height; }
 	
 private:
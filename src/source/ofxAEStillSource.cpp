@@ -3,6 +3,7 @@
 #include "ofxAEAssetManager.h"
 #include "ofxAEVisitor.h"
 #include "../utils/ofxAETimeUtils.h"
+#include "../utils/ofxAECompiledIO.h"
 
 #include "ofxAEStillSource.h"
 
@@ -11,7 +12,7 @@ namespace ofx { namespace ae {
 bool StillSource::load(const std::filesystem::path &filepath)
 {
 	filepath_ = filepath;
-	texture_ = AssetManager::getInstance().getTexture(filepath);
+	texture_ = AssetManager::getInstance().getTextureRegion(filepath);
 	
 	if(texture_) {
 		ofLogVerbose("StillSource") << "Loaded texture via AssetManager: " << filepath;
@@ -23,6 +24,12 @@ bool StillSource::load(const std::filesystem::path &filepath)
 	}
 }
 
+bool StillSource::read(CompiledReader &reader)
+{
+	std::filesystem::path filepath;
+	return reader.readPath(filepath) && load(filepath);
+}
+
 bool StillSource::setFrame(Frame frame)
 {
 	if(util::isNearFrame(current_frame_, frame)) {
@@ -40,6 +47,17 @@ void StillSource::draw(float x, float y, float w, float h) const
 	}
 }
 
+bool StillSource::tryGetBatchQuad(BatchQuad &dst) const
+{
+	if(!texture_ || !texture_->isAllocated()) {
+		return false;
+	}
+	dst.texture = texture_->texture.get();
+	dst.tex_rect = texture_->rect;
+	dst.has_color = false;
+	return true;
+}
+
 float StillSource::getWidth() const
 {
 	return texture_ ? texture_->getWidth() : 0.0f;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ofxAELayerSource.h"
+#include "../utils/ofxAETextureAtlas.h"
 #include <memory>
 #include <limits>
 
@@ -13,19 +14,24 @@ class StillSource : public LayerSource
 public:
 	void accept(Visitor &visitor) override;
 	bool load(const std::filesystem::path &filepath) override;
+	bool read(CompiledReader &reader) override;
+	std::unique_ptr<LayerSource> instantiate() const override { return std::make_unique<StillSource>(*this); }
 	
 	bool setFrame(Frame frame) override;
+	bool canSetFrameConcurrently() const override { return true; }
 	
 	FrameCount getDurationFrames() const override { return std::numeric_limits<FrameCount>::max(); }
 	
 	void draw(float x, float y, float w, float h) const override;
+	bool tryGetBatchQuad(BatchQuad &dst) const override;
 	float getWidth() const override;
 	float getHeight() const override;
 	SourceType getSourceType() const override { return SourceType::STILL; }
 	std::string getDebugInfo() const override;
+	const std::filesystem::path& getFilePath() const { return filepath_; }
 	
 private:
-	std::shared_ptr<ofTexture> texture_;
+	std::shared_ptr<TextureRegion> texture_;
 	std::filesystem::path filepath_;
 };
 
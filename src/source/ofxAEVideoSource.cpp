@@ -3,6 +3,7 @@
 #include "ofxAEVisitor.h"
 #include "../utils/ofxAEAssetManager.h"
 #include "../utils/ofxAETimeUtils.h"
+#include "../utils/ofxAECompiledIO.h"
 
 #include "ofxAEVideoSource.h"
 
@@ -23,6 +24,12 @@ bool VideoSource::load(const std::filesystem::path &filepath)
 	}
 }
 
+bool VideoSource::read(CompiledReader &reader)
+{
+	std::filesystem::path filepath;
+	return reader.readPath(filepath) && load(filepath);
+}
+
 bool VideoSource::setFrame(Frame frame)
 {
 	if(!player_) return false;
@@ -13,6 +13,9 @@ class VideoSource : public LayerSource
 public:
 	void accept(Visitor &visitor) override;
 	bool load(const std::filesystem::path &filepath) override;
+	bool read(CompiledReader &reader) override;
+	// Instances share the video player, so they all show the frame set last.
+	std::unique_ptr<LayerSource> instantiate() const override { return std::make_unique<VideoSource>(*this); }
 	
 	bool setFrame(Frame frame) override;
 	
@@ -2,92 +2,363 @@
 
 #include "../data/AssetKey.h"
 #include "ofMain.h"
-#include <map>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <future>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
 namespace ofx { namespace ae {
 
 struct CacheStats {
 	size_t hits = 0;
 	size_t misses = 0;
+	size_t waits = 0;			// requests that joined a load already in flight instead of loading again
 	size_t cached_items = 0;
-	
+	size_t retained_items = 0;	// assets kept alive by the budget even if no layer uses them
+	size_t resident_bytes = 0;	// estimated size of the retained assets
+	size_t evictions = 0;
+	size_t reloads = 0;			// misses for assets that had been loaded and released since the last cleanup()
+
 	double getHitRatio() const {
 		size_t total = hits + misses;
 		return total > 0 ? static_cast<double>(hits) / total : 0.0;
 	}
-	
+
 	void reset() {
 		hits = 0;
 		misses = 0;
+		waits = 0;
 		cached_items = 0;
+		retained_items = 0;
+		resident_bytes = 0;
+		evictions = 0;
+		reloads = 0;
+	}
+
+	CacheStats& operator+=(const CacheStats &other) {
+		hits += other.hits;
+		misses += other.misses;
+		waits += other.waits;
+		cached_items += other.cached_items;
+		retained_items += other.retained_items;
+		resident_bytes += other.resident_bytes;
+		evictions += other.evictions;
+		reloads += other.reloads;
+		return *this;
 	}
 };
 
+// Hands out shared assets by key. Entries are weak, so an asset is released as soon as nobody uses it,
+// unless a byte budget is set: then loaded assets are also retained, and once the budget is exceeded
+// the ones that were used least recently (by the frame passed to setFrame()) and that nobody else holds are evicted.
+// Eviction only happens in setFrame() and setBudget(), so assets are never released on a loading thread.
+//
+// Thread-safe. Keys are spread over shards with a lock each, and the loader runs without holding any lock.
+// A get() for a key that is being loaded on another thread waits for that load instead of starting its own.
 template<typename Type>
 class AssetCache {
 public:
 	using LoadFunction = std::function<std::shared_ptr<Type>(const std::filesystem::path&)>;
+	using SizeFunction = std::function<size_t(const Type&)>;
+	// Called repeatedly while get() waits for a load on another thread.
+	using WaitFunction = std::function<void()>;
+
+	explicit AssetCache(SizeFunction size_function = nullptr)
+	: size_function_(size_function) {}
+
+	void setWaitFunction(WaitFunction wait_function) { wait_function_ = wait_function; }
 
 	std::shared_ptr<Type> get(const AssetKey &key, LoadFunction loader = nullptr) {
-		auto it = cache_.find(key);
-		if(it != cache_.end()) {
-			auto asset = it->second.lock();
-			if(asset) {
-				stats_.hits++;
+		auto &shard = getShard(key);
+		std::unique_lock<std::mutex> lock(shard.mutex);
+		auto it = shard.entries.find(key);
+		bool is_reload = false;
+		if(it != shard.entries.end()) {
+			auto &entry = it->second;
+			if(auto asset = entry.asset.lock()) {
+				shard.stats.hits++;
+				touch(shard, key);
 				return asset;
 			}
-			else {
-				cache_.erase(it);
-				stats_.cached_items--;
+			if(entry.loading.valid()) {
+				shard.stats.waits++;
+				auto loading = entry.loading;
+				lock.unlock();
+				return wait(loading);
 			}
+			// the entry outlived its asset, so this was loaded before
+			shard.entries.erase(it);
+			shard.stats.cached_items--;
+			is_reload = true;
 		}
-		
-		stats_.misses++;
-		
-		if(loader) {
-			auto asset = loader(key.getPath());
-			if(asset) {
-				store(key, asset);
-				return asset;
-			}
+
+		shard.stats.misses++;
+		if(!loader) {
+			return nullptr;
 		}
-		
-		return nullptr;
+		if(is_reload) {
+			shard.stats.reloads++;
+		}
+		std::promise<std::shared_ptr<Type>> promise;
+		shard.entries[key].loading = promise.get_future().share();
+		lock.unlock();
+
+		std::shared_ptr<Type> asset;
+		try {
+			asset = loader(key.getPath());
+		}
+		catch(...) {
+			finishLoading(key, nullptr);
+			promise.set_value(nullptr);
+			throw;
+		}
+		finishLoading(key, asset);
+		promise.set_value(asset);
+		return asset;
 	}
 
 	void store(const AssetKey &key, std::shared_ptr<Type> asset) {
 		if(!asset) return;
-		
-		cache_[key] = asset;
-		stats_.cached_items++;
+		auto &shard = getShard(key);
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		storeLocked(shard, key, asset);
 	}
 
-	void cleanup() {
-		auto it = cache_.begin();
-		while(it != cache_.end()) {
-			if(it->second.expired()) {
-				it = cache_.erase(it);
-				stats_.cached_items--;
+	// 0 disables retention; assets then live only as long as someone holds them.
+	void setBudget(size_t bytes) {
+		budget_ = bytes;
+		if(budget_ == 0) {
+			releaseRetained();
+		}
+		else {
+			trim();
+		}
+	}
+	size_t getBudget() const { return budget_; }
+
+	// Advances the clock used for least-recently-used eviction.
+	// Assets held outside the cache count as used in this frame.
+	void setFrame(uint64_t frame) {
+		current_frame_ = frame;
+		for(auto &shard : shards_) {
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			for(auto &&[key, entry] : shard.retained) {
+				if(entry.asset.use_count() > 1) {
+					entry.last_use = frame;
+				}
+				// assets loaded off the main thread only know their size once uploaded
+				if(entry.bytes == 0 && size_function_) {
+					entry.bytes = size_function_(*entry.asset);
+					shard.stats.resident_bytes += entry.bytes;
+				}
 			}
-			else {
-				++it;
+		}
+		trim();
+	}
+
+	void cleanup() {
+		for(auto &shard : shards_) {
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			auto it = shard.entries.begin();
+			while(it != shard.entries.end()) {
+				if(it->second.asset.expired() && !it->second.loading.valid()) {
+					it = shard.entries.erase(it);
+					shard.stats.cached_items--;
+				}
+				else {
+					++it;
+				}
 			}
 		}
 	}
-	
+
+	// Loads in flight are not interrupted; they still complete for whoever is waiting on them.
 	void clear() {
-		cache_.clear();
-		stats_.cached_items = 0;
+		for(auto &shard : shards_) {
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			releaseRetainedLocked(shard);
+			auto it = shard.entries.begin();
+			while(it != shard.entries.end()) {
+				if(it->second.loading.valid()) {
+					it->second.asset.reset();
+					++it;
+				}
+				else {
+					it = shard.entries.erase(it);
+				}
+			}
+			shard.stats.cached_items = 0;
+		}
 	}
-	
-	const CacheStats& getStats() const {
-		return stats_;
+
+	CacheStats getStats() const {
+		CacheStats stats;
+		for(auto &shard : shards_) {
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			stats += shard.stats;
+		}
+		return stats;
+	}
+	// Resets the counters but keeps the numbers describing what is cached right now.
+	void resetStats() {
+		for(auto &shard : shards_) {
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			auto &stats = shard.stats;
+			auto cached_items = stats.cached_items;
+			auto retained_items = stats.retained_items;
+			auto resident_bytes = stats.resident_bytes;
+			stats.reset();
+			stats.cached_items = cached_items;
+			stats.retained_items = retained_items;
+			stats.resident_bytes = resident_bytes;
+		}
 	}
 
 private:
-	std::map<AssetKey, std::weak_ptr<Type>> cache_;
-	CacheStats stats_;
+	static constexpr size_t SHARD_COUNT = 16;
+
+	struct Entry {
+		std::weak_ptr<Type> asset;
+		std::shared_future<std::shared_ptr<Type>> loading;	// valid while the asset is being loaded
+	};
+	struct Retained {
+		std::shared_ptr<Type> asset;
+		size_t bytes = 0;
+		uint64_t last_use = 0;
+	};
+	struct Shard {
+		mutable std::mutex mutex;
+		std::unordered_map<AssetKey, Entry> entries;
+		std::unordered_map<AssetKey, Retained> retained;
+		CacheStats stats;
+	};
+
+	Shard& getShard(const AssetKey &key) {
+		// the low bits index the maps inside the shard
+		return shards_[(key.hash64() >> 32) % SHARD_COUNT];
+	}
+
+	std::shared_ptr<Type> wait(const std::shared_future<std::shared_ptr<Type>> &loading) const {
+		if(wait_function_) {
+			while(loading.wait_for(std::chrono::milliseconds(1)) != std::future_status::ready) {
+				wait_function_();
+			}
+		}
+		return loading.get();
+	}
+
+	void finishLoading(const AssetKey &key, const std::shared_ptr<Type> &asset) {
+		auto &shard = getShard(key);
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		auto it = shard.entries.find(key);
+		if(it == shard.entries.end()) {
+			return;
+		}
+		it->second.loading = {};
+		if(asset) {
+			storeLocked(shard, key, asset);
+		}
+		else {
+			shard.entries.erase(it);
+		}
+	}
+
+	void storeLocked(Shard &shard, const AssetKey &key, const std::shared_ptr<Type> &asset) {
+		auto &entry = shard.entries[key];
+		if(entry.asset.expired()) {
+			shard.stats.cached_items++;
+		}
+		entry.asset = asset;
+		if(budget_ > 0) {
+			retain(shard, key, asset);
+		}
+	}
+
+	void retain(Shard &shard, const AssetKey &key, const std::shared_ptr<Type> &asset) {
+		auto &entry = shard.retained[key];
+		if(entry.asset) {
+			shard.stats.resident_bytes -= entry.bytes;
+		}
+		else {
+			shard.stats.retained_items++;
+		}
+		entry.asset = asset;
+		entry.bytes = size_function_ ? size_function_(*asset) : 0;
+		entry.last_use = current_frame_;
+		shard.stats.resident_bytes += entry.bytes;
+	}
+
+	void touch(Shard &shard, const AssetKey &key) {
+		auto it = shard.retained.find(key);
+		if(it != shard.retained.end()) {
+			it->second.last_use = current_frame_;
+		}
+	}
+
+	// Locks every shard, always in the same order, to find the oldest asset across all of them.
+	// The evicted assets are released after the locks.
+	void trim() {
+		if(budget_ == 0) return;
+		std::vector<std::shared_ptr<Type>> evicted;
+		std::array<std::unique_lock<std::mutex>, SHARD_COUNT> locks;
+		for(size_t i = 0; i < SHARD_COUNT; ++i) {
+			locks[i] = std::unique_lock<std::mutex>(shards_[i].mutex);
+		}
+		size_t resident_bytes = 0;
+		for(auto &shard : shards_) {
+			resident_bytes += shard.stats.resident_bytes;
+		}
+		while(resident_bytes > budget_) {
+			Shard *victim_shard = nullptr;
+			typename std::unordered_map<AssetKey, Retained>::iterator victim;
+			for(auto &shard : shards_) {
+				for(auto it = shard.retained.begin(); it != shard.retained.end(); ++it) {
+					auto &entry = it->second;
+					// evicting an asset someone still holds would not free anything
+					if(entry.asset.use_count() > 1 || entry.last_use >= current_frame_) continue;
+					if(!victim_shard || entry.last_use < victim->second.last_use) {
+						victim_shard = &shard;
+						victim = it;
+					}
+				}
+			}
+			if(!victim_shard) {
+				break;
+			}
+			evicted.push_back(std::move(victim->second.asset));
+			resident_bytes -= victim->second.bytes;
+			victim_shard->stats.resident_bytes -= victim->second.bytes;
+			victim_shard->stats.retained_items--;
+			victim_shard->stats.evictions++;
+			victim_shard->retained.erase(victim);
+		}
+		for(auto &lock : locks) {
+			lock.unlock();
+		}
+	}
+
+	void releaseRetained() {
+		for(auto &shard : shards_) {
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			releaseRetainedLocked(shard);
+		}
+	}
+	void releaseRetainedLocked(Shard &shard) {
+		shard.retained.clear();
+		shard.stats.retained_items = 0;
+		shard.stats.resident_bytes = 0;
+	}
+
+	std::array<Shard, SHARD_COUNT> shards_;
+	SizeFunction size_function_;
+	WaitFunction wait_function_;
+	std::atomic<size_t> budget_{0};
+	std::atomic<uint64_t> current_frame_{0};
 };
 
 }} // namespace ofx::ae
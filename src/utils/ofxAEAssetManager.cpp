@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <sstream>
 
 #include "ofLog.h"
@@ -6,15 +7,56 @@
 #include "ofxAEComposition.h"
 
 #include "ofxAEAssetManager.h"
+#include "ofxAETaskQueue.h"
 
 namespace ofx { namespace ae {
 
+namespace {
+size_t rgbaBytes(float width, float height)
+{
+	return static_cast<size_t>(std::max(0.f, width) * std::max(0.f, height)) * 4;
+}
+}
+
 AssetManager& AssetManager::getInstance()
 {
 	static AssetManager instance;
 	return instance;
 }
 
+AssetManager::AssetManager()
+: texture_cache_([](const ofTexture &texture) { return rgbaBytes(texture.getWidth(), texture.getHeight()); })
+, region_cache_([](const TextureRegion &region) -> size_t {
+	// regions covering a whole texture share it with texture_cache_, which accounts for it
+	if(!region.texture || (region.rect.width == region.texture->getWidth() && region.rect.height == region.texture->getHeight())) {
+		return 0;
+	}
+	return rgbaBytes(region.getWidth(), region.getHeight());
+})
+, pixels_cache_([](const ofPixels &pixels) { return pixels.getTotalBytes(); })
+, video_cache_([](const ofVideoPlayer &video) { return rgbaBytes(video.getWidth(), video.getHeight()); })
+, composition_cache_([](const Composition &composition) { return rgbaBytes(composition.getWidth(), composition.getHeight()); })
+, main_thread_id_(std::this_thread::get_id())
+{
+	// a load on another thread may be waiting for the main thread, e.g. to open a video
+	auto wait = [this]() {
+		if(isMainThread()) {
+			processMainThreadWork();
+		}
+	};
+	texture_cache_.setWaitFunction(wait);
+	region_cache_.setWaitFunction(wait);
+	pixels_cache_.setWaitFunction(wait);
+	video_cache_.setWaitFunction(wait);
+	composition_cache_.setWaitFunction(wait);
+}
+
+AssetManager::~AssetManager()
+{
+	// stop the loading threads before the caches they use go away
+	loader_.reset();
+}
+
 std::shared_ptr<ofTexture> AssetManager::getTexture(const std::filesystem::path &path)
 {
 	AssetKey key(path, AssetKey::AssetType::TEXTURE);
@@ -26,6 +68,81 @@ std::shared_ptr<ofTexture> AssetManager::getTexture(const std::filesystem::path
 	return texture_cache_.get(key, loader);
 }
 
+template<typename Type>
+AssetRequest<Type> AssetManager::request(std::function<std::shared_ptr<Type>()> load)
+{
+	std::call_once(loader_once_, [this]() {
+		loader_ = std::make_unique<TaskQueue>();
+	});
+	using Result = typename AssetRequest<Type>::Result;
+	auto promise = std::make_shared<std::promise<Result>>();
+	AssetRequest<Type> ret;
+	ret.state_ = std::make_shared<typename AssetRequest<Type>::State>();
+	ret.state_->future = promise->get_future().share();
+	++pending_requests_;
+	loader_->push([this, promise, load]() {
+		Result result;
+		result.asset = load();
+		result.upload_ticket = getUploadTicket();
+		promise->set_value(result);
+		--pending_requests_;
+		// if the request was dropped, ours may be the last reference; release it where GL is available
+		if(result.asset) {
+			runOnMainThread([asset = std::move(result.asset)]() {});
+		}
+	});
+	return ret;
+}
+
+AssetRequest<ofTexture> AssetManager::requestTexture(const std::filesystem::path &path)
+{
+	return request<ofTexture>([this, path]() {
+		return getTexture(path);
+	});
+}
+
+AssetRequest<Composition> AssetManager::requestComposition(const std::filesystem::path &path)
+{
+	return request<Composition>([this, path]() {
+		return getComposition(path);
+	});
+}
+
+std::shared_ptr<TextureRegion> AssetManager::getTextureRegion(const std::filesystem::path &path)
+{
+	if(!is_atlas_enabled_ || !is_upload_enabled_) {
+		return TextureRegion::fromTexture(getTexture(path));
+	}
+	AssetKey key(path, AssetKey::AssetType::TEXTURE, "atlas");
+
+	auto loader = [this](const std::filesystem::path& p) {
+		return createTextureRegion(p);
+	};
+
+	return region_cache_.get(key, loader);
+}
+
+std::shared_ptr<ofPixels> AssetManager::getPixels(const std::filesystem::path &path)
+{
+	AssetKey key(path, AssetKey::AssetType::TEXTURE, "pixels");
+
+	auto loader = [this](const std::filesystem::path& p) {
+		return createPixels(p);
+	};
+
+	return pixels_cache_.get(key, loader);
+}
+
+void AssetManager::setAtlasEnabled(bool enable)
+{
+	is_atlas_enabled_ = enable;
+}
+
+void AssetManager::setAtlasSettings(const TextureAtlas::Settings &settings)
+{
+	atlas_.setup(settings);
+}
+
 std::shared_ptr<ofVideoPlayer> AssetManager::getVideo(const std::filesystem::path &path)
 {
 	AssetKey key(path, AssetKey::AssetType::VIDEO);
@@ -48,16 +165,142 @@ std::shared_ptr<Composition> AssetManager::getComposition(const std::filesystem:
 	return composition_cache_.get(key, loader);
 }
 
+void AssetManager::setBudget(AssetKey::AssetType type, size_t bytes)
+{
+	switch(type) {
+		case AssetKey::AssetType::TEXTURE:
+			texture_cache_.setBudget(bytes);
+			break;
+		case AssetKey::AssetType::VIDEO:
+			video_cache_.setBudget(bytes);
+			break;
+		case AssetKey::AssetType::COMPOSITION:
+			composition_cache_.setBudget(bytes);
+			break;
+		default:
+			ofLogWarning("AssetManager") << "No budget for asset type: " << AssetKey::assetTypeToString(type);
+			break;
+	}
+}
+
+size_t AssetManager::getBudget(AssetKey::AssetType type) const
+{
+	switch(type) {
+		case AssetKey::AssetType::TEXTURE: return texture_cache_.getBudget();
+		case AssetKey::AssetType::VIDEO: return video_cache_.getBudget();
+		case AssetKey::AssetType::COMPOSITION: return composition_cache_.getBudget();
+		default: return 0;
+	}
+}
+
+void AssetManager::setAtlasBudget(size_t bytes)
+{
+	region_cache_.setBudget(bytes);
+}
+
+size_t AssetManager::getAtlasBudget() const
+{
+	return region_cache_.getBudget();
+}
+
+void AssetManager::setPixelsBudget(size_t bytes)
+{
+	pixels_cache_.setBudget(bytes);
+}
+
+size_t AssetManager::getPixelsBudget() const
+{
+	return pixels_cache_.getBudget();
+}
+
+void AssetManager::update()
+{
+	main_thread_id_ = std::this_thread::get_id();
+	processMainThreadWork();
+	++frame_count_;
+	texture_cache_.setFrame(frame_count_);
+	region_cache_.setFrame(frame_count_);
+	pixels_cache_.setFrame(frame_count_);
+	video_cache_.setFrame(frame_count_);
+	composition_cache_.setFrame(frame_count_);
+	// evicted regions give their space back to the atlas
+	atlas_.cleanup();
+}
+
+bool AssetManager::processMainThreadWork()
+{
+	std::vector<Upload> uploads;
+	std::deque<std::function<void()>> jobs;
+	uint64_t ticket;
+	{
+		std::lock_guard<std::mutex> lock(main_thread_mutex_);
+		ticket = upload_ticket_;
+		uploads.swap(pending_uploads_);
+		jobs.swap(main_thread_jobs_);
+	}
+	size_t count = atlas_.flushUploads() + uploads.size() + jobs.size();
+	for(auto &&upload : uploads) {
+		upload.texture->loadData(upload.pixels);
+	}
+	for(auto &&job : jobs) {
+		job();
+	}
+	uploaded_ticket_ = ticket;
+	return count > 0;
+}
+
+void AssetManager::runOnMainThread(std::function<void()> job)
+{
+	std::lock_guard<std::mutex> lock(main_thread_mutex_);
+	main_thread_jobs_.push_back(std::move(job));
+}
+
+void AssetManager::queueUpload(std::shared_ptr<ofTexture> texture, ofPixels &&pixels)
+{
+	// report the size before the upload, so regions and budgets see it right away
+	auto &data = texture->getTextureData();
+	data.width = pixels.getWidth();
+	data.height = pixels.getHeight();
+	std::lock_guard<std::mutex> lock(main_thread_mutex_);
+	pending_uploads_.push_back({std::move(texture), std::move(pixels)});
+	++upload_ticket_;
+}
+
+void AssetManager::queueAtlasUpload()
+{
+	// the upload itself is queued in atlas_
+	std::lock_guard<std::mutex> lock(main_thread_mutex_);
+	++upload_ticket_;
+}
+
+uint64_t AssetManager::getUploadTicket() const
+{
+	std::lock_guard<std::mutex> lock(main_thread_mutex_);
+	return upload_ticket_;
+}
+
+size_t AssetManager::getPendingUploadCount() const
+{
+	std::lock_guard<std::mutex> lock(main_thread_mutex_);
+	return pending_uploads_.size() + atlas_.getPendingUploadCount();
+}
+
 void AssetManager::cleanup()
 {
 	texture_cache_.cleanup();
+	region_cache_.cleanup();
+	pixels_cache_.cleanup();
 	video_cache_.cleanup();
 	composition_cache_.cleanup();
+	atlas_.cleanup();
 }
 
 void AssetManager::clearTextureCache()
 {
 	texture_cache_.clear();
+	region_cache_.clear();
+	pixels_cache_.clear();
+	atlas_.clear();
 }
 
 void AssetManager::clearVideoCache()
@@ -81,6 +324,9 @@ AssetManager::AssetStats AssetManager::getStats() const
 {
 	AssetStats stats;
 	stats.texture_stats = texture_cache_.getStats();
+	stats.region_stats = region_cache_.getStats();
+	stats.pixels_stats = pixels_cache_.getStats();
+	stats.atlas_pages = atlas_.getPageStats();
 	stats.video_stats = video_cache_.getStats();
 	stats.composition_stats = composition_cache_.getStats();
 	return stats;
@@ -88,9 +334,11 @@ AssetManager::AssetStats AssetManager::getStats() const
 
 void AssetManager::resetStats()
 {
-	const_cast<CacheStats&>(texture_cache_.getStats()).reset();
-	const_cast<CacheStats&>(video_cache_.getStats()).reset();
-	const_cast<CacheStats&>(composition_cache_.getStats()).reset();
+	texture_cache_.resetStats();
+	region_cache_.resetStats();
+	pixels_cache_.resetStats();
+	video_cache_.resetStats();
+	composition_cache_.resetStats();
 }
 
 std::string AssetManager::getDebugInfo() const
@@ -100,22 +348,38 @@ std::string AssetManager::getDebugInfo() const
 
 	oss << "AssetManager Debug Info:\n";
 	oss << "========================\n";
-	oss << "Overall Hit Ratio: " << (stats.getOverallHitRatio() * 100.0) << "%\n\n";
+	oss << "Overall Hit Ratio: " << (stats.getOverallHitRatio() * 100.0) << "%\n";
+	oss << "Resident: " << stats.getResidentBytes() / 1024 << " KB, Evictions: " << stats.getEvictions() << ", Reloads: " << stats.getReloads() << "\n\n";
 
 	oss << "Texture Cache:\n";
 	oss << "  Items: " << stats.texture_stats.cached_items << "\n";
 	oss << "  Hits: " << stats.texture_stats.hits << ", Misses: " << stats.texture_stats.misses << "\n";
-	oss << "  Hit Ratio: " << (stats.texture_stats.getHitRatio() * 100.0) << "%\n\n";
+	oss << "  Hit Ratio: " << (stats.texture_stats.getHitRatio() * 100.0) << "%\n";
+	oss << "  Retained: " << stats.texture_stats.retained_items << " (" << stats.texture_stats.resident_bytes / 1024 << " KB), Evictions: " << stats.texture_stats.evictions << ", Reloads: " << stats.texture_stats.reloads << "\n\n";
+
+	oss << "Atlas Region Cache:\n";
+	oss << "  Items: " << stats.region_stats.cached_items << "\n";
+	oss << "  Hits: " << stats.region_stats.hits << ", Misses: " << stats.region_stats.misses << "\n";
+	oss << "  Hit Ratio: " << (stats.region_stats.getHitRatio() * 100.0) << "%\n";
+	oss << "  Retained: " << stats.region_stats.retained_items << " (" << stats.region_stats.resident_bytes / 1024 << " KB), Evictions: " << stats.region_stats.evictions << ", Reloads: " << stats.region_stats.reloads << "\n";
+	oss << "  " << atlas_.getDebugInfo() << "\n";
+
+	oss << "Pixels Cache:\n";
+	oss << "  Items: " << stats.pixels_stats.cached_items << "\n";
+	oss << "  Hits: " << stats.pixels_stats.hits << ", Misses: " << stats.pixels_stats.misses << "\n";
+	oss << "  Retained: " << stats.pixels_stats.retained_items << " (" << stats.pixels_stats.resident_bytes / 1024 << " KB), Evictions: " << stats.pixels_stats.evictions << ", Reloads: " << stats.pixels_stats.reloads << "\n\n";
 
 	oss << "Video Cache:\n";
 	oss << "  Items: " << stats.video_stats.cached_items << "\n";
 	oss << "  Hits: " << stats.video_stats.hits << ", Misses: " << stats.video_stats.misses << "\n";
-	oss << "  Hit Ratio: " << (stats.video_stats.getHitRatio() * 100.0) << "%\n\n";
+	oss << "  Hit Ratio: " << (stats.video_stats.getHitRatio() * 100.0) << "%\n";
+	oss << "  Retained: " << stats.video_stats.retained_items << " (" << stats.video_stats.resident_bytes / 1024 << " KB), Evictions: " << stats.video_stats.evictions << ", Reloads: " << stats.video_stats.reloads << "\n\n";
 
 	oss << "Composition Cache:\n";
 	oss << "  Items: " << stats.composition_stats.cached_items << "\n";
 	oss << "  Hits: " << stats.composition_stats.hits << ", Misses: " << stats.composition_stats.misses << "\n";
 	oss << "  Hit Ratio: " << (stats.composition_stats.getHitRatio() * 100.0) << "%\n";
+	oss << "  Retained: " << stats.composition_stats.retained_items << " (" << stats.composition_stats.resident_bytes / 1024 << " KB), Evictions: " << stats.composition_stats.evictions << ", Reloads: " << stats.composition_stats.reloads << "\n";
 
 	return oss.str();
 }
@@ -129,6 +393,29 @@ std::shared_ptr<ofTexture> AssetManager::createTexture(const std::filesystem::pa
 {
 	auto texture = std::make_shared<ofTexture>();
 
+	if(!is_upload_enabled_) {
+		auto pixels = getPixels(path);
+		if(!pixels) {
+			return nullptr;
+		}
+		// nothing to draw with, but sources and regions need the size
+		auto &data = texture->getTextureData();
+		data.width = pixels->getWidth();
+		data.height = pixels->getHeight();
+		return texture;
+	}
+
+	if(!isMainThread()) {
+		ofPixels pixels;
+		if(!ofLoadImage(pixels, path)) {
+			ofLogError("AssetManager") << "Failed to load texture: " << path;
+			return nullptr;
+		}
+		queueUpload(texture, std::move(pixels));
+		ofLogVerbose("AssetManager") << "Loaded texture, upload queued: " << path;
+		return texture;
+	}
+
 	if(ofLoadImage(*texture, path)) {
 		ofLogVerbose("AssetManager") << "Loaded texture: " << path;
 		return texture;
@@ -139,8 +426,58 @@ std::shared_ptr<ofTexture> AssetManager::createTexture(const std::filesystem::pa
 	}
 }
 
+std::shared_ptr<TextureRegion> AssetManager::createTextureRegion(const std::filesystem::path &path)
+{
+	ofPixels pixels;
+	if(!ofLoadImage(pixels, path)) {
+		ofLogError("AssetManager") << "Failed to load image: " << path;
+		return nullptr;
+	}
+	bool defer_upload = !isMainThread();
+	if(auto region = atlas_.add(pixels, defer_upload)) {
+		if(defer_upload) {
+			queueAtlasUpload();
+		}
+		ofLogVerbose("AssetManager") << "Packed into atlas: " << path;
+		return region;
+	}
+	// too large for the atlas; share it with getTexture()
+	AssetKey key(path, AssetKey::AssetType::TEXTURE);
+	auto texture = texture_cache_.get(key, [&](const std::filesystem::path&) {
+		auto texture = std::make_shared<ofTexture>();
+		if(defer_upload) {
+			queueUpload(texture, std::move(pixels));
+		}
+		else {
+			texture->loadData(pixels);
+		}
+		return texture;
+	});
+	return TextureRegion::fromTexture(texture);
+}
+
+std::shared_ptr<ofPixels> AssetManager::createPixels(const std::filesystem::path &path)
+{
+	auto pixels = std::make_shared<ofPixels>();
+	if(!ofLoadImage(*pixels, path)) {
+		ofLogError("AssetManager") << "Failed to load image: " << path;
+		return nullptr;
+	}
+	ofLogVerbose("AssetManager") << "Decoded image: " << path;
+	return pixels;
+}
+
 std::shared_ptr<ofVideoPlayer> AssetManager::createVideo(const std::filesystem::path &path)
 {
+	if(!isMainThread()) {
+		// video players are opened on the main thread; this waits for the next update()
+		std::promise<std::shared_ptr<ofVideoPlayer>> promise;
+		auto future = promise.get_future();
+		runOnMainThread([this, path, &promise]() {
+			promise.set_value(createVideo(path));
+		});
+		return future.get();
+	}
 	auto video = std::make_shared<ofVideoPlayer>();
 
 	if(video->load(path)) {
@@ -163,6 +500,9 @@ std::shared_ptr<Composition> AssetManager::createComposition(const std::filesyst
 	}
 	else {
 		ofLogError("AssetManager") << "Failed to load composition: " << path;
+		if(!isMainThread()) {
+			runOnMainThread([composition]() {});
+		}
 		return nullptr;
 	}
 }
@@ -1,17 +1,55 @@
 #pragma once
 
 #include "ofxAEAssetCache.h"
+#include "ofxAETextureAtlas.h"
 #include "../data/AssetKey.h"
 #include "ofMain.h"
+#include <atomic>
+#include <deque>
+#include <future>
 #include <memory>
+#include <mutex>
 #include <functional>
+#include <thread>
 
 namespace ofx { namespace ae {
 	class Composition;
+	class TaskQueue;
 }}
 
 namespace ofx { namespace ae {
 
+// Handle to an asset requested with AssetManager::requestTexture()/requestComposition().
+// Becomes ready once the asset is loaded and its textures are uploaded by AssetManager::update().
+template<typename Type>
+class AssetRequest
+{
+public:
+	AssetRequest() = default;
+
+	bool isValid() const { return state_ != nullptr; }
+	bool isReady() const;
+	// nullptr until ready, or if loading failed
+	std::shared_ptr<Type> get() const { return isReady() ? state_->future.get().asset : nullptr; }
+	// Blocks until ready. On the main thread this runs AssetManager::update()'s upload work while waiting;
+	// on other threads it returns once loaded, possibly before the upload.
+	std::shared_ptr<Type> wait() const;
+
+private:
+	friend class AssetManager;
+	struct Result {
+		std::shared_ptr<Type> asset;
+		uint64_t upload_ticket = 0;	// uploads queued up to here belong to this request
+	};
+	struct State {
+		std::shared_future<Result> future;
+	};
+	std::shared_ptr<State> state_;
+};
+
+// Shared cache of textures, videos and compositions. All getters are thread-safe.
+// Off the main thread, GL work is deferred: textures and atlas regions are returned
+// right away and uploaded by the next update(), and videos are opened by update() while the caller waits.
 class AssetManager
 {
 public:
@@ -24,6 +62,51 @@ public:
 	std::shared_ptr<ofVideoPlayer> getVideo(const std::filesystem::path &path);
 	std::shared_ptr<Composition> getComposition(const std::filesystem::path &path);
 
+	// Load on a background thread, e.g. to preload the next scene without stalling the render loop.
+	// Requests for an asset that is already loading share that load.
+	AssetRequest<ofTexture> requestTexture(const std::filesystem::path &path);
+	AssetRequest<Composition> requestComposition(const std::filesystem::path &path);
+	size_t getPendingRequestCount() const { return pending_requests_; }
+	size_t getPendingUploadCount() const;
+
+	// Image for StillSource/SequenceSource. With the atlas enabled, images up to
+	// TextureAtlas::Settings::max_region_size are packed into shared atlas pages;
+	// otherwise the region covers a texture from getTexture().
+	// Enable the atlas before loading compositions; regions already handed out are kept.
+	std::shared_ptr<TextureRegion> getTextureRegion(const std::filesystem::path &path);
+	void setAtlasEnabled(bool enable);
+	bool isAtlasEnabled() const { return is_atlas_enabled_; }
+	void setAtlasSettings(const TextureAtlas::Settings &settings);
+	const TextureAtlas& getAtlas() const { return atlas_; }
+
+	// Decoded image in CPU memory, for SoftwareRenderer. Cached separately from the textures.
+	std::shared_ptr<ofPixels> getPixels(const std::filesystem::path &path);
+	// Without a GL context (e.g. a headless process rendering with SoftwareRenderer), disable
+	// uploads before loading anything: textures then only carry the image size, and
+	// the images are decoded into getPixels() instead.
+	void setUploadEnabled(bool enable) { is_upload_enabled_ = enable; }
+	bool isUploadEnabled() const { return is_upload_enabled_; }
+
+	// Keeps loaded assets alive up to an estimated byte budget, so assets that go out of use
+	// and come back later are not reloaded. Over budget, the least recently used ones are evicted.
+	// TEXTURE covers the textures from getTexture(), VIDEO the video frames,
+	// COMPOSITION the compositions' render targets. 0 (the default) retains nothing.
+	// Each budget applies to one cache, so the limits add up.
+	void setBudget(AssetKey::AssetType type, size_t bytes);
+	size_t getBudget(AssetKey::AssetType type) const;
+	// Images packed into atlas pages by getTextureRegion(); regions covering a whole texture
+	// are accounted for by the TEXTURE budget.
+	void setAtlasBudget(size_t bytes);
+	size_t getAtlasBudget() const;
+	// Decoded images from getPixels().
+	void setPixelsBudget(size_t bytes);
+	size_t getPixelsBudget() const;
+	// Call once per frame on the main thread; Player::update() does this.
+	// Uploads what was loaded in the background and drives the least-recently-used order.
+	void update();
+	uint64_t getFrameCount() const { return frame_count_; }
+	bool isMainThread() const { return std::this_thread::get_id() == main_thread_id_; }
+
 	void cleanup();
 	void clearTextureCache();
 	void clearVideoCache();
@@ -32,14 +115,29 @@ public:
 	
 	struct AssetStats {
 		CacheStats texture_stats;
+		CacheStats region_stats;
+		CacheStats pixels_stats;
 		CacheStats video_stats;
 		CacheStats composition_stats;
+		std::vector<TextureAtlas::PageStats> atlas_pages;
 		
 		double getOverallHitRatio() const {
-			size_t total_hits = texture_stats.hits + video_stats.hits + composition_stats.hits;
-			size_t total_requests = total_hits + texture_stats.misses + video_stats.misses + composition_stats.misses;
+			size_t total_hits = texture_stats.hits + region_stats.hits + pixels_stats.hits + video_stats.hits + composition_stats.hits;
+			size_t total_requests = total_hits + texture_stats.misses + region_stats.misses + pixels_stats.misses + video_stats.misses + composition_stats.misses;
 			return total_requests > 0 ? static_cast<double>(total_hits) / total_requests : 0.0;
 		}
+		size_t getResidentBytes() const {
+			return texture_stats.resident_bytes + region_stats.resident_bytes + pixels_stats.resident_bytes + video_stats.resident_bytes + composition_stats.resident_bytes;
+		}
+		size_t getEvictions() const {
+			return texture_stats.evictions + region_stats.evictions + pixels_stats.evictions + video_stats.evictions + composition_stats.evictions;
+		}
+		size_t getWaits() const {
+			return texture_stats.waits + region_stats.waits + pixels_stats.waits + video_stats.waits + composition_stats.waits;
+		}
+		size_t getReloads() const {
+			return texture_stats.reloads + region_stats.reloads + pixels_stats.reloads + video_stats.reloads + composition_stats.reloads;
+		}
 	};
 	
 	AssetStats getStats() const;
@@ -49,15 +147,74 @@ public:
 	void logCacheStats() const;
 	
 private:
-	AssetManager() = default;
+	AssetManager();
+	~AssetManager();
 	
 	AssetCache<ofTexture> texture_cache_;
+	AssetCache<TextureRegion> region_cache_;
+	AssetCache<ofPixels> pixels_cache_;
 	AssetCache<ofVideoPlayer> video_cache_;
 	AssetCache<Composition> composition_cache_;
+	TextureAtlas atlas_;
+	std::atomic<bool> is_atlas_enabled_{false};
+	std::atomic<bool> is_upload_enabled_{true};
+	uint64_t frame_count_ = 0;
+
+	template<typename Type> friend class AssetRequest;
+	struct Upload {
+		std::shared_ptr<ofTexture> texture;
+		ofPixels pixels;
+	};
+	// Main thread only. Runs the queued GL work; returns false if there was none.
+	bool processMainThreadWork();
+	void runOnMainThread(std::function<void()> job);
+	void queueUpload(std::shared_ptr<ofTexture> texture, ofPixels &&pixels);
+	void queueAtlasUpload();
+	uint64_t getUploadTicket() const;
+	bool isUploaded(uint64_t ticket) const { return uploaded_ticket_ >= ticket; }
+	template<typename Type>
+	AssetRequest<Type> request(std::function<std::shared_ptr<Type>()> load);
+
+	std::atomic<std::thread::id> main_thread_id_;
+	mutable std::mutex main_thread_mutex_;
+	std::deque<std::function<void()>> main_thread_jobs_;
+	std::vector<Upload> pending_uploads_;
+	uint64_t upload_ticket_ = 0;
+	std::atomic<uint64_t> uploaded_ticket_{0};
+	std::atomic<size_t> pending_requests_{0};
+	std::once_flag loader_once_;
+	std::unique_ptr<TaskQueue> loader_;
 	
 	std::shared_ptr<ofTexture> createTexture(const std::filesystem::path& path);
+	std::shared_ptr<TextureRegion> createTextureRegion(const std::filesystem::path& path);
+	std::shared_ptr<ofPixels> createPixels(const std::filesystem::path& path);
 	std::shared_ptr<ofVideoPlayer> createVideo(const std::filesystem::path& path);
 	std::shared_ptr<Composition> createComposition(const std::filesystem::path& path);
 };
 
+template<typename Type>
+bool AssetRequest<Type>::isReady() const
+{
+	if(!state_ || state_->future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+		return false;
+	}
+	return AssetManager::getInstance().isUploaded(state_->future.get().upload_ticket);
+}
+
+template<typename Type>
+std::shared_ptr<Type> AssetRequest<Type>::wait() const
+{
+	if(!state_) return nullptr;
+	auto &manager = AssetManager::getInstance();
+	if(!manager.isMainThread()) {
+		return state_->future.get().asset;
+	}
+	while(!isReady()) {
+		if(!manager.processMainThreadWork()) {
+			state_->future.wait_for(std::chrono::milliseconds(1));
+		}
+	}
+	return state_->future.get().asset;
+}
+
 }} // namespace ofx::ae
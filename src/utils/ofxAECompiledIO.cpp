@@ -0,0 +1,445 @@
+#include "ofxAECompiledIO.h"
+
+#include <fstream>
+
+#include "ofLog.h"
+#include "../core/ofxAEComposition.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ofx { namespace ae {
+
+namespace {
+size_t alignedSize(size_t size, size_t alignment)
+{
+	return (size + alignment - 1) / alignment * alignment;
+}
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const std::filesystem::path &filepath)
+{
+	close();
+#ifndef _WIN32
+	int fd = ::open(filepath.c_str(), O_RDONLY);
+	if(fd >= 0) {
+		struct stat st;
+		if(fstat(fd, &st) == 0 && st.st_size > 0) {
+			void *ptr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if(ptr != MAP_FAILED) {
+				data_ = static_cast<const uint8_t*>(ptr);
+				size_ = st.st_size;
+				is_mapped_ = true;
+			}
+		}
+		::close(fd);
+		if(is_mapped_) {
+			return true;
+		}
+	}
+#endif
+	// fallback: read the whole file into memory
+	std::ifstream ifs(filepath, std::ios::binary | std::ios::ate);
+	if(!ifs) {
+		return false;
+	}
+	auto size = static_cast<size_t>(ifs.tellg());
+	buffer_.resize(size);
+	ifs.seekg(0);
+	if(!ifs.read(reinterpret_cast<char*>(buffer_.data()), size)) {
+		buffer_.clear();
+		return false;
+	}
+	data_ = buffer_.data();
+	size_ = size;
+	return size_ > 0;
+}
+
+void MappedFile::close()
+{
+#ifndef _WIN32
+	if(is_mapped_ && data_) {
+		munmap(const_cast<uint8_t*>(data_), size_);
+	}
+#endif
+	data_ = nullptr;
+	size_ = 0;
+	is_mapped_ = false;
+	buffer_.clear();
+}
+
+CompiledWriter::CompiledWriter(const std::filesystem::path &base_dir)
+: base_dir_(base_dir)
+{
+}
+
+void CompiledWriter::append(const void *src, size_t size)
+{
+	if(size == 0) return;
+	auto pos = data_.size();
+	data_.resize(pos + size);
+	std::memcpy(data_.data() + pos, src, size);
+}
+
+void CompiledWriter::align(size_t alignment)
+{
+	data_.resize(alignedSize(data_.size(), alignment), 0);
+}
+
+uint32_t CompiledWriter::addString(const std::string &str)
+{
+	auto found = string_index_.find(str);
+	if(found != end(string_index_)) {
+		return found->second;
+	}
+	uint32_t index = static_cast<uint32_t>(strings_.size());
+	strings_.push_back(str);
+	string_index_.insert({str, index});
+	return index;
+}
+
+void CompiledWriter::write(const std::string &str)
+{
+	write<uint32_t>(addString(str));
+}
+
+void CompiledWriter::write(const ofFloatColor &color)
+{
+	write<float>(color.r);
+	write<float>(color.g);
+	write<float>(color.b);
+	write<float>(color.a);
+}
+
+void CompiledWriter::write(const PathData &path)
+{
+	auto writePool = [this](const std::vector<glm::vec2> &src) {
+		write<uint32_t>(static_cast<uint32_t>(vertices_.size()));
+		write<uint32_t>(static_cast<uint32_t>(src.size()));
+		vertices_.insert(end(vertices_), begin(src), end(src));
+	};
+	writePool(path.vertices);
+	writePool(path.inTangents);
+	writePool(path.outTangents);
+	write<uint8_t>(path.closed);
+	write(path.direction);
+	write<uint8_t>(path.visible);
+}
+
+void CompiledWriter::writePath(const std::filesystem::path &path)
+{
+	std::error_code ec;
+	auto relative = std::filesystem::relative(path, base_dir_, ec);
+	write((ec || relative.empty() ? path : relative).generic_string());
+}
+
+size_t CompiledWriter::beginBlock()
+{
+	write<uint32_t>(0);
+	return data_.size();
+}
+
+void CompiledWriter::endBlock(size_t block)
+{
+	uint32_t size = static_cast<uint32_t>(data_.size() - block);
+	std::memcpy(data_.data() + block - sizeof(uint32_t), &size, sizeof(uint32_t));
+}
+
+uint32_t CompiledWriter::requestComposition(const std::filesystem::path &filepath)
+{
+	std::error_code ec;
+	auto canonical = std::filesystem::weakly_canonical(filepath, ec);
+	std::string key = (ec ? filepath : canonical).generic_string();
+	auto found = composition_index_.find(key);
+	if(found != end(composition_index_)) {
+		return found->second;
+	}
+	uint32_t index = static_cast<uint32_t>(composition_index_.size());
+	composition_index_.insert({key, index});
+	pending_compositions_.push_back({filepath, index});
+	return index;
+}
+
+bool CompiledWriter::popRequestedComposition(std::filesystem::path &filepath, uint32_t &index)
+{
+	if(pending_compositions_.empty()) {
+		return false;
+	}
+	filepath = pending_compositions_.front().first;
+	index = pending_compositions_.front().second;
+	pending_compositions_.erase(begin(pending_compositions_));
+	return true;
+}
+
+void CompiledWriter::beginComposition(uint32_t index)
+{
+	align(8);
+	if(composition_offsets_.size() <= index) {
+		composition_offsets_.resize(index + 1, 0);
+	}
+	composition_offsets_[index] = data_.size();
+}
+
+bool CompiledWriter::save(const std::filesystem::path &filepath) const
+{
+	compiled::Header header;
+	std::memcpy(header.magic, compiled::MAGIC, sizeof(header.magic));
+	header.version = compiled::VERSION;
+	header.composition_count = static_cast<uint32_t>(composition_offsets_.size());
+	header.string_count = static_cast<uint32_t>(strings_.size());
+
+	std::vector<uint32_t> string_offsets;
+	string_offsets.reserve(strings_.size() + 1);
+	std::string string_chars;
+	for(const auto &s : strings_) {
+		string_offsets.push_back(static_cast<uint32_t>(string_chars.size()));
+		string_chars += s;
+	}
+	string_offsets.push_back(static_cast<uint32_t>(string_chars.size()));
+
+	header.data_offset = alignedSize(sizeof(header), 8);
+	header.data_size = data_.size();
+	header.composition_table_offset = alignedSize(header.data_offset + header.data_size, 8);
+	header.string_table_offset = alignedSize(header.composition_table_offset + composition_offsets_.size() * sizeof(uint64_t), 8);
+	header.string_table_size = string_offsets.size() * sizeof(uint32_t) + string_chars.size();
+	header.vertex_pool_offset = alignedSize(header.string_table_offset + header.string_table_size, 8);
+	header.vertex_count = vertices_.size();
+
+	std::ofstream ofs(filepath, std::ios::binary | std::ios::trunc);
+	if(!ofs) {
+		ofLogError("CompiledWriter") << "Failed to open file for writing: " << filepath;
+		return false;
+	}
+	auto pad = [&ofs](uint64_t offset) {
+		while(static_cast<uint64_t>(ofs.tellp()) < offset) {
+			ofs.put(0);
+		}
+	};
+	ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	pad(header.data_offset);
+	ofs.write(reinterpret_cast<const char*>(data_.data()), data_.size());
+	pad(header.composition_table_offset);
+	ofs.write(reinterpret_cast<const char*>(composition_offsets_.data()), composition_offsets_.size() * sizeof(uint64_t));
+	pad(header.string_table_offset);
+	ofs.write(reinterpret_cast<const char*>(string_offsets.data()), string_offsets.size() * sizeof(uint32_t));
+	ofs.write(string_chars.data(), string_chars.size());
+	pad(header.vertex_pool_offset);
+	ofs.write(reinterpret_cast<const char*>(vertices_.data()), vertices_.size() * sizeof(glm::vec2));
+	return ofs.good();
+}
+
+bool CompiledArchive::open(const std::filesystem::path &filepath)
+{
+	compositions_.clear();
+	if(!file_.open(filepath)) {
+		ofLogError("CompiledArchive") << "Failed to open file: " << filepath;
+		return false;
+	}
+	if(file_.size() < sizeof(compiled::Header)) {
+		ofLogError("CompiledArchive") << "File too small: " << filepath;
+		return false;
+	}
+	std::memcpy(&header_, file_.data(), sizeof(header_));
+	if(std::memcmp(header_.magic, compiled::MAGIC, sizeof(header_.magic)) != 0) {
+		ofLogError("CompiledArchive") << "Not a compiled composition: " << filepath;
+		return false;
+	}
+	if(header_.version != compiled::VERSION) {
+		ofLogError("CompiledArchive") << "Unsupported version " << header_.version << " (expected " << compiled::VERSION << "): " << filepath;
+		return false;
+	}
+	auto inRange = [this](uint64_t offset, uint64_t size) {
+		return offset <= file_.size() && size <= file_.size() - offset;
+	};
+	if(!inRange(header_.data_offset, header_.data_size)
+	   || !inRange(header_.composition_table_offset, header_.composition_count * sizeof(uint64_t))
+	   || !inRange(header_.string_table_offset, header_.string_table_size)
+	   || !inRange(header_.vertex_pool_offset, header_.vertex_count * sizeof(glm::vec2))
+	   || header_.string_table_size < (static_cast<uint64_t>(header_.string_count) + 1) * sizeof(uint32_t)) {
+		ofLogError("CompiledArchive") << "Corrupted section table: " << filepath;
+		return false;
+	}
+	// getString() trusts the offsets, so check once that they are sorted and inside the table
+	{
+		const uint32_t *offsets = reinterpret_cast<const uint32_t*>(file_.data() + header_.string_table_offset);
+		uint64_t chars_size = header_.string_table_size - (static_cast<uint64_t>(header_.string_count) + 1) * sizeof(uint32_t);
+		uint32_t previous = 0;
+		for(uint64_t i = 0; i <= header_.string_count; ++i) {
+			if(offsets[i] < previous || offsets[i] > chars_size) {
+				ofLogError("CompiledArchive") << "Corrupted string table: " << filepath;
+				return false;
+			}
+			previous = offsets[i];
+		}
+	}
+	base_dir_ = filepath.parent_path();
+	data_ = file_.data() + header_.data_offset;
+	data_size_ = header_.data_size;
+	composition_offsets_ = reinterpret_cast<const uint64_t*>(file_.data() + header_.composition_table_offset);
+	string_offsets_ = reinterpret_cast<const uint32_t*>(file_.data() + header_.string_table_offset);
+	string_chars_ = reinterpret_cast<const char*>(string_offsets_ + header_.string_count + 1);
+	vertices_ = reinterpret_cast<const glm::vec2*>(file_.data() + header_.vertex_pool_offset);
+	compositions_.resize(header_.composition_count);
+	return true;
+}
+
+std::string_view CompiledArchive::getString(uint32_t index) const
+{
+	if(index >= header_.string_count) {
+		return {};
+	}
+	return std::string_view(string_chars_ + string_offsets_[index], string_offsets_[index+1] - string_offsets_[index]);
+}
+
+const glm::vec2* CompiledArchive::getVertices(uint32_t offset, uint32_t count) const
+{
+	if(static_cast<uint64_t>(offset) + count > header_.vertex_count) {
+		return nullptr;
+	}
+	return vertices_ + offset;
+}
+
+bool CompiledArchive::getCompositionOffset(uint32_t index, size_t &offset) const
+{
+	if(index >= header_.composition_count || composition_offsets_[index] >= data_size_) {
+		return false;
+	}
+	offset = composition_offsets_[index];
+	return true;
+}
+
+std::shared_ptr<Composition> CompiledArchive::getComposition(uint32_t index)
+{
+	if(index >= compositions_.size()) {
+		return nullptr;
+	}
+	if(compositions_[index]) {
+		return compositions_[index];
+	}
+	size_t offset;
+	if(!getCompositionOffset(index, offset)) {
+		return nullptr;
+	}
+	auto comp = std::make_shared<Composition>();
+	CompiledReader reader(*this, offset);
+	if(!comp->read(reader)) {
+		ofLogError("CompiledArchive") << "Failed to read composition #" << index;
+		return nullptr;
+	}
+	compositions_[index] = comp;
+	return comp;
+}
+
+CompiledReader::CompiledReader(CompiledArchive &archive, size_t offset)
+: archive_(archive)
+, position_(offset)
+{
+}
+
+bool CompiledReader::consume(void *dst, size_t size)
+{
+	const uint8_t *src = archive_.getData() + position_;
+	if(!skip(size)) return false;
+	std::memcpy(dst, src, size);
+	return true;
+}
+
+bool CompiledReader::skip(size_t size)
+{
+	if(!valid_ || size > archive_.getDataSize() - position_) {
+		valid_ = false;
+		return false;
+	}
+	position_ += size;
+	return true;
+}
+
+void CompiledReader::align(size_t alignment)
+{
+	size_t aligned = alignedSize(position_, alignment);
+	skip(aligned - position_);
+}
+
+bool CompiledReader::read(std::string &str)
+{
+	uint32_t index;
+	if(!read(index)) return false;
+	if(index >= archive_.getStringCount()) {
+		valid_ = false;
+		return false;
+	}
+	str = std::string(archive_.getString(index));
+	return true;
+}
+
+bool CompiledReader::read(ofFloatColor &color)
+{
+	return read(color.r) && read(color.g) && read(color.b) && read(color.a);
+}
+
+bool CompiledReader::read(PathData &path)
+{
+	auto readPool = [this](std::vector<glm::vec2> &dst) {
+		uint32_t offset, count;
+		if(!read(offset) || !read(count)) return false;
+		const glm::vec2 *src = archive_.getVertices(offset, count);
+		if(!src) {
+			valid_ = false;
+			return false;
+		}
+		dst.assign(src, src + count);
+		return true;
+	};
+	uint8_t closed, visible;
+	if(!readPool(path.vertices) || !readPool(path.inTangents) || !readPool(path.outTangents)
+	   || !read(closed) || !read(path.direction) || !read(visible)) {
+		return false;
+	}
+	path.closed = closed != 0;
+	path.visible = visible != 0;
+	return true;
+}
+
+bool CompiledReader::readPath(std::filesystem::path &path)
+{
+	std::string str;
+	if(!read(str)) return false;
+	path = std::filesystem::path(str);
+	if(path.is_relative()) {
+		path = archive_.getBaseDir() / path;
+	}
+	return true;
+}
+
+bool CompiledReader::beginBlock(size_t &end)
+{
+	uint32_t size;
+	if(!read(size)) return false;
+	end = position_ + size;
+	if(end > archive_.getDataSize()) {
+		valid_ = false;
+		return false;
+	}
+	return true;
+}
+
+void CompiledReader::endBlock(size_t end)
+{
+	if(valid_ && end >= position_) {
+		position_ = end;
+	}
+	else {
+		valid_ = false;
+	}
+}
+
+}} // namespace ofx::ae
@@ -0,0 +1,234 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "ofColor.h"
+#include "../data/PathData.h"
+
+namespace ofx { namespace ae {
+
+class Composition;
+
+// Binary layout of a compiled composition (.aec).
+// All sections are little-endian and 8-byte aligned. Strings are viewed in place in the memory mapping;
+// keyframe arrays are copied out of it into each property's track by Property::read().
+namespace compiled {
+constexpr char MAGIC[4] = {'A','E','P','C'};
+constexpr uint32_t VERSION = 4;
+
+struct Header {
+	char magic[4];
+	uint32_t version;
+	uint32_t composition_count;
+	uint32_t string_count;
+	uint64_t data_offset;
+	uint64_t data_size;
+	uint64_t composition_table_offset;
+	uint64_t string_table_offset;
+	uint64_t string_table_size;
+	uint64_t vertex_pool_offset;
+	uint64_t vertex_count;
+};
+}
+
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const std::filesystem::path &filepath);
+	void close();
+
+	const uint8_t* data() const { return data_; }
+	size_t size() const { return size_; }
+	bool isOpen() const { return data_ != nullptr; }
+
+private:
+	const uint8_t *data_ = nullptr;
+	size_t size_ = 0;
+	bool is_mapped_ = false;
+	std::vector<uint8_t> buffer_;
+};
+
+class CompiledWriter
+{
+public:
+	explicit CompiledWriter(const std::filesystem::path &base_dir);
+
+	template<typename T>
+	void write(const T &value) {
+		static_assert(std::is_trivially_copyable<T>::value, "use a dedicated overload for non-trivial types");
+		append(&value, sizeof(T));
+	}
+	void write(const std::string &str);
+	void write(const ofFloatColor &color);
+	void write(const PathData &path);
+	void writePath(const std::filesystem::path &path);
+
+	template<typename T>
+	void writeArray(const T *data, size_t count) {
+		static_assert(std::is_trivially_copyable<T>::value, "arrays must be trivially copyable");
+		write<uint32_t>(static_cast<uint32_t>(count));
+		align(8);
+		append(data, sizeof(T) * count);
+	}
+	template<typename T>
+	void writeArray(const std::vector<T> &values) { writeArray(values.data(), values.size()); }
+
+	template<typename T>
+	void writeValues(const std::vector<T> &values) {
+		if constexpr (std::is_same<T, bool>::value) {
+			std::vector<uint8_t> bytes(begin(values), end(values));
+			writeArray(bytes);
+		}
+		else if constexpr (std::is_trivially_copyable<T>::value) {
+			writeArray(values);
+		}
+		else {
+			write<uint32_t>(static_cast<uint32_t>(values.size()));
+			for(const auto &v : values) {
+				write(v);
+			}
+		}
+	}
+
+	// Blocks are size-prefixed so readers can skip entries they do not know about.
+	size_t beginBlock();
+	void endBlock(size_t block);
+
+	uint32_t requestComposition(const std::filesystem::path &filepath);
+	bool popRequestedComposition(std::filesystem::path &filepath, uint32_t &index);
+	void beginComposition(uint32_t index);
+
+	bool save(const std::filesystem::path &filepath) const;
+
+	size_t getDataSize() const { return data_.size(); }
+	size_t getStringCount() const { return strings_.size(); }
+	size_t getVertexCount() const { return vertices_.size(); }
+	size_t getCompositionCount() const { return composition_offsets_.size(); }
+
+private:
+	void append(const void *src, size_t size);
+	void align(size_t alignment);
+	uint32_t addString(const std::string &str);
+
+	std::filesystem::path base_dir_;
+	std::vector<uint8_t> data_;
+	std::vector<std::string> strings_;
+	std::unordered_map<std::string, uint32_t> string_index_;
+	std::vector<glm::vec2> vertices_;
+	std::vector<uint64_t> composition_offsets_;
+	std::unordered_map<std::string, uint32_t> composition_index_;
+	std::vector<std::pair<std::filesystem::path, uint32_t>> pending_compositions_;
+};
+
+class CompiledArchive
+{
+public:
+	bool open(const std::filesystem::path &filepath);
+
+	const std::filesystem::path& getBaseDir() const { return base_dir_; }
+	uint32_t getStringCount() const { return header_.string_count; }
+	// empty if index is out of range
+	std::string_view getString(uint32_t index) const;
+	const glm::vec2* getVertices(uint32_t offset, uint32_t count) const;
+
+	const uint8_t* getData() const { return data_; }
+	size_t getDataSize() const { return data_size_; }
+
+	uint32_t getCompositionCount() const { return header_.composition_count; }
+	bool getCompositionOffset(uint32_t index, size_t &offset) const;
+	std::shared_ptr<Composition> getComposition(uint32_t index);
+
+private:
+	MappedFile file_;
+	compiled::Header header_;
+	std::filesystem::path base_dir_;
+	const uint8_t *data_ = nullptr;
+	size_t data_size_ = 0;
+	const uint64_t *composition_offsets_ = nullptr;
+	const uint32_t *string_offsets_ = nullptr;
+	const char *string_chars_ = nullptr;
+	const glm::vec2 *vertices_ = nullptr;
+	std::vector<std::shared_ptr<Composition>> compositions_;
+};
+
+class CompiledReader
+{
+public:
+	CompiledReader(CompiledArchive &archive, size_t offset);
+
+	template<typename T>
+	bool read(T &value) {
+		static_assert(std::is_trivially_copyable<T>::value, "use a dedicated overload for non-trivial types");
+		return consume(&value, sizeof(T));
+	}
+	bool read(std::string &str);
+	bool read(ofFloatColor &color);
+	bool read(PathData &path);
+	bool readPath(std::filesystem::path &path);
+
+	// Returns a pointer into the mapped file; valid as long as the archive is alive.
+	template<typename T>
+	const T* readArray(uint32_t &count) {
+		static_assert(std::is_trivially_copyable<T>::value, "arrays must be trivially copyable");
+		count = 0;
+		if(!read(count)) return nullptr;
+		align(8);
+		const T *ret = reinterpret_cast<const T*>(archive_.getData() + position_);
+		if(!skip(sizeof(T) * count)) {
+			count = 0;
+			return nullptr;
+		}
+		return ret;
+	}
+
+	template<typename T>
+	bool readValues(std::vector<T> &values) {
+		uint32_t count = 0;
+		if constexpr (std::is_same<T, bool>::value) {
+			const uint8_t *src = readArray<uint8_t>(count);
+			values.assign(src, src + count);
+		}
+		else if constexpr (std::is_trivially_copyable<T>::value) {
+			const T *src = readArray<T>(count);
+			values.assign(src, src + count);
+		}
+		else {
+			if(!read(count)) return false;
+			values.resize(count);
+			for(auto &v : values) {
+				if(!read(v)) return false;
+			}
+		}
+		return isValid();
+	}
+
+	bool beginBlock(size_t &end);
+	void endBlock(size_t end);
+
+	bool isValid() const { return valid_; }
+	CompiledArchive& getArchive() { return archive_; }
+
+private:
+	bool consume(void *dst, size_t size);
+	bool skip(size_t size);
+	void align(size_t alignment);
+
+	CompiledArchive &archive_;
+	size_t position_;
+	bool valid_ = true;
+};
+
+}} // namespace ofx::ae
@@ -0,0 +1,56 @@
+#include "ofxAEEvaluationStats.h"
+
+#include <atomic>
+
+namespace ofx { namespace ae {
+
+namespace {
+// atomic because layers may be evaluated in parallel (Composition::setParallelEvaluation)
+std::atomic<bool> is_enabled{false};
+std::atomic<size_t> evaluated_count{0};
+std::atomic<size_t> skipped_count{0};
+std::atomic<size_t> matrix_count{0};
+}
+
+void EvaluationStats::setEnabled(bool enabled)
+{
+	is_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool EvaluationStats::isEnabled()
+{
+	return is_enabled.load(std::memory_order_relaxed);
+}
+
+EvaluationStats EvaluationStats::get()
+{
+	EvaluationStats stats;
+	stats.properties_evaluated = evaluated_count.load(std::memory_order_relaxed);
+	stats.properties_skipped = skipped_count.load(std::memory_order_relaxed);
+	stats.matrices_updated = matrix_count.load(std::memory_order_relaxed);
+	return stats;
+}
+
+void EvaluationStats::resetCounters()
+{
+	evaluated_count.store(0, std::memory_order_relaxed);
+	skipped_count.store(0, std::memory_order_relaxed);
+	matrix_count.store(0, std::memory_order_relaxed);
+}
+
+void EvaluationStats::countEvaluated()
+{
+	if(isEnabled()) evaluated_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+void EvaluationStats::countSkipped()
+{
+	if(isEnabled()) skipped_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+void EvaluationStats::countMatrixUpdated()
+{
+	if(isEnabled()) matrix_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+}} // namespace ofx::ae
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+
+namespace ofx { namespace ae {
+
+// Counts the work done by setFrame()/update() across all compositions.
+// Counting is off by default; enable it, call resetCounters() before a frame and get() after it.
+struct EvaluationStats {
+	size_t properties_evaluated = 0;	// Property::setFrame calls that looked up keyframes
+	size_t properties_skipped = 0;		// static properties and property subtrees that were skipped
+	size_t matrices_updated = 0;		// layer world matrices that were recomputed
+
+	void reset() {
+		properties_evaluated = 0;
+		properties_skipped = 0;
+		matrices_updated = 0;
+	}
+
+	static void setEnabled(bool enabled);
+	static bool isEnabled();
+	static EvaluationStats get();
+	static void resetCounters();
+
+	static void countEvaluated();
+	static void countSkipped();
+	static void countMatrixUpdated();
+};
+
+}} // namespace ofx::ae
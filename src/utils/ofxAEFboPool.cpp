@@ -0,0 +1,119 @@
+#include "ofxAEFboPool.h"
+
+#include <algorithm>
+
+namespace ofx { namespace ae {
+
+FboPool& FboPool::getInstance()
+{
+	static FboPool instance;
+	return instance;
+}
+
+FboPool::FboPool()
+: shared_(std::make_shared<Shared>())
+{
+}
+
+uint64_t FboPool::bucketKey(int width, int height)
+{
+	return (static_cast<uint64_t>(roundUp(width)) << 32) | static_cast<uint32_t>(roundUp(height));
+}
+
+size_t FboPool::getBytes(const ofFbo &fbo)
+{
+	return static_cast<size_t>(fbo.getWidth()) * static_cast<size_t>(fbo.getHeight()) * 4;
+}
+
+std::shared_ptr<ofFbo> FboPool::lend(std::unique_ptr<ofFbo> fbo)
+{
+	shared_->stats.in_use++;
+	std::weak_ptr<Shared> weak_shared = shared_;
+	return std::shared_ptr<ofFbo>(fbo.release(), [weak_shared](ofFbo *fbo) {
+		auto shared = weak_shared.lock();
+		if(!shared) {
+			delete fbo;
+			return;
+		}
+		auto &stats = shared->stats;
+		stats.in_use--;
+		stats.idle++;
+		stats.idle_bytes += getBytes(*fbo);
+		shared->idle[bucketKey(fbo->getWidth(), fbo->getHeight())].push_back({std::unique_ptr<ofFbo>(fbo), shared->frame});
+	});
+}
+
+std::shared_ptr<ofFbo> FboPool::acquire(int width, int height)
+{
+	auto &stats = shared_->stats;
+	auto found = shared_->idle.find(bucketKey(width, height));
+	if(found != shared_->idle.end() && !found->second.empty()) {
+		auto fbo = std::move(found->second.back().fbo);
+		found->second.pop_back();
+		stats.reuses++;
+		stats.idle--;
+		stats.idle_bytes -= getBytes(*fbo);
+		return lend(std::move(fbo));
+	}
+	auto fbo = std::make_unique<ofFbo>();
+	fbo->allocate(roundUp(width), roundUp(height), GL_RGBA);
+	stats.allocations++;
+	return lend(std::move(fbo));
+}
+
+void FboPool::fit(std::shared_ptr<ofFbo> &fbo, int width, int height)
+{
+	if(fbo && bucketKey(fbo->getWidth(), fbo->getHeight()) == bucketKey(width, height)) {
+		shared_->stats.reuses++;
+		return;
+	}
+	// give the old one back first, it may be what the new size needs
+	fbo.reset();
+	fbo = acquire(width, height);
+}
+
+void FboPool::update()
+{
+	auto &stats = shared_->stats;
+	frame_stats_ = stats;
+	frame_stats_.allocations -= frame_start_.allocations;
+	frame_stats_.reuses -= frame_start_.reuses;
+	frame_stats_.frees -= frame_start_.frees;
+	frame_start_ = stats;
+
+	shared_->frame++;
+	for(auto &&[key, idle] : shared_->idle) {
+		auto expired = std::partition(begin(idle), end(idle), [&](const Idle &i) {
+			return shared_->frame - i.since <= static_cast<uint64_t>(max_idle_frames_);
+		});
+		for(auto it = expired; it != end(idle); ++it) {
+			stats.idle--;
+			stats.idle_bytes -= getBytes(*it->fbo);
+			stats.frees++;
+		}
+		idle.erase(expired, end(idle));
+	}
+}
+
+void FboPool::clear()
+{
+	auto &stats = shared_->stats;
+	stats.frees += stats.idle;
+	stats.idle = 0;
+	stats.idle_bytes = 0;
+	shared_->idle.clear();
+}
+
+FboPool::Stats FboPool::getStats() const
+{
+	return shared_->stats;
+}
+
+void FboPool::resetStats()
+{
+	shared_->stats.reset();
+	frame_start_.reset();
+	frame_stats_.reset();
+}
+
+}} // namespace ofx::ae
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "ofMain.h"
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace ofx { namespace ae {
+
+// Hands out RGBA FBOs for layer, mask and matte render targets and takes them back for reuse,
+// instead of allocating new GL objects whenever a target is needed or changes size.
+// Sizes are rounded up to multiples of BUCKET_SIZE pixels, so a target that grows or shrinks
+// a little keeps its FBO, and targets of similar sizes share FBOs. Only the top-left
+// width x height of a returned FBO holds the content; draw it with drawSubsection() if the size matters.
+// FBOs that stay unused in the pool for getMaxIdleFrames() calls of update() are freed.
+// Not thread-safe; main thread only.
+class FboPool
+{
+public:
+	static constexpr int BUCKET_SIZE = 64;
+
+	struct Stats {
+		size_t allocations = 0;	// FBOs allocated
+		size_t reuses = 0;		// requests served without allocating
+		size_t frees = 0;		// idle FBOs freed
+		size_t in_use = 0;
+		size_t idle = 0;
+		size_t idle_bytes = 0;
+
+		void reset() {
+			allocations = reuses = frees = 0;
+		}
+	};
+
+	static FboPool& getInstance();
+
+	FboPool(const FboPool&) = delete;
+	FboPool& operator=(const FboPool&) = delete;
+
+	// The FBO goes back to the pool when the last copy of the pointer is released.
+	std::shared_ptr<ofFbo> acquire(int width, int height);
+	// Makes fbo hold a pooled FBO of at least width x height. Keeps the one it holds if that is
+	// in the right bucket already; otherwise it is returned to the pool and another one is acquired.
+	void fit(std::shared_ptr<ofFbo> &fbo, int width, int height);
+
+	// Call once per frame. Closes the per-frame stats and frees FBOs that have been idle too long.
+	void update();
+	void setMaxIdleFrames(int frames) { max_idle_frames_ = frames; }
+	int getMaxIdleFrames() const { return max_idle_frames_; }
+	// Frees all idle FBOs. FBOs in use are not affected.
+	void clear();
+
+	// Totals since the last resetStats().
+	Stats getStats() const;
+	// Allocations and reuses during the last frame, i.e. between the last two update() calls.
+	const Stats& getFrameStats() const { return frame_stats_; }
+	void resetStats();
+
+	static int roundUp(int size) { return (std::max(size, 1) + BUCKET_SIZE - 1) / BUCKET_SIZE * BUCKET_SIZE; }
+
+private:
+	FboPool();
+
+	struct Idle {
+		std::unique_ptr<ofFbo> fbo;
+		uint64_t since = 0;
+	};
+	// shared with the deleters of FBOs in use, which may outlive the pool at exit
+	struct Shared {
+		std::unordered_map<uint64_t, std::vector<Idle>> idle;
+		uint64_t frame = 0;
+		Stats stats;
+	};
+
+	static uint64_t bucketKey(int width, int height);
+	static size_t getBytes(const ofFbo &fbo);
+	std::shared_ptr<ofFbo> lend(std::unique_ptr<ofFbo> fbo);
+
+	std::shared_ptr<Shared> shared_;
+	Stats frame_stats_;
+	Stats frame_start_;
+	int max_idle_frames_ = 60;
+};
+
+}} // namespace ofx::ae
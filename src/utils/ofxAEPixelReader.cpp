@@ -0,0 +1,137 @@
+#include "ofxAEPixelReader.h"
+
+namespace ofx { namespace ae {
+
+namespace {
+GLenum getGlFormat(ofPixelFormat format)
+{
+	switch(format) {
+		case OF_PIXELS_RGB: return GL_RGB;
+		case OF_PIXELS_BGRA: return GL_BGRA;
+		default: return GL_RGBA;
+	}
+}
+}
+
+PixelReader::~PixelReader()
+{
+	clear();
+}
+
+bool PixelReader::isFormatSupported(ofPixelFormat format)
+{
+	return format == OF_PIXELS_RGBA || format == OF_PIXELS_RGB || format == OF_PIXELS_BGRA;
+}
+
+bool PixelReader::isFinished(const Slot &slot) const
+{
+	GLenum result = glClientWaitSync(slot.fence, 0, 0);
+	return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+}
+
+void PixelReader::release(Slot &slot)
+{
+	if(slot.fence) {
+		glDeleteSync(slot.fence);
+		slot.fence = nullptr;
+	}
+}
+
+void PixelReader::copy(Slot &slot)
+{
+	pixels_.allocate(width_, height_, format_);
+	slot.buffer.bind(GL_PIXEL_PACK_BUFFER);
+	if(auto data = slot.buffer.map<unsigned char>(GL_READ_ONLY)) {
+		memcpy(pixels_.getData(), data, pixels_.size());
+		slot.buffer.unmap();
+	}
+	slot.buffer.unbind(GL_PIXEL_PACK_BUFFER);
+	release(slot);
+
+	stats_.completed++;
+	stats_.latency_millis = std::chrono::duration<double, std::milli>(Clock::now() - slot.started).count();
+	pixels_sequence_ = slot.sequence;
+}
+
+void PixelReader::collect()
+{
+	// fences signal in order, so everything older than the newest finished slot is finished too
+	Slot *newest = nullptr;
+	for(auto &slot : ring_) {
+		if(slot.fence && (!newest || slot.sequence > newest->sequence) && isFinished(slot)) {
+			newest = &slot;
+		}
+	}
+	if(!newest) {
+		return;
+	}
+	for(auto &slot : ring_) {
+		if(slot.fence && slot.sequence < newest->sequence) {
+			release(slot);
+			stats_.skipped++;
+		}
+	}
+	copy(*newest);
+}
+
+void PixelReader::readback(const ofFbo &fbo, ofPixelFormat format)
+{
+	if(!isFormatSupported(format)) {
+		ofLogWarning("PixelReader") << "Unsupported pixel format: " << format;
+		return;
+	}
+	int width = fbo.getWidth();
+	int height = fbo.getHeight();
+	if(width <= 0 || height <= 0) {
+		return;
+	}
+	if(width != width_ || height != height_ || format != format_) {
+		clear();
+		width_ = width;
+		height_ = height;
+		format_ = format;
+	}
+
+	collect();
+
+	auto &slot = ring_[next_];
+	if(slot.fence) {
+		// every buffer is still in flight; wait for the oldest one, which is this one
+		glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+		stats_.stalls++;
+		copy(slot);
+	}
+	size_t bytes = ofPixels::bytesFromPixelFormat(width_, height_, format_);
+	if(!slot.buffer.isAllocated() || slot.buffer.size() != bytes) {
+		slot.buffer.allocate(bytes, GL_STREAM_READ);
+	}
+
+	GLint read_framebuffer = 0;
+	glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &read_framebuffer);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo.getId());
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	slot.buffer.bind(GL_PIXEL_PACK_BUFFER);
+	glReadPixels(0, 0, width_, height_, getGlFormat(format_), GL_UNSIGNED_BYTE, nullptr);
+	slot.buffer.unbind(GL_PIXEL_PACK_BUFFER);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, read_framebuffer);
+
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot.sequence = ++sequence_;
+	slot.started = Clock::now();
+	stats_.started++;
+	stats_.frames_behind = sequence_ - pixels_sequence_;
+	next_ = (next_ + 1) % RING_SIZE;
+}
+
+void PixelReader::clear()
+{
+	for(auto &slot : ring_) {
+		release(slot);
+		slot.buffer = ofBufferObject();
+	}
+	next_ = 0;
+}
+
+}} // namespace ofx::ae
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "ofMain.h"
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+namespace ofx { namespace ae {
+
+// Reads the pixels of an FBO back to the CPU without stalling the GPU.
+// Each readback() starts copying the FBO into the next pixel-pack buffer of a ring and hands out
+// the newest copy that the GPU has already finished, typically the one started two frames earlier.
+// The CPU only waits when every buffer of the ring is still in flight.
+// Supports OF_PIXELS_RGBA, OF_PIXELS_RGB and OF_PIXELS_BGRA. Main thread only.
+class PixelReader
+{
+public:
+	static constexpr size_t RING_SIZE = 3;
+
+	struct Stats {
+		size_t started = 0;			// readbacks started
+		size_t completed = 0;		// readbacks copied into getPixels()
+		size_t skipped = 0;			// finished readbacks dropped because a newer one was finished as well
+		size_t stalls = 0;			// readbacks the CPU had to wait for because the ring was full
+		size_t frames_behind = 0;	// readback() calls since the one whose pixels getPixels() holds
+		double latency_millis = 0;	// from starting the readback in getPixels() to copying it
+
+		void reset() {
+			started = completed = skipped = stalls = 0;
+		}
+	};
+
+	PixelReader() = default;
+	~PixelReader();
+	PixelReader(const PixelReader&) = delete;
+	PixelReader& operator=(const PixelReader&) = delete;
+
+	// Call once per frame after drawing into fbo.
+	void readback(const ofFbo &fbo, ofPixelFormat format);
+	// Frees the buffers and drops readbacks in flight. getPixels() keeps the last pixels.
+	void clear();
+
+	// Empty until the first readback has finished.
+	ofPixels& getPixels() { return pixels_; }
+	const ofPixels& getPixels() const { return pixels_; }
+
+	const Stats& getStats() const { return stats_; }
+	void resetStats() { stats_.reset(); }
+
+	static bool isFormatSupported(ofPixelFormat format);
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	struct Slot {
+		ofBufferObject buffer;
+		GLsync fence = nullptr;
+		uint64_t sequence = 0;
+		Clock::time_point started;
+	};
+
+	bool isFinished(const Slot &slot) const;
+	void release(Slot &slot);
+	void copy(Slot &slot);
+	void collect();
+
+	std::array<Slot, RING_SIZE> ring_;
+	size_t next_ = 0;
+	uint64_t sequence_ = 0;
+	uint64_t pixels_sequence_ = 0;
+	int width_ = 0;
+	int height_ = 0;
+	ofPixelFormat format_ = OF_PIXELS_RGBA;
+	ofPixels pixels_;
+	Stats stats_;
+};
+
+}} // namespace ofx::ae
@@ -0,0 +1,135 @@
+#include "ofxAEPrecompCache.h"
+
+#include "../core/ofxAEComposition.h"
+#include "../core/ofxAERenderContext.h"
+#include <functional>
+
+namespace ofx { namespace ae {
+
+PrecompCache& PrecompCache::getInstance()
+{
+	static PrecompCache instance;
+	return instance;
+}
+
+size_t PrecompCache::KeyHash::operator()(const Key &key) const
+{
+	size_t h = std::hash<const void*>()(key.comp);
+	auto combine = [&h](size_t value) {
+		h ^= value + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+	};
+	combine(std::hash<float>()(key.frame));
+	combine(std::hash<int>()(key.width));
+	combine(std::hash<int>()(key.height));
+	return h;
+}
+
+void PrecompCache::setBudget(size_t bytes)
+{
+	budget_ = bytes;
+	if(budget_ == 0) {
+		clear();
+	}
+	else {
+		trim(0);
+	}
+}
+
+const ofTexture* PrecompCache::get(const Composition &comp, Frame frame, int width, int height)
+{
+	if(budget_ == 0 || width <= 0 || height <= 0) {
+		return nullptr;
+	}
+	Key key{&comp, frame, width, height};
+	auto it = entries_.find(key);
+	if(it != entries_.end()) {
+		stats_.hits++;
+		it->second.last_use = ++clock_;
+		return &it->second.fbo->getTexture();
+	}
+
+	stats_.misses++;
+	size_t bytes = static_cast<size_t>(width) * height * 4;
+	if(bytes > budget_) {
+		return nullptr;
+	}
+	trim(bytes);
+
+	Entry entry;
+	entry.fbo = std::make_unique<ofFbo>();
+	entry.fbo->allocate(width, height, GL_RGBA);
+	entry.bytes = bytes;
+	entry.last_use = ++clock_;
+
+	// render the precomp as it would be at the top level, not with the style of whoever draws it
+	RenderContext::push();
+	RenderContext::setColorRGB(ofFloatColor(1,1,1));
+	RenderContext::setOpacity(1);
+	RenderContext::setBlendMode(BlendMode::NORMAL);
+	entry.fbo->begin();
+	ofPushStyle();
+	ofClear(0, 0, 0, 0);
+	ofSetColor(255, 255, 255, 255);
+	ofEnableBlendMode(OF_BLENDMODE_ALPHA);
+	comp.draw(0, 0, width, height);
+	ofPopStyle();
+	entry.fbo->end();
+	RenderContext::pop();
+
+	stats_.resident_bytes += bytes;
+	stats_.cached_items++;
+	auto &inserted = entries_[key] = std::move(entry);
+	return &inserted.fbo->getTexture();
+}
+
+void PrecompCache::trim(size_t bytes_needed)
+{
+	while(!entries_.empty() && stats_.resident_bytes + bytes_needed > budget_) {
+		auto victim = entries_.begin();
+		for(auto it = entries_.begin(); it != entries_.end(); ++it) {
+			if(it->second.last_use < victim->second.last_use) {
+				victim = it;
+			}
+		}
+		erase(victim);
+		stats_.evictions++;
+	}
+}
+
+void PrecompCache::erase(std::unordered_map<Key, Entry, KeyHash>::iterator it)
+{
+	stats_.resident_bytes -= it->second.bytes;
+	stats_.cached_items--;
+	entries_.erase(it);
+}
+
+void PrecompCache::invalidate(const Composition &comp)
+{
+	auto it = entries_.begin();
+	while(it != entries_.end()) {
+		if(it->first.comp == &comp) {
+			auto next = std::next(it);
+			erase(it);
+			it = next;
+		}
+		else {
+			++it;
+		}
+	}
+}
+
+void PrecompCache::clear()
+{
+	entries_.clear();
+	stats_.cached_items = 0;
+	stats_.resident_bytes = 0;
+}
+
+void PrecompCache::resetStats()
+{
+	stats_.hits = 0;
+	stats_.misses = 0;
+	stats_.evictions = 0;
+}
+
+}} // namespace ofx::ae
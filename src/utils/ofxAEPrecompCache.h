@@ -0,0 +1,76 @@
+#pragma once
+
+#include "ofxAEAssetCache.h"
+#include "ofxAETimeUtils.h"
+#include "ofMain.h"
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+namespace ofx { namespace ae {
+
+class Composition;
+
+// Keeps rendered frames of nested compositions in FBOs, so a precomp that shows the same
+// nested frame again (static precomps, hold keyframes, time remap freezes, loops) is drawn
+// as one texture instead of rendering all of its layers.
+// Entries are keyed by composition instance, nested frame and size in pixels. CompositionSource
+// asks for the size the precomp covers when drawn, so layers scaled above 100% are not upscaled
+// from a smaller texture. It also drops the entries of its composition when the nested content
+// changes without a frame change (see LayerSource::consumeContentChange()).
+// Disabled until a budget is set. Once the budget is exceeded, the least recently drawn entries are evicted.
+// Not thread-safe; main thread only.
+class PrecompCache
+{
+public:
+	static PrecompCache& getInstance();
+
+	PrecompCache(const PrecompCache&) = delete;
+	PrecompCache& operator=(const PrecompCache&) = delete;
+
+	// 0 disables the cache and releases everything in it.
+	void setBudget(size_t bytes);
+	size_t getBudget() const { return budget_; }
+	bool isEnabled() const { return budget_ > 0; }
+
+	// The rendered frame, rendering it on a miss. nullptr if the cache is disabled
+	// or a single frame of this size would not fit in the budget.
+	const ofTexture* get(const Composition &comp, Frame frame, int width, int height);
+
+	// Drops every entry of comp. Call it after changing a nested composition by hand.
+	void invalidate(const Composition &comp);
+	void clear();
+
+	const CacheStats& getStats() const { return stats_; }
+	void resetStats();
+
+private:
+	PrecompCache() = default;
+
+	struct Key {
+		const Composition *comp;
+		Frame frame;
+		int width, height;
+		bool operator==(const Key &other) const {
+			return comp == other.comp && frame == other.frame && width == other.width && height == other.height;
+		}
+	};
+	struct KeyHash {
+		size_t operator()(const Key &key) const;
+	};
+	struct Entry {
+		std::unique_ptr<ofFbo> fbo;
+		size_t bytes = 0;
+		uint64_t last_use = 0;
+	};
+
+	void trim(size_t bytes_needed);
+	void erase(std::unordered_map<Key, Entry, KeyHash>::iterator it);
+
+	std::unordered_map<Key, Entry, KeyHash> entries_;
+	size_t budget_ = 0;
+	uint64_t clock_ = 0;
+	CacheStats stats_;
+};
+
+}} // namespace ofx::ae
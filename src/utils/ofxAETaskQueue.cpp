@@ -0,0 +1,67 @@
+#include "ofxAETaskQueue.h"
+
+#include <algorithm>
+
+namespace ofx { namespace ae {
+
+TaskQueue::TaskQueue(size_t thread_count)
+{
+	if(thread_count == 0) {
+		thread_count = std::max(1u, std::thread::hardware_concurrency() / 2);
+	}
+	threads_.reserve(thread_count);
+	for(size_t i = 0; i < thread_count; ++i) {
+		threads_.emplace_back(&TaskQueue::workerLoop, this);
+	}
+}
+
+TaskQueue::~TaskQueue()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+		jobs_.clear();
+	}
+	wake_.notify_all();
+	for(auto &thread : threads_) {
+		thread.join();
+	}
+}
+
+TaskQueue& TaskQueue::getShared()
+{
+	static TaskQueue queue;
+	return queue;
+}
+
+void TaskQueue::push(std::function<void()> job)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		jobs_.push_back(std::move(job));
+	}
+	wake_.notify_one();
+}
+
+size_t TaskQueue::getPendingCount() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return jobs_.size();
+}
+
+void TaskQueue::workerLoop()
+{
+	while(true) {
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			wake_.wait(lock, [this]() { return stop_ || !jobs_.empty(); });
+			if(stop_) return;
+			job = std::move(jobs_.front());
+			jobs_.pop_front();
+		}
+		job();
+	}
+}
+
+}} // namespace ofx::ae
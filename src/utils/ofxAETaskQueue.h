@@ -0,0 +1,40 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ofx { namespace ae {
+
+// Background worker threads for fire-and-forget jobs such as decoding images.
+// Unlike ThreadPool, push() returns immediately; jobs run in FIFO order.
+// Jobs must not touch GL; hand results back to the main thread yourself.
+class TaskQueue
+{
+public:
+	// thread_count 0 uses half the hardware concurrency, at least one thread.
+	explicit TaskQueue(size_t thread_count = 0);
+	~TaskQueue();
+	TaskQueue(const TaskQueue&) = delete;
+	TaskQueue& operator=(const TaskQueue&) = delete;
+
+	void push(std::function<void()> job);
+	size_t getPendingCount() const;
+	size_t getThreadCount() const { return threads_.size(); }
+
+	static TaskQueue& getShared();
+
+private:
+	void workerLoop();
+
+	std::vector<std::thread> threads_;
+	mutable std::mutex mutex_;
+	std::condition_variable wake_;
+	std::deque<std::function<void()>> jobs_;
+	bool stop_ = false;
+};
+
+}} // namespace ofx::ae
@@ -0,0 +1,174 @@
+#include "ofxAETessellationCache.h"
+
+#include <algorithm>
+
+namespace ofx { namespace ae {
+
+namespace {
+constexpr uint64_t FNV_OFFSET = 14695981039346656037ULL;
+constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+
+void hashBytes(uint64_t &h, const void *data, size_t size)
+{
+	auto bytes = static_cast<const uint8_t*>(data);
+	for(size_t i = 0; i < size; ++i) {
+		h ^= bytes[i];
+		h *= FNV_PRIME;
+	}
+}
+
+template<typename T>
+void hashValue(uint64_t &h, const T &value)
+{
+	hashBytes(h, &value, sizeof(T));
+}
+
+void hashFloat(uint64_t &h, float value)
+{
+	// -0 and 0 tessellate the same
+	if(value == 0) value = 0;
+	hashValue(h, value);
+}
+
+void hashPoint(uint64_t &h, const glm::vec3 &p)
+{
+	hashFloat(h, p.x);
+	hashFloat(h, p.y);
+	hashFloat(h, p.z);
+}
+
+std::shared_ptr<TessellatedPath> tessellate(const ofPath &path)
+{
+	auto ret = std::make_shared<TessellatedPath>();
+	if(path.isFilled()) {
+		ret->fill = ofVboMesh(path.getTessellation());
+	}
+	if(path.hasOutline()) {
+		const auto &outlines = path.getOutline();
+		ret->outlines.reserve(outlines.size());
+		for(const auto &polyline : outlines) {
+			ofVboMesh mesh;
+			mesh.setMode(polyline.isClosed() ? OF_PRIMITIVE_LINE_LOOP : OF_PRIMITIVE_LINE_STRIP);
+			mesh.addVertices(polyline.getVertices());
+			ret->outlines.push_back(std::move(mesh));
+		}
+	}
+	ret->commands = path.getCommands();
+	ret->mode = path.getMode();
+	ret->winding_mode = path.getWindingMode();
+	ret->filled = path.isFilled();
+	ret->has_outline = path.hasOutline();
+	ret->curve_resolution = path.getCurveResolution();
+	ret->circle_resolution = path.getCircleResolution();
+	return ret;
+}
+
+// Same fields as hash(); float == also treats -0 and 0 as equal.
+bool isSameCommand(const ofPath::Command &a, const ofPath::Command &b)
+{
+	return a.type == b.type
+		&& a.to == b.to
+		&& a.cp1 == b.cp1
+		&& a.cp2 == b.cp2
+		&& a.radiusX == b.radiusX
+		&& a.radiusY == b.radiusY
+		&& a.angleBegin == b.angleBegin
+		&& a.angleEnd == b.angleEnd;
+}
+}
+
+TessellationCache& TessellationCache::getInstance()
+{
+	static TessellationCache instance;
+	return instance;
+}
+
+uint64_t TessellationCache::hash(const ofPath &path)
+{
+	uint64_t h = FNV_OFFSET;
+	hashValue(h, static_cast<int>(path.getMode()));
+	hashValue(h, static_cast<int>(path.getWindingMode()));
+	hashValue(h, path.isFilled());
+	hashValue(h, path.hasOutline());
+	hashValue(h, path.getCurveResolution());
+	hashValue(h, path.getCircleResolution());
+	for(const auto &command : path.getCommands()) {
+		hashValue(h, static_cast<int>(command.type));
+		hashPoint(h, command.to);
+		hashPoint(h, command.cp1);
+		hashPoint(h, command.cp2);
+		hashFloat(h, command.radiusX);
+		hashFloat(h, command.radiusY);
+		hashFloat(h, command.angleBegin);
+		hashFloat(h, command.angleEnd);
+	}
+	return h;
+}
+
+bool TessellationCache::isSame(const TessellatedPath &tessellation, const ofPath &path)
+{
+	const auto &commands = path.getCommands();
+	return tessellation.mode == path.getMode()
+		&& tessellation.winding_mode == path.getWindingMode()
+		&& tessellation.filled == path.isFilled()
+		&& tessellation.has_outline == path.hasOutline()
+		&& tessellation.curve_resolution == path.getCurveResolution()
+		&& tessellation.circle_resolution == path.getCircleResolution()
+		&& std::equal(commands.begin(), commands.end(),
+					  tessellation.commands.begin(), tessellation.commands.end(), isSameCommand);
+}
+
+std::shared_ptr<const TessellatedPath> TessellationCache::get(const ofPath &path)
+{
+	uint64_t key = hash(path);
+	auto it = cache_.find(key);
+	if(it != cache_.end()) {
+		auto tessellation = it->second.lock();
+		if(tessellation && isSame(*tessellation, path)) {
+			stats_.hits++;
+			return tessellation;
+		}
+	}
+
+	stats_.misses++;
+
+	// animated shapes leave an expired entry behind every frame
+	if(cache_.size() >= cleanup_threshold_) {
+		cleanup();
+		cleanup_threshold_ = std::max<size_t>(256, cache_.size() * 2);
+	}
+
+	// on a collision the other geometry stays with the items using it, but is no longer shared
+	auto tessellation = tessellate(path);
+	cache_[key] = tessellation;
+	stats_.cached_items = cache_.size();
+	return tessellation;
+}
+
+void TessellationCache::cleanup()
+{
+	auto it = cache_.begin();
+	while(it != cache_.end()) {
+		if(it->second.expired()) {
+			it = cache_.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+	stats_.cached_items = cache_.size();
+}
+
+void TessellationCache::clear()
+{
+	cache_.clear();
+	stats_.cached_items = 0;
+}
+
+void TessellationCache::resetStats()
+{
+	stats_.hits = 0;
+	stats_.misses = 0;
+}
+
+}} // namespace ofx::ae
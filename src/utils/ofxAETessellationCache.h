@@ -0,0 +1,63 @@
+#pragma once
+
+#include "ofxAEAssetCache.h"
+#include "ofMain.h"
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace ofx { namespace ae {
+
+// Triangulated fill and outline polylines of one shape path.
+// Stored in VBOs so static shapes are uploaded once and drawn without tessellating again.
+struct TessellatedPath {
+	ofVboMesh fill;
+	std::vector<ofVboMesh> outlines;
+
+	// What was tessellated. The cache key is only a hash of this, so a hit is compared
+	// against it to tell a hash collision from the same geometry.
+	std::vector<ofPath::Command> commands;
+	ofPath::Mode mode = ofPath::COMMANDS;
+	ofPolyWindingMode winding_mode = OF_POLY_WINDING_ODD;
+	bool filled = false;
+	bool has_outline = false;
+	int curve_resolution = 0;
+	int circle_resolution = 0;
+};
+
+// Shares tessellations between shape render items whose geometry is identical.
+// Keyed on a hash of the path commands and the settings that affect tessellation;
+// colors and stroke width are applied at draw time and are not part of the key.
+// A hit whose geometry differs from the path (a hash collision) is treated as a miss.
+// Entries are weak, so a tessellation lives as long as some render item uses it.
+// Not thread-safe; used from ShapeSource::update() on the main thread.
+class TessellationCache
+{
+public:
+	static TessellationCache& getInstance();
+
+	TessellationCache(const TessellationCache&) = delete;
+	TessellationCache& operator=(const TessellationCache&) = delete;
+
+	std::shared_ptr<const TessellatedPath> get(const ofPath &path);
+
+	void cleanup();
+	void clear();
+
+	const CacheStats& getStats() const { return stats_; }
+	void resetStats();
+
+	static uint64_t hash(const ofPath &path);
+	// Whether tessellation was made from path, as far as tessellation is concerned.
+	static bool isSame(const TessellatedPath &tessellation, const ofPath &path);
+
+private:
+	TessellationCache() = default;
+
+	std::unordered_map<uint64_t, std::weak_ptr<TessellatedPath>> cache_;
+	CacheStats stats_;
+	size_t cleanup_threshold_ = 256;
+};
+
+}} // namespace ofx::ae
@@ -0,0 +1,216 @@
+#include "ofxAETextureAtlas.h"
+
+#include <algorithm>
+#include <sstream>
+
+namespace ofx { namespace ae {
+
+std::shared_ptr<TextureRegion> TextureRegion::fromTexture(std::shared_ptr<ofTexture> texture)
+{
+	if(!texture) return nullptr;
+	auto ret = std::make_shared<TextureRegion>();
+	ret->rect.set(0, 0, texture->getWidth(), texture->getHeight());
+	ret->texture = std::move(texture);
+	return ret;
+}
+
+void TextureAtlas::setup(const Settings &settings)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	settings_ = settings;
+}
+
+bool TextureAtlas::fits(int width, int height) const
+{
+	return width > 0 && height > 0
+	&& width <= settings_.max_region_size && height <= settings_.max_region_size
+	&& width + settings_.padding * 2 <= settings_.page_size
+	&& height + settings_.padding * 2 <= settings_.page_size;
+}
+
+std::shared_ptr<TextureAtlas::Page> TextureAtlas::createPage() const
+{
+	// the texture is allocated with the first upload, on the main thread
+	auto page = std::make_shared<Page>();
+	page->texture = std::make_shared<ofTexture>();
+	return page;
+}
+
+bool TextureAtlas::allocate(Page &page, int page_size, int width, int height, glm::ivec2 &dst)
+{
+	// best fitting shelf that still has room
+	Shelf *best = nullptr;
+	for(auto &shelf : page.shelves) {
+		if(shelf.height >= height && shelf.x + width <= page_size) {
+			if(!best || shelf.height < best->height) {
+				best = &shelf;
+			}
+		}
+	}
+	if(!best) {
+		if(page.next_y + height > page_size) {
+			return false;
+		}
+		page.shelves.push_back({page.next_y, height, 0});
+		page.next_y += height;
+		best = &page.shelves.back();
+	}
+	dst = {best->x, best->y};
+	best->x += width;
+	return true;
+}
+
+std::shared_ptr<TextureRegion> TextureAtlas::add(const ofPixels &pixels, bool defer_upload)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	int width = pixels.getWidth();
+	int height = pixels.getHeight();
+	if(!pixels.isAllocated() || !fits(width, height)) {
+		return nullptr;
+	}
+	const int pad = settings_.padding;
+	const int padded_width = width + pad * 2;
+	const int padded_height = height + pad * 2;
+
+	std::shared_ptr<Page> page;
+	glm::ivec2 pos;
+	for(auto &p : pages_) {
+		if(allocate(*p, settings_.page_size, padded_width, padded_height, pos)) {
+			page = p;
+			break;
+		}
+	}
+	if(!page) {
+		page = createPage();
+		pages_.push_back(page);
+		allocate(*page, settings_.page_size, padded_width, padded_height, pos);
+	}
+	size_t used = static_cast<size_t>(width) * height;
+	page->regions++;
+	page->used_pixels += used;
+	page->allocated_pixels += static_cast<size_t>(padded_width) * padded_height;
+	// the place is taken; the pixel work below does not need the lock
+	lock.unlock();
+
+	ofPixels rgba = pixels;
+	if(rgba.getNumChannels() != 4) {
+		rgba.setImageType(OF_IMAGE_COLOR_ALPHA);
+	}
+	// repeat the edge pixels into the padding, like GL_CLAMP_TO_EDGE on a texture of its own
+	ofPixels padded;
+	padded.allocate(padded_width, padded_height, OF_PIXELS_RGBA);
+	const unsigned char *src = rgba.getData();
+	unsigned char *dst = padded.getData();
+	for(int y = 0; y < padded_height; ++y) {
+		int sy = std::clamp(y - pad, 0, height - 1);
+		for(int x = 0; x < padded_width; ++x) {
+			int sx = std::clamp(x - pad, 0, width - 1);
+			std::copy_n(src + (sy * width + sx) * 4, 4, dst + (y * padded_width + x) * 4);
+		}
+	}
+	if(defer_upload) {
+		lock.lock();
+		pending_uploads_.push_back({page, pos, std::move(padded)});
+		lock.unlock();
+	}
+	else {
+		upload(*page, pos, padded);
+	}
+
+	std::weak_ptr<Page> weak_page = page;
+	auto region = std::shared_ptr<TextureRegion>(new TextureRegion(), [weak_page, used](TextureRegion *r) {
+		if(auto p = weak_page.lock()) {
+			p->regions--;
+			p->used_pixels -= used;
+		}
+		delete r;
+	});
+	region->texture = page->texture;
+	region->rect.set(pos.x + pad, pos.y + pad, width, height);
+	return region;
+}
+
+void TextureAtlas::upload(Page &page, const glm::ivec2 &pos, const ofPixels &pixels) const
+{
+	if(!page.is_texture_allocated) {
+		page.texture->allocate(settings_.page_size, settings_.page_size, GL_RGBA);
+		page.is_texture_allocated = true;
+	}
+	const auto &data = page.texture->getTextureData();
+	glBindTexture(data.textureTarget, data.textureID);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexSubImage2D(data.textureTarget, 0, pos.x, pos.y, pixels.getWidth(), pixels.getHeight(), GL_RGBA, GL_UNSIGNED_BYTE, pixels.getData());
+	glBindTexture(data.textureTarget, 0);
+}
+
+size_t TextureAtlas::flushUploads()
+{
+	std::vector<Upload> uploads;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		uploads.swap(pending_uploads_);
+	}
+	for(auto &&u : uploads) {
+		upload(*u.page, u.pos, u.pixels);
+	}
+	return uploads.size();
+}
+
+size_t TextureAtlas::getPendingUploadCount() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return pending_uploads_.size();
+}
+
+size_t TextureAtlas::getPageCount() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return pages_.size();
+}
+
+void TextureAtlas::cleanup()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	pages_.erase(std::remove_if(begin(pages_), end(pages_), [](const std::shared_ptr<Page> &page) {
+		return page->regions == 0;
+	}), end(pages_));
+}
+
+void TextureAtlas::clear()
+{
+	// regions that are still alive keep their page texture, and pending uploads their page
+	std::lock_guard<std::mutex> lock(mutex_);
+	pages_.clear();
+}
+
+std::vector<TextureAtlas::PageStats> TextureAtlas::getPageStats() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	std::vector<PageStats> ret;
+	ret.reserve(pages_.size());
+	for(auto &&page : pages_) {
+		PageStats stats;
+		stats.width = stats.height = settings_.page_size;
+		stats.regions = page->regions;
+		stats.used_pixels = page->used_pixels;
+		stats.allocated_pixels = page->allocated_pixels;
+		ret.push_back(stats);
+	}
+	return ret;
+}
+
+std::string TextureAtlas::getDebugInfo() const
+{
+	std::ostringstream oss;
+	auto stats = getPageStats();
+	oss << "Texture Atlas: " << stats.size() << " pages\n";
+	for(size_t i = 0; i < stats.size(); ++i) {
+		auto &s = stats[i];
+		oss << "  Page " << i << " (" << s.width << "x" << s.height << "): "
+		<< s.regions << " regions, " << (s.getOccupancy() * 100.0) << "% occupied, "
+		<< (s.allocated_pixels * 100.0 / (static_cast<size_t>(s.width) * s.height)) << "% allocated\n";
+	}
+	return oss.str();
+}
+
+}} // namespace ofx::ae
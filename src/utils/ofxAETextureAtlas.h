@@ -0,0 +1,104 @@
+#pragma once
+
+#include "ofMain.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ofx { namespace ae {
+
+// A whole texture, or a rectangle inside a shared TextureAtlas page.
+// Still and sequence sources draw through this so they work the same with and without the atlas.
+struct TextureRegion {
+	std::shared_ptr<ofTexture> texture;
+	ofRectangle rect;	// in texture pixels
+
+	float getWidth() const { return rect.width; }
+	float getHeight() const { return rect.height; }
+	bool isAllocated() const { return texture && texture->isAllocated(); }
+	void draw(float x, float y, float w, float h) const {
+		texture->drawSubsection(x, y, w, h, rect.x, rect.y, rect.width, rect.height);
+	}
+
+	static std::shared_ptr<TextureRegion> fromTexture(std::shared_ptr<ofTexture> texture);
+};
+
+// Packs small images into shared RGBA pages with shelf packing.
+// Each image gets a border of its own edge pixels so linear filtering does not sample its neighbours.
+// Space is not reused while a page is in use; a page is released by cleanup() once all its regions are gone.
+// add() may be called from any thread with defer_upload set; the pixels are then copied to the page
+// by flushUploads() on the main thread.
+class TextureAtlas
+{
+public:
+	struct Settings {
+		int page_size = 2048;
+		int max_region_size = 256;	// larger images get their own texture
+		int padding = 1;
+	};
+	struct PageStats {
+		int width = 0;
+		int height = 0;
+		size_t regions = 0;
+		size_t used_pixels = 0;		// pixels of live regions, without padding
+		size_t allocated_pixels = 0;	// pixels handed out so far, with padding
+
+		double getOccupancy() const {
+			size_t total = static_cast<size_t>(width) * height;
+			return total > 0 ? static_cast<double>(used_pixels) / total : 0.0;
+		}
+	};
+
+	void setup(const Settings &settings);
+	const Settings& getSettings() const { return settings_; }
+
+	bool fits(int width, int height) const;
+	// Returns nullptr if the image does not fit (see fits()).
+	// With defer_upload, the region has its place but no pixels until flushUploads().
+	std::shared_ptr<TextureRegion> add(const ofPixels &pixels, bool defer_upload = false);
+	// Main thread. Returns the number of regions uploaded.
+	size_t flushUploads();
+	size_t getPendingUploadCount() const;
+
+	void cleanup();
+	void clear();
+
+	size_t getPageCount() const;
+	std::vector<PageStats> getPageStats() const;
+	std::string getDebugInfo() const;
+
+private:
+	struct Shelf {
+		int y;
+		int height;
+		int x;
+	};
+	struct Page {
+		std::shared_ptr<ofTexture> texture;
+		bool is_texture_allocated = false;
+		std::vector<Shelf> shelves;
+		int next_y = 0;
+		// regions may be released on any thread
+		std::atomic<size_t> regions{0};
+		std::atomic<size_t> used_pixels{0};
+		size_t allocated_pixels = 0;
+	};
+	struct Upload {
+		std::shared_ptr<Page> page;
+		glm::ivec2 pos;
+		ofPixels pixels;
+	};
+
+	std::shared_ptr<Page> createPage() const;
+	static bool allocate(Page &page, int page_size, int width, int height, glm::ivec2 &dst);
+	void upload(Page &page, const glm::ivec2 &pos, const ofPixels &pixels) const;
+
+	Settings settings_;
+	std::vector<std::shared_ptr<Page>> pages_;
+	std::vector<Upload> pending_uploads_;
+	mutable std::mutex mutex_;
+};
+
+}} // namespace ofx::ae
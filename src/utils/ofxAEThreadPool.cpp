@@ -0,0 +1,105 @@
+#include "ofxAEThreadPool.h"
+
+namespace ofx { namespace ae {
+
+namespace {
+thread_local bool is_in_parallel_job = false;
+
+struct ParallelJobScope {
+	bool prev;
+	ParallelJobScope() : prev(is_in_parallel_job) { is_in_parallel_job = true; }
+	~ParallelJobScope() { is_in_parallel_job = prev; }
+};
+}
+
+ThreadPool::ThreadPool(size_t thread_count)
+{
+	if(thread_count == 0) {
+		unsigned int hardware = std::thread::hardware_concurrency();
+		thread_count = hardware > 1 ? hardware - 1 : 0;
+	}
+	threads_.reserve(thread_count);
+	for(size_t i = 0; i < thread_count; ++i) {
+		threads_.emplace_back(&ThreadPool::workerLoop, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	wake_.notify_all();
+	for(auto &thread : threads_) {
+		thread.join();
+	}
+}
+
+ThreadPool& ThreadPool::getShared()
+{
+	static ThreadPool pool;
+	return pool;
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)> &fn)
+{
+	if(count == 0) return;
+	if(threads_.empty() || count == 1 || is_in_parallel_job) {
+		for(size_t i = 0; i < count; ++i) {
+			fn(i);
+		}
+		return;
+	}
+
+	std::lock_guard<std::mutex> call_lock(call_mutex_);
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		job_ = &fn;
+		job_count_ = count;
+		next_index_ = 0;
+		busy_workers_ = threads_.size();
+		++generation_;
+	}
+	wake_.notify_all();
+
+	runJob(fn, count);
+
+	std::unique_lock<std::mutex> lock(mutex_);
+	done_.wait(lock, [this]() { return busy_workers_ == 0; });
+	job_ = nullptr;
+}
+
+void ThreadPool::runJob(const std::function<void(size_t)> &fn, size_t count)
+{
+	ParallelJobScope scope;
+	for(size_t i = next_index_++; i < count; i = next_index_++) {
+		fn(i);
+	}
+}
+
+void ThreadPool::workerLoop()
+{
+	uint64_t seen_generation = 0;
+	while(true) {
+		const std::function<void(size_t)> *job;
+		size_t count;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			wake_.wait(lock, [&]() { return stop_ || generation_ != seen_generation; });
+			if(stop_) return;
+			seen_generation = generation_;
+			job = job_;
+			count = job_count_;
+		}
+		runJob(*job, count);
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			if(--busy_workers_ == 0) {
+				done_.notify_one();
+			}
+		}
+	}
+}
+
+}} // namespace ofx::ae
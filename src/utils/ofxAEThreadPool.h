@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ofx { namespace ae {
+
+// Minimal fork-join pool for evaluating independent work items (e.g. layers) in parallel.
+// Items are handed out one at a time from a shared counter, so uneven items balance themselves.
+class ThreadPool
+{
+public:
+	// thread_count 0 uses one worker less than the hardware concurrency (the caller also works).
+	explicit ThreadPool(size_t thread_count = 0);
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// Calls fn(i) for each i in [0, count) and returns when all calls are done.
+	// The calling thread takes part; calls made from inside fn run inline.
+	void parallelFor(size_t count, const std::function<void(size_t)> &fn);
+
+	size_t getThreadCount() const { return threads_.size(); }
+
+	static ThreadPool& getShared();
+
+private:
+	void workerLoop();
+	void runJob(const std::function<void(size_t)> &fn, size_t count);
+
+	std::vector<std::thread> threads_;
+	std::mutex call_mutex_;
+	std::mutex mutex_;
+	std::condition_variable wake_;
+	std::condition_variable done_;
+	const std::function<void(size_t)> *job_ = nullptr;
+	size_t job_count_ = 0;
+	std::atomic<size_t> next_index_{0};
+	size_t busy_workers_ = 0;
+	uint64_t generation_ = 0;
+	bool stop_ = false;
+};
+
+}} // namespace ofx::ae
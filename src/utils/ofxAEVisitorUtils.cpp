@@ -2,6 +2,7 @@
 #include "../core/ofxAELayer.h"
 #include "../prop/ofxAETransformProp.h"
 #include "../data/Enums.h"
+#include "ofxAEFboPool.h"
 
 namespace ofx { namespace ae {
 
@@ -9,8 +10,13 @@ PathExtractionVisitor::PathExtractionVisitor()
 {
 }
 
-PathExtractionVisitor::PathExtractionVisitor(const GroupData &group)
-: PathExtractionVisitor()
+PathExtractionVisitor::PathExtractionVisitor(bool tessellate)
+: is_tessellating_(tessellate)
+{
+}
+
+PathExtractionVisitor::PathExtractionVisitor(const GroupData &group, bool tessellate)
+: PathExtractionVisitor(tessellate)
 {
 	if(!group.visible) return;
 	renderer_.transform = group.transform.toOf();
@@ -73,7 +79,7 @@ void PathExtractionVisitor::visit(const FillData &data) {
 
 	p.setPolyWindingMode(toOf(data.rule));
 
-	auto item = std::make_shared<RenderPathItem>(p);
+	auto item = std::make_shared<RenderPathItem>(p, is_tessellating_);
 	item->blend_mode = data.blendMode;
 	item->bounding_box = bounding_box_;
 
@@ -94,7 +100,7 @@ void PathExtractionVisitor::visit(const StrokeData &data) {
 	p.setStrokeColor(data.color);
 	p.setStrokeWidth(data.width);
 
-	auto item = std::make_shared<RenderPathItem>(p);
+	auto item = std::make_shared<RenderPathItem>(p, is_tessellating_);
 	item->blend_mode = data.blendMode;
 	item->bounding_box = bounding_box_;
 
@@ -109,7 +115,7 @@ void PathExtractionVisitor::visit(const StrokeData &data) {
 
 void PathExtractionVisitor::visit(const GroupData &group) {
 	if(!group.visible) return;
-	PathExtractionVisitor visitor(group);
+	PathExtractionVisitor visitor(group, is_tessellating_);
 	auto item = std::make_shared<RenderGroupItem>(visitor.getRenderer());
 	auto bb = item->getBB();
 	if(!bb.isEmpty()) {
@@ -128,10 +134,18 @@ void PathExtractionVisitor::RenderPathItem::draw(float alpha) const
 	auto mulOpacity = [](const ofFloatColor src, float opacity) {
 		return ofFloatColor{src.r, src.g, src.b, src.a*opacity};
 	};
-	auto p = path;
-	if(p.isFilled()) p.setFillColor(mulOpacity(p.getFillColor(), alpha));
-	if(p.hasOutline()) p.setStrokeColor(mulOpacity(p.getStrokeColor(), alpha));
-	p.draw();
+	// same steps as ofPath::draw(), with the tessellation taken from the cache
+	if(path.isFilled()) {
+		ofSetColor(mulOpacity(path.getFillColor(), alpha));
+		tessellation->fill.draw();
+	}
+	if(path.hasOutline()) {
+		ofSetColor(mulOpacity(path.getStrokeColor(), alpha));
+		ofSetLineWidth(path.getStrokeWidth());
+		for(auto &&outline : tessellation->outlines) {
+			outline.draw();
+		}
+	}
 
 	ofPopStyle();
 }
@@ -146,10 +160,11 @@ bool PathExtractionVisitor::RenderGroupItem::needFbo() const
 void PathExtractionVisitor::RenderGroupItem::draw(float alpha) const
 {
 	auto bb = getBB();
+	std::shared_ptr<ofFbo> fbo;
 	if(needFbo()) {
 		if(bb.isEmpty()) return;
-		fbo.allocate(bb.width, bb.height, GL_RGBA);
-		fbo.begin();
+		fbo = FboPool::getInstance().acquire(bb.width, bb.height);
+		fbo->begin();
 		ofClear(0,0);
 		ofPushMatrix();
 		ofTranslate(-bb.x, -bb.y);
@@ -157,15 +172,17 @@ void PathExtractionVisitor::RenderGroupItem::draw(float alpha) const
 			i->draw(this->opacity*alpha);
 		}
 		ofPopMatrix();
-		fbo.end();
+		fbo->end();
 	}
 	
 	ofPushMatrix();
 	ofPushStyle();
 	ofMultMatrix(transform);
 	applyBlendMode(blend_mode);
-	if(needFbo()) {
-		fbo.draw(bb.x,bb.y);
+	if(fbo) {
+		// the pooled FBO may be larger than bb
+		float w = static_cast<int>(bb.width), h = static_cast<int>(bb.height);
+		fbo->getTexture().drawSubsection(bb.x, bb.y, w, h, 0, 0, w, h);
 	}
 	else {
 		for(auto &&i : item) {
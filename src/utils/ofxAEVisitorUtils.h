@@ -9,6 +9,7 @@
 #include "ofxAEVisitor.h"
 #include "ofxAEShapeUtils.h"
 #include "ofxAEShapeProp.h"
+#include "ofxAETessellationCache.h"
 
 namespace ofx { namespace ae {
 
@@ -67,7 +68,10 @@ class PathExtractionVisitor : public Visitor
 {
 public:
 	PathExtractionVisitor();
-	PathExtractionVisitor(const GroupData &group);
+	// Without tessellation the render items only carry their paths. TessellationCache is
+	// main thread only, so this is how the shapes are read elsewhere (see SoftwareRenderer).
+	explicit PathExtractionVisitor(bool tessellate);
+	PathExtractionVisitor(const GroupData &group, bool tessellate = true);
 	~PathExtractionVisitor()=default;
 	void visit(const EllipseData &ellipse) override;
 	void visit(const RectangleData &rectangle) override;
@@ -83,12 +87,15 @@ public:
 		virtual void draw(float alpha=1) const=0;
 	};
 	struct RenderPathItem : public RenderItem {
-		RenderPathItem(const ofPath &p):path(p) {
+		RenderPathItem(const ofPath &p, bool tessellate = true)
+		:path(p)
+		,tessellation(tessellate ? TessellationCache::getInstance().get(p) : nullptr) {
 		}
 		void draw(float alpha=1) const;
 		ofRectangle bounding_box;
 		ofRectangle getBB() const;
 		ofPath path;
+		std::shared_ptr<const TessellatedPath> tessellation;
 	};
 	struct RenderGroupItem : public RenderItem {
 		ofMatrix4x4 transform=ofMatrix4x4::newIdentityMatrix();
@@ -98,7 +105,6 @@ public:
 		ofRectangle getBB() const;
 
 		bool needFbo() const;
-		mutable ofFbo fbo;
 	};
 	const RenderGroupItem& getRenderer() const { return renderer_; }
 	const ofPath& getPath() const { return path_; }
@@ -108,6 +114,7 @@ private:
 	ofPath path_{};
 	ofRectangle bounding_box_;
 	RenderGroupItem renderer_;
+	bool is_tessellating_ = true;
 };
 
 class RenderItemExtractionVisitor : public Visitor
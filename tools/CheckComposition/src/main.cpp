@@ -0,0 +1,589 @@
+#include "ofMain.h"
+#include "ofxAEAssetManager.h"
+#include "ofxAEComposition.h"
+#include "ofxAECompressedTrack.h"
+#include "ofxAEEaseBatch.h"
+#include "ofxAEExporter.h"
+#include "ofxAEKeyframe.h"
+#include "ofxAELayer.h"
+#include "ofxAEPixelReader.h"
+#include "ofxAEShapeSource.h"
+#include "ofxAESoftwareRenderer.h"
+#include <atomic>
+#include <new>
+
+// Usage: CheckComposition <composition.json|.aec> [options]
+// Correctness checks for the optimized paths that example-benchmark only measures: prints one line
+// per check and exits with 1 if any of them fails, so that it can run in CI.
+// Runs without a window or GL context, unless --gl is given.
+//========================================================================
+
+// Heap allocations made while counting_allocations is set, for checkShapeAllocations().
+static std::atomic<bool> counting_allocations{false};
+static std::atomic<size_t> allocation_count{0};
+
+void* operator new(std::size_t size)
+{
+	if(counting_allocations) {
+		allocation_count++;
+	}
+	if(void *ptr = std::malloc(size ? size : 1)) {
+		return ptr;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+namespace {
+void printUsage(const char *name)
+{
+	std::cerr << "usage: " << name << " <composition.json|.aec> [options]" << std::endl
+	<< "  --golden DIR        compare SoftwareRenderer frames with the reference images in DIR" << std::endl
+	<< "  --write-golden DIR  write the reference images to DIR instead" << std::endl
+	<< "  --threshold N       per channel difference (0-255) still counted as equal (default 2)" << std::endl
+	<< "  --tolerance T       track compression tolerance to check JSON compositions with (default 0.001)" << std::endl
+	<< "  --gl                also render with GL in a hidden window and compare it with SoftwareRenderer" << std::endl
+	<< "  --gl-tolerance T    largest mean difference (0-255) allowed between GL and SoftwareRenderer (default 2)" << std::endl;
+}
+
+bool report(const std::string &check, bool passed, const std::string &detail)
+{
+	(passed ? std::cout : std::cerr) << (passed ? "ok   " : "FAIL ") << check << ": " << detail << std::endl;
+	return passed;
+}
+
+// The evaluated values of render items and of the items of nested compositions, flattened for comparison:
+// visibility, world matrix, opacity, source frame and masks, with the number of items and masks to keep the structure.
+void getItemState(const std::vector<ofx::ae::RenderItem> &items, std::vector<float> &dst)
+{
+	dst.push_back(items.size());
+	for(auto &&item : items) {
+		const float *world = item.world_matrix.getPtr();
+		dst.insert(dst.end(), world, world + 16);
+		dst.push_back(item.visible);
+		dst.push_back(item.opacity);
+		dst.push_back(item.source_frame);
+		dst.push_back(item.masks.size());
+		for(auto &&mask : item.masks) {
+			for(auto &&points : {&mask.shape.vertices, &mask.shape.inTangents, &mask.shape.outTangents}) {
+				dst.push_back(points->size());
+				for(auto &&p : *points) {
+					dst.push_back(p.x);
+					dst.push_back(p.y);
+				}
+			}
+			dst.insert(dst.end(), {mask.feather.x, mask.feather.y, mask.opacity, mask.offset,
+				float(mask.inverted), float(mask.mode)});
+		}
+		getItemState(item.children, dst);
+	}
+}
+
+bool isSameItems(const std::vector<ofx::ae::RenderItem> &a, const std::vector<ofx::ae::RenderItem> &b)
+{
+	std::vector<float> state_a, state_b;
+	getItemState(a, state_a);
+	getItemState(b, state_b);
+	return state_a.size() == state_b.size()
+	&& memcmp(state_a.data(), state_b.data(), state_a.size() * sizeof(float)) == 0;
+}
+
+bool load(const std::filesystem::path &src, ofx::ae::Composition &comp)
+{
+	return src.extension() == ".aec" ? comp.loadCompiled(src) : comp.load(src);
+}
+
+// Motion paths evaluated through ArcLengthTable must be at least as close to a dense reference
+// parameterization as the per-evaluation arc length solve they replace. Uses random curves, not the composition.
+bool checkArcLength()
+{
+	const int curve_count = 200;
+	const int steps = 100;
+	const int reference_samples = 100000;
+	ofSeedRandom(1);
+	float solve_error = 0, table_error = 0;
+	std::vector<double> lengths(reference_samples + 1);
+	for(int n = 0; n < curve_count; ++n) {
+		glm::vec2 a(ofRandom(-500, 500), ofRandom(-500, 500));
+		glm::vec2 b(ofRandom(-500, 500), ofRandom(-500, 500));
+		glm::vec2 out_tangent(ofRandom(-300, 300), ofRandom(-300, 300));
+		glm::vec2 in_tangent(ofRandom(-300, 300), ofRandom(-300, 300));
+		glm::vec2 p0 = a, p1 = a + out_tangent, p2 = b + in_tangent, p3 = b;
+		ofx::ae::interpolation::ArcLengthTable table;
+		table.build(p0, p1, p2, p3);
+		glm::vec2 prev = p0;
+		lengths[0] = 0;
+		for(int i = 1; i <= reference_samples; ++i) {
+			glm::vec2 p = ofx::ae::interpolation::evaluateBezier(p0, p1, p2, p3, i / float(reference_samples));
+			lengths[i] = lengths[i-1] + glm::length(p - prev);
+			prev = p;
+		}
+		for(int s = 1; s < steps; ++s) {
+			float ratio = s / float(steps);
+			double target = ratio * lengths.back();
+			size_t i = std::upper_bound(lengths.begin(), lengths.end(), target) - lengths.begin();
+			i = std::clamp<size_t>(i, 1, reference_samples);
+			double f = (target - lengths[i-1]) / std::max(1e-12, lengths[i] - lengths[i-1]);
+			glm::vec2 reference = ofx::ae::interpolation::evaluateBezier(p0, p1, p2, p3, float((i - 1 + f) / reference_samples));
+			auto solved = ofx::ae::interpolation::spatialBezierLinearTime(a, b, out_tangent, in_tangent, ratio);
+			auto looked_up = ofx::ae::interpolation::spatialBezierLinearTime(a, b, out_tangent, in_tangent, ratio, table);
+			solve_error = std::max(solve_error, glm::length(solved - reference));
+			table_error = std::max(table_error, glm::length(looked_up - reference));
+		}
+	}
+	return report("arc length table", table_error <= solve_error, "max error " + ofToString(table_error)
+				  + " px, per-evaluation solve " + ofToString(solve_error) + " px");
+}
+
+// Parallel evaluation (Composition::setParallelEvaluation()) must produce render lists bit-identical to serial evaluation,
+// including nested compositions. Both play a freshly loaded composition from the first frame, as layers outside
+// their range keep their last state.
+bool checkParallelEvaluation(const std::filesystem::path &src)
+{
+	ofx::ae::Composition serial, parallel;
+	if(!load(src, serial) || !load(src, parallel)) {
+		return report("parallel evaluation", false, "failed to load " + src.string());
+	}
+	parallel.setParallelEvaluation(true);
+	int frames = std::max<int>(1, serial.getFrameCount());
+	int mismatches = 0;
+	ofx::ae::RenderList expected, actual;
+	for(int i = 0; i < frames; ++i) {
+		serial.evaluate(i, expected);
+		parallel.evaluate(i, actual);
+		if(!isSameItems(expected.items, actual.items)) {
+			++mismatches;
+		}
+	}
+	return report("parallel evaluation", mismatches == 0, ofToString(mismatches) + " of " + ofToString(frames) + " frames differ from serial");
+}
+
+// Largest difference of two states from getItemState(), relative to the magnitude of the values (at least 1).
+float getRelativeDifference(const std::vector<float> &a, const std::vector<float> &b)
+{
+	if(a.size() != b.size()) {
+		return std::numeric_limits<float>::infinity();
+	}
+	float ret = 0;
+	for(size_t i = 0; i < a.size(); ++i) {
+		if(std::isnan(a[i]) != std::isnan(b[i])) {
+			return std::numeric_limits<float>::infinity();
+		}
+		if(a[i] != b[i]) {
+			ret = std::max(ret, std::abs(a[i] - b[i]) / std::max({1.f, std::abs(a[i]), std::abs(b[i])}));
+		}
+	}
+	return ret;
+}
+
+// The SIMD batch of interpolation::solveForX() must match the scalar one over random segments, and
+// batched easing (Composition::setBatchedEasing()) must produce the render lists of solving each property on its own.
+// Both may differ only where the compiler fuses multiply-adds in the scalar code, which changes the last bits.
+bool checkEaseBatch(const std::filesystem::path &src)
+{
+	const size_t count = 100000;
+	const float max_solve_difference = 1e-5f;
+	const float max_layer_difference = 1e-4f;
+	ofSeedRandom(1);
+	std::vector<float> x(count), p1x(count), p2x(count), batched(count);
+	for(size_t i = 0; i < count; ++i) {
+		x[i] = ofRandomuf();
+		p1x[i] = ofRandomuf();
+		p2x[i] = 1.f - ofRandomuf();
+	}
+	ofx::ae::interpolation::solveForX(x.data(), p1x.data(), p2x.data(), batched.data(), count);
+	float solve_difference = 0;
+	for(size_t i = 0; i < count; ++i) {
+		solve_difference = std::max(solve_difference, std::abs(ofx::ae::interpolation::solveForX(x[i], p1x[i], p2x[i]) - batched[i]));
+	}
+
+	ofx::ae::Composition comp, batched_comp;
+	if(!load(src, comp) || !load(src, batched_comp)) {
+		return report("ease batch", false, "failed to load " + src.string());
+	}
+	batched_comp.setBatchedEasing(true);
+	int frames = std::max<int>(1, comp.getFrameCount());
+	float layer_difference = 0;
+	ofx::ae::RenderList expected, actual;
+	for(int i = 0; i < frames; ++i) {
+		comp.evaluate(i, expected);
+		batched_comp.evaluate(i, actual);
+		std::vector<float> expected_state, actual_state;
+		getItemState(expected.items, expected_state);
+		getItemState(actual.items, actual_state);
+		layer_difference = std::max(layer_difference, getRelativeDifference(expected_state, actual_state));
+	}
+	return report("ease batch", solve_difference <= max_solve_difference && layer_difference <= max_layer_difference,
+				  std::string(ofx::ae::interpolation::getSolveForXInstructionSet()) + ", max difference " + ofToString(solve_difference)
+				  + " to solveForX(), " + ofToString(layer_difference) + " (relative) in render lists");
+}
+
+// Instances (Composition::instantiate()) share keyframes and assets but must evaluate on their own:
+// each of them, played at a different frame, must produce the render list of a freshly loaded composition.
+bool checkInstances(const std::filesystem::path &src)
+{
+	const int instances = 8;
+	auto prototype = std::make_shared<ofx::ae::Composition>();
+	ofx::ae::Composition fresh;
+	if(!load(src, *prototype) || !load(src, fresh)) {
+		return report("instances", false, "failed to load " + src.string());
+	}
+	std::vector<std::shared_ptr<ofx::ae::Composition>> comps;
+	for(int i = 0; i < instances; ++i) {
+		comps.push_back(prototype->instantiate());
+	}
+	int frames = std::max<int>(1, fresh.getFrameCount());
+	int mismatches = 0;
+	ofx::ae::RenderList expected, actual;
+	for(int i = 0; i < frames; ++i) {
+		for(int j = 0; j < instances; ++j) {
+			int frame = (i + j) % frames;
+			fresh.evaluate(frame, expected);
+			comps[j]->evaluate(frame, actual);
+			if(!isSameItems(expected.items, actual.items)) {
+				++mismatches;
+			}
+		}
+	}
+	return report("instances", mismatches == 0, ofToString(mismatches) + " of " + ofToString(frames * instances)
+				  + " instance frames differ from a fresh load");
+}
+
+// Compressed tracks (TrackCompression) must stay within tolerance * value range of the uncompressed values,
+// per component and on every frame. Each track is decoded here and compared with the values it was built from;
+// the range of each component is taken from those values, so constant components must decode exactly.
+// Needs a JSON composition: compiled ones no longer have the uncompressed values.
+bool checkTrackCompression(const std::filesystem::path &src, float tolerance)
+{
+	if(src.extension() == ".aec") {
+		std::cout << "skip track compression: needs the JSON composition" << std::endl;
+		return true;
+	}
+	ofx::ae::TrackCompression::setTolerance(tolerance);
+	ofx::ae::BakedTrackStats::setKeepSourceValues(true);
+	ofx::ae::Composition comp;
+	bool loaded = load(src, comp);
+	ofx::ae::BakedTrackStats::setKeepSourceValues(false);
+	ofx::ae::TrackCompression::setTolerance(0);
+	if(!loaded) {
+		return report("track compression", false, "failed to load " + src.string());
+	}
+	auto &tracks = comp.getBakedStats().compressed;
+	size_t over = 0;
+	std::string worst;
+	float worst_ratio = 0;
+	std::vector<float> decoded;
+	for(auto &&track : tracks) {
+		const int components = track.components;
+		const auto &values = track.source_values;
+		if(components == 0 || values.size() != track.frames * components) {
+			++over;
+			continue;
+		}
+		std::vector<float> bounds(components);
+		for(int c = 0; c < components; ++c) {
+			float lo = values[c], hi = values[c];
+			for(size_t i = c; i < values.size(); i += components) {
+				lo = std::min(lo, values[i]);
+				hi = std::max(hi, values[i]);
+			}
+			bounds[c] = tolerance * (hi - lo);
+		}
+		decoded.resize(components);
+		float ratio = 0;
+		for(size_t i = 0; i < track.frames; ++i) {
+			track.decode(track.first_frame + static_cast<int>(i), decoded.data());
+			for(int c = 0; c < components; ++c) {
+				float value = values[i * components + c];
+				// room for float rounding when dequantizing, relative to the bound and to the value itself
+				float allowed = bounds[c] * 1.0001f + 4 * std::numeric_limits<float>::epsilon() * std::abs(value);
+				float error = std::abs(decoded[c] - value);
+				if(error > 0) {
+					ratio = std::max(ratio, allowed > 0 ? error / allowed : std::numeric_limits<float>::infinity());
+				}
+			}
+		}
+		if(ratio > 1) {
+			++over;
+		}
+		if(ratio >= worst_ratio) {
+			worst_ratio = ratio;
+			worst = track.name;
+		}
+	}
+	return report("track compression", over == 0, ofToString(over) + " of " + ofToString(tracks.size())
+				  + " compressed tracks over tolerance * range of a component" + (worst.empty() ? "" : ", largest " + worst + " at " + ofToString(worst_ratio * 100) + "% of it"));
+}
+
+// After one warm-up loop, setFrame() and extraction into a ShapeData kept across frames must not allocate
+// for any shape layer: animated paths and shape nodes reuse their buffers.
+bool checkShapeAllocations(ofx::ae::Composition &comp)
+{
+	std::vector<ofx::ae::ShapeSource*> sources;
+	for(auto &&layer : comp.getLayers()) {
+		if(auto source = layer->getSource<ofx::ae::ShapeSource>()) {
+			sources.push_back(source);
+		}
+	}
+	std::vector<ofx::ae::ShapeData> data(sources.size());
+	int frames = std::max<int>(1, comp.getFrameCount());
+	auto evaluate = [&](int frame) {
+		for(size_t i = 0; i < sources.size(); ++i) {
+			sources[i]->setFrame(frame);
+			sources[i]->tryExtract(data[i]);
+		}
+	};
+	for(int i = 0; i < frames; ++i) {
+		evaluate(i);
+	}
+	allocation_count = 0;
+	counting_allocations = true;
+	for(int i = 0; i < frames; ++i) {
+		evaluate(i);
+	}
+	counting_allocations = false;
+	size_t allocations = allocation_count;
+	return report("shape allocations", allocations == 0, ofToString(allocations) + " allocations in " + ofToString(frames)
+				  + " frames of " + ofToString(sources.size()) + " shape layers");
+}
+
+// SoftwareRenderer must produce the same pixels in parallel tiles as on one thread.
+bool checkTiledRendering(ofx::ae::Composition &comp)
+{
+	ofx::ae::SoftwareRenderer::Settings serial_settings;
+	serial_settings.use_threads = false;
+	ofx::ae::SoftwareRenderer serial(serial_settings), tiled;
+	int frames = std::max<int>(1, comp.getFrameCount());
+	int mismatches = 0;
+	for(int i = 0; i < frames; ++i) {
+		ofPixels expected, actual;
+		serial.render(comp, i, expected);
+		tiled.render(comp, i, actual);
+		if(!ofx::ae::SoftwareRenderer::compare(expected, actual).isEqual()) {
+			++mismatches;
+		}
+	}
+	return report("tiled rendering", mismatches == 0, ofToString(mismatches) + " of " + ofToString(frames) + " frames differ from one thread");
+}
+
+// Every frame rendered by SoftwareRenderer must match the reference image written by --write-golden,
+// up to threshold per channel. Catches changes in what the composition renders to.
+bool checkGolden(ofx::ae::Composition &comp, const std::filesystem::path &directory, int threshold)
+{
+	ofx::ae::Exporter::Settings settings;
+	settings.directory = directory;
+	ofx::ae::Exporter golden(settings);
+	ofx::ae::SoftwareRenderer renderer;
+	int frames = std::max<int>(1, comp.getFrameCount());
+	int mismatches = 0;
+	int max_difference = 0;
+	for(int i = 0; i < frames; ++i) {
+		ofPixels expected, actual;
+		if(!ofLoadImage(expected, golden.getFramePath(i))) {
+			return report("golden images", false, "failed to load " + golden.getFramePath(i).string());
+		}
+		renderer.render(comp, i, actual);
+		auto difference = ofx::ae::SoftwareRenderer::compare(actual, expected, threshold);
+		if(!difference.isEqual()) {
+			++mismatches;
+		}
+		max_difference = std::max(max_difference, difference.is_size_equal ? difference.max_difference : 255);
+	}
+	return report("golden images", mismatches == 0, ofToString(mismatches) + " of " + ofToString(frames)
+				  + " frames differ from " + directory.string() + ", max difference " + ofToString(max_difference));
+}
+
+// setFrame(), update() and draw() into fbo, which is allocated at the size of comp on first use.
+void drawFrame(ofx::ae::Composition &comp, int frame, ofFbo &fbo)
+{
+	if(!fbo.isAllocated()) {
+		fbo.allocate(std::max(1.f, comp.getWidth()), std::max(1.f, comp.getHeight()), GL_RGBA);
+	}
+	comp.setFrame(frame);
+	comp.update();
+	fbo.begin();
+	ofClear(0,0);
+	comp.draw(0,0);
+	fbo.end();
+}
+
+// Batched drawing (Composition::setBatchedDrawing()) must produce the same pixels as drawing layer by layer.
+bool checkBatchedDrawing(ofx::ae::Composition &comp)
+{
+	int frames = std::max<int>(1, comp.getFrameCount());
+	ofFbo fbo;
+	int mismatches = 0;
+	for(int i = 0; i < frames; ++i) {
+		ofPixels direct, batched;
+		comp.setBatchedDrawing(false);
+		drawFrame(comp, i, fbo);
+		fbo.readToPixels(direct);
+		comp.setBatchedDrawing(true);
+		drawFrame(comp, i, fbo);
+		fbo.readToPixels(batched);
+		if(direct.size() != batched.size()
+		   || memcmp(direct.getData(), batched.getData(), direct.size()) != 0) {
+			++mismatches;
+		}
+	}
+	comp.setBatchedDrawing(false);
+	return report("batched drawing", mismatches == 0, ofToString(mismatches) + " of " + ofToString(frames) + " frames differ from direct drawing");
+}
+
+// PixelReader's pixels must be those of the frame it reports being behind by, as read with readToPixels().
+// Fails as well if no readback ever completes.
+bool checkReadback(ofx::ae::Composition &comp)
+{
+	int frames = std::max<int>(1, comp.getFrameCount());
+	ofFbo fbo;
+	std::vector<ofPixels> expected(frames);
+	for(int i = 0; i < frames; ++i) {
+		drawFrame(comp, i, fbo);
+		fbo.readToPixels(expected[i]);
+	}
+	ofx::ae::PixelReader reader;
+	int compared = 0;
+	int mismatches = 0;
+	for(int i = 0; i < frames; ++i) {
+		drawFrame(comp, i, fbo);
+		reader.readback(fbo, OF_PIXELS_RGBA);
+		int frame = i - static_cast<int>(reader.getStats().frames_behind);
+		auto &pixels = reader.getPixels();
+		if(!pixels.isAllocated() || frame < 0) {
+			continue;
+		}
+		++compared;
+		if(pixels.size() != expected[frame].size()
+		   || memcmp(pixels.getData(), expected[frame].getData(), pixels.size()) != 0) {
+			++mismatches;
+		}
+	}
+	return report("pbo readback", compared > 0 && mismatches == 0, ofToString(mismatches) + " of " + ofToString(compared)
+				  + " readbacks differ from readToPixels()");
+}
+
+// The GL renderer (Composition::draw()) and SoftwareRenderer must agree within tolerance on every frame.
+// They antialias edges differently, so the mean difference is bounded instead of requiring equal pixels.
+// This covers the shaders of the GL path (track mattes, masks, blend modes) against the CPU implementation.
+bool checkGLRenderer(ofx::ae::Composition &comp, double tolerance)
+{
+	int frames = std::max<int>(1, comp.getFrameCount());
+	ofFbo fbo;
+	ofx::ae::SoftwareRenderer renderer;
+	int mismatches = 0;
+	double max_mean_difference = 0;
+	for(int i = 0; i < frames; ++i) {
+		ofPixels gl_pixels, software_pixels;
+		drawFrame(comp, i, fbo);
+		fbo.readToPixels(gl_pixels);
+		renderer.render(comp, i, software_pixels);
+		auto difference = ofx::ae::SoftwareRenderer::compare(gl_pixels, software_pixels);
+		if(!difference.is_size_equal || difference.mean_difference > tolerance) {
+			++mismatches;
+		}
+		max_mean_difference = std::max(max_mean_difference, difference.is_size_equal ? difference.mean_difference : 255.);
+	}
+	return report("gl vs. software", mismatches == 0, ofToString(mismatches) + " of " + ofToString(frames)
+				  + " frames over tolerance " + ofToString(tolerance) + ", max mean difference " + ofToString(max_mean_difference));
+}
+}
+
+int main(int argc, char *argv[])
+{
+	if(argc < 2) {
+		printUsage(argv[0]);
+		return 1;
+	}
+	std::filesystem::path src = std::filesystem::absolute(argv[1]);
+	std::filesystem::path golden, write_golden;
+	int threshold = 2;
+	float tolerance = 0.001f;
+	bool use_gl = false;
+	double gl_tolerance = 2;
+	for(int i = 2; i < argc; ++i) {
+		std::string arg = argv[i];
+		bool has_value = i + 1 < argc;
+		if(arg == "--golden" && has_value) {
+			golden = std::filesystem::absolute(argv[++i]);
+		}
+		else if(arg == "--write-golden" && has_value) {
+			write_golden = std::filesystem::absolute(argv[++i]);
+		}
+		else if(arg == "--threshold" && has_value) {
+			threshold = ofClamp(ofToInt(argv[++i]), 0, 255);
+		}
+		else if(arg == "--tolerance" && has_value) {
+			tolerance = ofToFloat(argv[++i]);
+		}
+		else if(arg == "--gl") {
+			use_gl = true;
+		}
+		else if(arg == "--gl-tolerance" && has_value) {
+			gl_tolerance = ofToDouble(argv[++i]);
+		}
+		else {
+			printUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	std::shared_ptr<ofAppBaseWindow> window;
+	if(use_gl) {
+		// a context for Composition::draw(); nothing is shown
+		ofGLFWWindowSettings settings;
+		settings.setGLVersion(3, 2);
+		settings.setSize(64, 64);
+		settings.visible = false;
+		window = ofCreateWindow(settings);
+	}
+	else {
+		// there is no GL context; decode images to pixels only
+		ofx::ae::AssetManager::getInstance().setUploadEnabled(false);
+	}
+	ofx::ae::Composition comp;
+	if(!load(src, comp)) {
+		std::cerr << "failed to load " << src << std::endl;
+		return 1;
+	}
+
+	int failures = 0;
+	failures += !checkArcLength();
+	failures += !checkParallelEvaluation(src);
+	failures += !checkInstances(src);
+	failures += !checkTrackCompression(src, tolerance);
+	failures += !checkEaseBatch(src);
+	failures += !checkShapeAllocations(comp);
+	failures += !checkTiledRendering(comp);
+	if(!write_golden.empty()) {
+		ofx::ae::Exporter::Settings settings;
+		settings.directory = write_golden;
+		ofx::ae::Exporter exporter(settings);
+		if(!exporter.run(comp)) {
+			std::cerr << "failed to write reference images to " << write_golden << std::endl;
+			return 1;
+		}
+		std::cout << "wrote " << exporter.getStats().frames << " reference images to " << write_golden.string() << std::endl;
+	}
+	else if(!golden.empty()) {
+		failures += !checkGolden(comp, golden, threshold);
+	}
+	if(use_gl) {
+		failures += !checkGLRenderer(comp, gl_tolerance);
+		failures += !checkBatchedDrawing(comp);
+		failures += !checkReadback(comp);
+	}
+	if(failures > 0) {
+		std::cerr << failures << " checks failed" << std::endl;
+		return 1;
+	}
+	return 0;
+}
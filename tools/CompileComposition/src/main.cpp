@@ -0,0 +1,35 @@
+#include "ofMain.h"
+#include "ofxAECompiler.h"
+#include "ofxAECompressedTrack.h"
+
+// Usage: CompileComposition <composition.json> [output.aec] [--tolerance T]
+// Compiles an exported composition (and the compositions nested in it) into one binary file
+// that can be loaded with ofx::ae::Composition::loadCompiled().
+// With --tolerance, full frame animation is stored compressed; see ofx::ae::TrackCompression.
+//========================================================================
+int main(int argc, char *argv[])
+{
+	if(argc < 2) {
+		std::cerr << "usage: " << argv[0] << " <composition.json> [output.aec] [--tolerance T]" << std::endl;
+		return 1;
+	}
+	std::filesystem::path src = std::filesystem::absolute(argv[1]);
+	std::filesystem::path dst = std::filesystem::path(src).replace_extension(".aec");
+	for(int i = 2; i < argc; ++i) {
+		std::string arg = argv[i];
+		if(arg == "--tolerance" && i + 1 < argc) {
+			ofx::ae::TrackCompression::setTolerance(ofToFloat(argv[++i]));
+		}
+		else {
+			dst = std::filesystem::absolute(arg);
+		}
+	}
+
+	ofx::ae::Compiler::Stats stats;
+	if(!ofx::ae::Compiler::compile(src, dst, stats)) {
+		std::cerr << "failed to compile " << src << std::endl;
+		return 1;
+	}
+	std::cout << dst.string() << ": " << stats.compositions << " compositions, " << stats.layers << " layers, " << stats.bytes << " bytes" << std::endl;
+	return 0;
+}
@@ -0,0 +1,86 @@
+#include "ofMain.h"
+#include "ofxAEAssetManager.h"
+#include "ofxAEComposition.h"
+#include "ofxAEExporter.h"
+
+// Usage: ExportFrames <composition.json|.aec> <output directory> [options]
+// Renders a frame range of a composition to numbered PNG or raw RGBA files on the CPU,
+// without a window or GL context. See ofx::ae::Exporter.
+//========================================================================
+namespace {
+void printUsage(const char *name)
+{
+	std::cerr << "usage: " << name << " <composition.json|.aec> <output directory> [options]" << std::endl
+	<< "  --from N         first frame (default 0)" << std::endl
+	<< "  --to N           last frame, inclusive (default: last frame of the composition)" << std::endl
+	<< "  --size WxH       output size (default: composition size)" << std::endl
+	<< "  --raw            write raw RGBA (.rgba) instead of PNG" << std::endl
+	<< "  --prefix NAME    file name prefix (default frame_)" << std::endl
+	<< "  --encoders N     encoder threads (default 1)" << std::endl;
+}
+}
+
+int main(int argc, char *argv[])
+{
+	if(argc < 3) {
+		printUsage(argv[0]);
+		return 1;
+	}
+	std::filesystem::path src = std::filesystem::absolute(argv[1]);
+	ofx::ae::Exporter::Settings settings;
+	settings.directory = std::filesystem::absolute(argv[2]);
+	for(int i = 3; i < argc; ++i) {
+		std::string arg = argv[i];
+		bool has_value = i + 1 < argc;
+		if(arg == "--from" && has_value) {
+			settings.first_frame = ofToInt(argv[++i]);
+		}
+		else if(arg == "--to" && has_value) {
+			settings.last_frame = ofToInt(argv[++i]);
+		}
+		else if(arg == "--size" && has_value) {
+			auto size = ofSplitString(argv[++i], "x");
+			if(size.size() != 2) {
+				printUsage(argv[0]);
+				return 1;
+			}
+			settings.width = ofToInt(size[0]);
+			settings.height = ofToInt(size[1]);
+		}
+		else if(arg == "--raw") {
+			settings.format = ofx::ae::Exporter::Format::RAW;
+		}
+		else if(arg == "--prefix" && has_value) {
+			settings.prefix = argv[++i];
+		}
+		else if(arg == "--encoders" && has_value) {
+			settings.encode_threads = std::max(1, ofToInt(argv[++i]));
+		}
+		else {
+			printUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	// there is no GL context; decode images to pixels only
+	ofx::ae::AssetManager::getInstance().setUploadEnabled(false);
+	ofx::ae::Composition comp;
+	bool loaded = src.extension() == ".aec" ? comp.loadCompiled(src) : comp.load(src);
+	if(!loaded) {
+		std::cerr << "failed to load " << src << std::endl;
+		return 1;
+	}
+
+	ofx::ae::Exporter exporter(settings);
+	bool succeeded = exporter.run(comp);
+	auto &stats = exporter.getStats();
+	std::cout << settings.directory.string() << ": " << stats.frames << " frames, " << stats.bytes << " bytes, "
+	<< stats.getFramesPerSecond() << " fps" << std::endl
+	<< "  evaluate " << stats.evaluate_millis << " ms, render " << stats.render_millis << " ms, encode "
+	<< stats.encode_millis << " ms, total " << stats.total_millis << " ms" << std::endl;
+	if(!succeeded) {
+		std::cerr << stats.failed_frames << " frames failed" << std::endl;
+		return 1;
+	}
+	return 0;
+}